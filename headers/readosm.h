@@ -77,6 +77,8 @@ extern "C"
 /* constants */
 /** information is not available */
 #define READOSM_UNDEFINED	-1234567890
+/** fixed-point coordinate is not available (INT_MIN, never a valid value) */
+#define READOSM_UNDEFINED_FIXED	(-2147483647 - 1)
 /** MemberType: NODE */
 #define READOSM_MEMBER_NODE	7361
 /** MemberType: WAY */
@@ -84,6 +86,25 @@ extern "C"
 /** MemberType: RELATION */
 #define READOSM_MEMBER_RELATION 3671
 
+/* Open options */
+#define READOSM_MMAP			0x01 /**< memory-map the whole input
+						file instead of reading it
+						block by block */
+#define READOSM_SKIP_METADATA		0x02 /**< don't decode version,
+						timestamp, changeset, uid
+						and user */
+#define READOSM_LAZY_TIMESTAMPS		0x04 /**< don't format timestamp
+						strings: only timestamp_epoch
+						will be set */
+
+/** buffer size required by readosm_format_timestamp() */
+#define READOSM_TIMESTAMP_SIZE		21
+
+/* Block index object types */
+#define READOSM_BLOCK_NODES		0x01 /**< the block contains NODEs */
+#define READOSM_BLOCK_WAYS		0x02 /**< the block contains WAYs */
+#define READOSM_BLOCK_RELATIONS		0x04 /**< the block contains RELATIONs */
+
 /* Error codes */
 #define READOSM_OK			0 /**< No error, success */
 #define READOSM_INVALID_SUFFIX		-1 /**< not .osm or .pbf suffix */
@@ -99,6 +120,13 @@ extern "C"
 #define READOSM_INVALID_PBF_HEADER	-9 /**< invalid PBF header */
 #define READOSM_UNZIP_ERROR		-10 /**< unZip error */
 #define READOSM_ABORT			-11 /**< user-required parser abort */
+#define READOSM_WRITE_ERROR		-12 /**< write error */
+#define READOSM_UNSUPPORTED_BLOB	-13 /**< PBF block compression not
+						supported by this build */
+#define READOSM_ZSTD_ERROR		-14 /**< zstd decompression error */
+#define READOSM_LZ4_ERROR		-15 /**< lz4 decompression error */
+#define READOSM_INVALID_TIMESTAMP	-16 /**< undefined or out of range
+						timestamp */
 
 	/**
 	 a struct representing a <b>key:value</b> pair, and wrapping an XML fragment like the following:
@@ -141,6 +169,9 @@ extern "C"
 	const char *timestamp; /**< when this NODE was defined */
 	const int tag_count; /**< number of associated TAGs (may be zero) */
 	const readosm_tag *tags; /**< array of TAG objects (may be NULL) */
+	const long long timestamp_epoch; /**< when this NODE was defined (seconds since the epoch), or READOSM_UNDEFINED */
+	const int fixed_latitude; /**< geographic latitude as a fixed-point value, in units of 100 nanodegrees (1e-7 degrees), or READOSM_UNDEFINED_FIXED */
+	const int fixed_longitude; /**< geographic longitude as a fixed-point value, in units of 100 nanodegrees (1e-7 degrees), or READOSM_UNDEFINED_FIXED */
     };
 
 	/**
@@ -174,6 +205,7 @@ extern "C"
 	const long long *node_refs; /**< array of NODE-IDs (may be NULL) */
 	const int tag_count; /**< number of associated TAGs (may be zero) */
 	const readosm_tag *tags; /**< array of TAG objects (may be NULL) */
+	const long long timestamp_epoch; /**< when this WAY was defined (seconds since the epoch), or READOSM_UNDEFINED */
     };
 
 	/**
@@ -228,6 +260,7 @@ extern "C"
 	const readosm_member *members; /**< array of MEMBER objects (may be NULL) */
 	const int tag_count; /**< number of associated TAGs (may be zero) */
 	const readosm_tag *tags; /**< array of TAG objects (may be NULL) */
+	const long long timestamp_epoch; /**< when this RELATION was defined (seconds since the epoch), or READOSM_UNDEFINED */
     };
 
 	/**
@@ -237,6 +270,84 @@ extern "C"
      */
     typedef struct readosm_relation_struct readosm_relation;
 
+	/**
+	 a struct representing a whole batch of NODE objects in columnar
+	 (struct-of-arrays) form: each array contains COUNT items, and
+	 the I-th NODE is described by the I-th item of each array.
+
+	 The layout follows the Apache Arrow conventions for fixed-width
+	 and list columns: TAG_OFFSETS contains COUNT + 1 monotonically
+	 increasing values starting at zero, and the TAGs of the I-th NODE
+	 are TAGS[TAG_OFFSETS[I]] up to TAGS[TAG_OFFSETS[I + 1] - 1].
+	 */
+    struct readosm_node_columns_struct
+    {
+	const int count; /**< number of NODEs in the batch */
+	const long long *ids; /**< array of NODE-IDs */
+	const int *fixed_latitudes; /**< array of latitudes as fixed-point values, in units of 100 nanodegrees (1e-7 degrees), or READOSM_UNDEFINED_FIXED */
+	const int *fixed_longitudes; /**< array of longitudes as fixed-point values, in units of 100 nanodegrees (1e-7 degrees), or READOSM_UNDEFINED_FIXED */
+	const int *tag_offsets; /**< array of COUNT + 1 offsets into TAGS */
+	const readosm_tag *tags; /**< array of TAG objects (may be NULL if no NODE has TAGs) */
+    };
+
+	/**
+     Typedef for NODE-COLUMNS structure.
+     
+     \sa readosm_node_columns_struct
+     */
+    typedef struct readosm_node_columns_struct readosm_node_columns;
+
+	/**
+	 a struct representing the HeaderBlock of a .pbf file
+	 */
+    struct readosm_header_struct
+    {
+	const int has_bbox; /**< 1 if the bounding box is declared, otherwise 0 */
+	const double min_longitude; /**< bounding box: left */
+	const double max_longitude; /**< bounding box: right */
+	const double min_latitude; /**< bounding box: bottom */
+	const double max_latitude; /**< bounding box: top */
+	const int required_feature_count; /**< number of required features (may be zero) */
+	const char **required_features;	/**< array of required features (e.g. "DenseNodes") */
+	const int optional_feature_count; /**< number of optional features (may be zero) */
+	const char **optional_features;	/**< array of optional features (e.g. "Sort.Type_then_ID") */
+	const char *writing_program; /**< the program that wrote the file (may be NULL) */
+	const char *source;	/**< the source of the data (may be NULL) */
+	const long long replication_timestamp; /**< replication timestamp (seconds since the epoch), or READOSM_UNDEFINED */
+	const long long replication_sequence; /**< replication sequence number, or READOSM_UNDEFINED */
+	const char *replication_base_url; /**< replication base URL (may be NULL) */
+	const int sorted; /**< 1 if "Sort.Type_then_ID" is declared, otherwise 0 */
+	const int locations_on_ways; /**< 1 if "LocationsOnWays" is declared, otherwise 0 */
+    };
+
+	/**
+     Typedef for HEADER structure.
+     
+     \sa readosm_header_struct
+     */
+    typedef struct readosm_header_struct readosm_header;
+
+	/**
+	 a struct representing a single OSMData block within a .pbf file
+	 (block index item)
+	 */
+    struct readosm_block_struct
+    {
+	const long long file_offset; /**< file offset of the block (i.e. of its leading BlobHeader size) */
+	const unsigned int header_size;	/**< BlobHeader size (in bytes) */
+	const unsigned int datasize; /**< Blob size (in bytes) */
+	const int object_types;	/**< bitmask of READOSM_BLOCK_xx object types (zero if unknown) */
+	const long long min_id;	/**< min object ID (only meaningful if object_types isn't zero) */
+	const long long max_id;	/**< max object ID (only meaningful if object_types isn't zero) */
+    };
+
+	/**
+     Typedef for BLOCK structure.
+     
+     \sa readosm_block_struct
+     */
+    typedef struct readosm_block_struct readosm_block;
+
 /** callback function handling NODE objects */
     typedef int (*readosm_node_callback) (const void *user_data,
 					  const readosm_node * node);
@@ -250,6 +361,36 @@ extern "C"
 					      const readosm_relation *
 					      relation);
 
+/** callback function handling a batch of NODE objects
+ (used by readosm_parse_batches) */
+    typedef int (*readosm_node_batch_callback) (const void *user_data,
+						const readosm_node * nodes,
+						int count);
+
+/** callback function handling a batch of WAY objects
+ (used by readosm_parse_batches) */
+    typedef int (*readosm_way_batch_callback) (const void *user_data,
+					       const readosm_way * ways,
+					       int count);
+
+/** callback function handling a batch of RELATION objects
+ (used by readosm_parse_batches) */
+    typedef int (*readosm_relation_batch_callback) (const void *user_data,
+						    const readosm_relation *
+						    relations, int count);
+
+/** callback function handling a batch of NODE objects in columnar form
+ (used by readosm_parse_columns) */
+    typedef int (*readosm_node_columns_callback) (const void *user_data,
+						  const readosm_node_columns *
+						  columns);
+
+/** callback function returning the user data for each worker thread
+ (used by readosm_parse_parallel) */
+    typedef const void *(*readosm_user_data_factory) (const void
+						      *factory_data,
+						      int thread_index);
+
     /**
      Open the .osm or .pbf file, preparing for future functions
      
@@ -266,6 +407,44 @@ extern "C"
     READOSM_DECLARE int readosm_open (const char *path,
 				      const void **osm_handle);
 
+    /**
+     Open the .osm or .pbf file, preparing for future functions
+     (extended version supporting open options)
+     
+     \param path full or relative pathname of the input file.
+     \param osm_handle an opaque reference (handle) to be used in each
+     subsequent function (return value).
+     \param options a bitwise combination of READOSM_xx open options
+     (e.g. READOSM_MMAP), or 0 for default behaviour.
+
+     \return READOSM_OK will be returned on success, otherwise any appropriate
+     error code on failure.
+
+     \note READOSM_MMAP requests to map the whole input file into memory,
+     so that any block will be directly parsed from the mapped pages
+     without copying it into private buffers; when memory-mapping isn't
+     supported by the current platform (or fails) the file will be
+     silently read in the usual way.
+
+     \note READOSM_SKIP_METADATA requests to ignore any Info/DenseInfo
+     block (PBF) and any metadata attribute (OSM XML): all NODE, WAY and
+     RELATION objects will then be returned exactly as objects lacking
+     any metadata, i.e. with NULL timestamp and user.
+
+     \note READOSM_LAZY_TIMESTAMPS requests to never set the timestamp
+     string of NODE, WAY and RELATION objects (it will be always NULL):
+     only the numeric timestamp_epoch will be set, and it could then be
+     formatted on demand by calling readosm_format_timestamp().
+
+     \note You are expected to readosm_close() even on failure, so as to
+     correctly release any dynamic memory allocation.
+     
+     \sa readosm_open
+     */
+    READOSM_DECLARE int readosm_open_ex (const char *path,
+					 const void **osm_handle,
+					 int options);
+
     /** 
      Close the .osm or .pbf file and release any allocated resource
 
@@ -303,6 +482,269 @@ extern "C"
 				       readosm_way_callback way_fnct,
 				       readosm_relation_callback relation_fnct);
 
+    /** 
+     Parse the .osm or .pbf file by using many concurrent threads
+
+    \param osm_handle the handle previously returned by readosm_open()
+	\param user_data pointer to some user-supplied data struct
+	\param node_fnct pointer to callback function intended to consume NODE objects 
+	(may be NULL if processing NODEs is not an interesting option)
+	\param way_fnct pointer to callback function intended to consume WAY objects 
+	(may be NULL if processing WAYs is not an interesting option)
+	\param relation_fnct pointer to callback function intended to consume RELATION objects 
+	(may be NULL if processing RELATIONs is not an interesting option)
+	\param threads how many worker threads should be used for decoding
+
+    \return READOSM_OK will be returned on success, otherwise any appropriate
+     error code on failure.
+    
+    \note .pbf blocks are read sequentially, then concurrently decompressed 
+    and decoded by a pool of worker threads; anyway all callback functions 
+    are always called by the calling thread, and objects are delivered 
+    exactly in the same order as readosm_parse() would do.
+    .osm files (and builds lacking thread support) will simply be parsed 
+    by a single thread.
+
+	\sa readosm_parse
+    */
+    READOSM_DECLARE int readosm_parse_mt (const void *osm_handle,
+					  const void *user_data,
+					  readosm_node_callback node_fnct,
+					  readosm_way_callback way_fnct,
+					  readosm_relation_callback
+					  relation_fnct, int threads);
+
+    /** 
+     Parse the .osm or .pbf file by using many concurrent threads
+     (unordered mode: callbacks are directly called by worker threads)
+
+    \param osm_handle the handle previously returned by readosm_open()
+	\param factory pointer to a function returning the user data to be
+	passed to the callbacks called by each worker thread (may be NULL,
+	in this case factory_data will be shared by all threads)
+	\param factory_data pointer to some user-supplied data struct, to be
+	passed to the factory function
+	\param node_fnct pointer to callback function intended to consume NODE objects 
+	(may be NULL if processing NODEs is not an interesting option)
+	\param way_fnct pointer to callback function intended to consume WAY objects 
+	(may be NULL if processing WAYs is not an interesting option)
+	\param relation_fnct pointer to callback function intended to consume RELATION objects 
+	(may be NULL if processing RELATIONs is not an interesting option)
+	\param threads how many worker threads should be used
+
+    \return READOSM_OK will be returned on success, otherwise any appropriate
+     error code on failure.
+    
+    \note the factory function is called exactly once for each worker thread
+    (thread_index ranging from 0 to threads - 1) by the calling thread, and
+    before any callback function is called; callback functions are then
+    concurrently called by the worker threads, each one receiving its own
+    user data. No order is guaranteed across objects belonging to different
+    .pbf blocks, objects belonging to the same block are delivered in
+    their original order by a single thread.
+    Any callback returning an error will stop all threads as soon as possible.
+    .osm files (and builds lacking thread support) will simply be parsed 
+    by a single thread using the user data for thread_index 0.
+
+	\sa readosm_parse_mt
+    */
+    READOSM_DECLARE int readosm_parse_parallel (const void *osm_handle,
+						readosm_user_data_factory
+						factory,
+						const void *factory_data,
+						readosm_node_callback
+						node_fnct,
+						readosm_way_callback way_fnct,
+						readosm_relation_callback
+						relation_fnct, int threads);
+
+    /** 
+     Parse the .osm or .pbf file, delivering arrays of objects
+
+    \param osm_handle the handle previously returned by readosm_open()
+	\param user_data pointer to some user-supplied data struct
+	\param node_fnct pointer to callback function intended to consume arrays
+	of NODE objects (may be NULL if processing NODEs is not an interesting option)
+	\param way_fnct pointer to callback function intended to consume arrays
+	of WAY objects (may be NULL if processing WAYs is not an interesting option)
+	\param relation_fnct pointer to callback function intended to consume arrays
+	of RELATION objects (may be NULL if processing RELATIONs is not an 
+	interesting option)
+
+    \return READOSM_OK will be returned on success, otherwise any appropriate
+     error code on failure.
+    
+    \note each callback receives a contiguous array of COUNT objects, in the
+    same order as readosm_parse() would deliver them one at a time: all WAYs
+    or RELATIONs belonging to the same .pbf PrimitiveGroup, or up to 1024
+    NODEs decoded from a DenseNodes group. The arrays (and any string, tag,
+    node-ref or member they point to) are only valid until the callback
+    returns. .osm files will simply deliver arrays containing a single object.
+
+	\sa readosm_parse
+    */
+    READOSM_DECLARE int readosm_parse_batches (const void *osm_handle,
+					       const void *user_data,
+					       readosm_node_batch_callback
+					       node_fnct,
+					       readosm_way_batch_callback
+					       way_fnct,
+					       readosm_relation_batch_callback
+					       relation_fnct);
+
+    /** 
+     Parse the .osm or .pbf file, delivering NODEs in columnar form
+
+    \param osm_handle the handle previously returned by readosm_open()
+	\param user_data pointer to some user-supplied data struct
+	\param node_fnct pointer to callback function intended to consume
+	columns of NODE objects (may be NULL if processing NODEs is not an
+	interesting option)
+	\param way_fnct pointer to callback function intended to consume arrays
+	of WAY objects (may be NULL if processing WAYs is not an interesting option)
+	\param relation_fnct pointer to callback function intended to consume arrays
+	of RELATION objects (may be NULL if processing RELATIONs is not an 
+	interesting option)
+
+    \return READOSM_OK will be returned on success, otherwise any appropriate
+     error code on failure.
+    
+    \note each .pbf DenseNodes group is delivered as a single batch, directly
+    exposing the decoded ID and coordinate arrays without reassembling
+    individual NODEs. No metadata (version, changeset, user, timestamp)
+    is available in columnar form. WAYs and RELATIONs are delivered exactly
+    as by readosm_parse_batches(). All arrays are only valid until the
+    callback returns. .osm files will simply deliver batches containing
+    a single NODE.
+
+	\sa readosm_parse_batches
+    */
+    READOSM_DECLARE int readosm_parse_columns (const void *osm_handle,
+					       const void *user_data,
+					       readosm_node_columns_callback
+					       node_fnct,
+					       readosm_way_batch_callback
+					       way_fnct,
+					       readosm_relation_batch_callback
+					       relation_fnct);
+
+    /** 
+     Return the HeaderBlock of a .pbf file
+
+    \param osm_handle the handle previously returned by readosm_open()
+	\param header on successful completion will point to the HEADER
+	object (return value)
+
+    \return READOSM_OK will be returned on success, otherwise any appropriate
+     error code on failure.
+    
+    \note the HeaderBlock is parsed by readosm_open(); the HEADER object 
+    belongs to the handle, and will be automatically released by readosm_close().
+    Calling this function on an .osm file (or on a .pbf file lacking a valid
+    HeaderBlock) will return READOSM_INVALID_PBF_HEADER.
+    */
+    READOSM_DECLARE int readosm_get_header (const void *osm_handle,
+					    const readosm_header ** header);
+
+    /** 
+     Build the index of all OSMData blocks contained into a .pbf file
+
+    \param osm_handle the handle previously returned by readosm_open()
+	\param blocks on successful completion will point to an array of
+	BLOCK objects, in file order (return value)
+	\param count on successful completion will contain the number of 
+	items in the BLOCK array (return value)
+
+    \return READOSM_OK will be returned on success, otherwise any appropriate
+     error code on failure.
+    
+    \note only the BlobHeaders are actually read, and any compressed Blob
+    will be simply skipped; so building the index is a really fast operation
+    even for huge files. The current read position is left unchanged.
+    The BLOCK array belongs to the handle, and will be automatically
+    released by readosm_close(); the leading OSMHeader block isn't indexed.
+    Object types and ID ranges are only available when the index has been
+    loaded from a sidecar file, or after calling readosm_write_block_index();
+    otherwise object_types will always be zero.
+    Calling this function on an .osm file will return READOSM_INVALID_PBF_HEADER.
+    */
+    READOSM_DECLARE int readosm_build_block_index (const void *osm_handle,
+						   const readosm_block **
+						   blocks, int *count);
+
+    /** 
+     Write the block index of a .pbf file into a sidecar file
+
+    \param osm_handle the handle previously returned by readosm_open()
+
+    \return READOSM_OK will be returned on success, otherwise any appropriate
+     error code on failure.
+    
+    \note the sidecar file will be named after the .pbf file, simply adding
+    an .idx suffix (e.g. planet.osm.pbf.idx). Each block will be decoded, so
+    to collect object types and ID ranges: this is a slow operation, but any
+    subsequent readosm_open() on the same file will silently load the sidecar
+    file (provided that the .pbf file size and modification time still match),
+    so that the block index will be immediately available at no cost.
+    The current read position is left unchanged.
+    Calling this function on an .osm file will return READOSM_INVALID_PBF_HEADER.
+
+	\sa readosm_build_block_index
+    */
+    READOSM_DECLARE int readosm_write_block_index (const void *osm_handle);
+
+    /** 
+     Parse a byte range of a .pbf file
+
+    \param osm_handle the handle previously returned by readosm_open()
+	\param start_offset file offset where the range begins
+	\param end_offset file offset where the range ends (not included);
+	a negative value stands for the end of the file
+	\param user_data pointer to some user-supplied data struct
+	\param node_fnct pointer to callback function intended to consume NODE objects 
+	(may be NULL if processing NODEs is not an interesting option)
+	\param way_fnct pointer to callback function intended to consume WAY objects 
+	(may be NULL if processing WAYs is not an interesting option)
+	\param relation_fnct pointer to callback function intended to consume RELATION objects 
+	(may be NULL if processing RELATIONs is not an interesting option)
+
+    \return READOSM_OK will be returned on success, otherwise any appropriate
+     error code on failure.
+    
+    \note only the OSMData blocks starting at or after start_offset, and before
+    end_offset, will be read and parsed; so splitting a file into many adjacent
+    ranges (e.g. one for each worker) every block will be parsed exactly once,
+    whatever the range boundaries are. Block boundaries are retrieved from the
+    block index, that will be built if not already available.
+    Calling this function on an .osm file will return READOSM_INVALID_PBF_HEADER.
+
+	\sa readosm_build_block_index
+    */
+    READOSM_DECLARE int readosm_parse_range (const void *osm_handle,
+					     long long start_offset,
+					     long long end_offset,
+					     const void *user_data,
+					     readosm_node_callback node_fnct,
+					     readosm_way_callback way_fnct,
+					     readosm_relation_callback
+					     relation_fnct);
+
+    /**
+     Format a timestamp as an ISO-8601 string
+
+     \param timestamp_epoch seconds since the epoch, as found in the
+     timestamp_epoch member of NODE, WAY and RELATION objects.
+     \param buffer pointer to a buffer of at least READOSM_TIMESTAMP_SIZE
+     bytes, receiving a NULL terminated string like "2005-02-28T17:45:15Z".
+
+     \return READOSM_OK will be returned on success, otherwise
+     READOSM_INVALID_TIMESTAMP if timestamp_epoch is READOSM_UNDEFINED or
+     falls outside the years 0000-9999 (BUFFER will then contain an
+     empty string).
+     */
+    READOSM_DECLARE int readosm_format_timestamp (long long timestamp_epoch,
+						  char *buffer);
+
     /**
      Return the current ReadOSM version
      
@@ -65,6 +65,38 @@
 /* block size */
 #define READOSM_BLOCK_SZ	128
 
+/* 64 bit file positioning */
+#if defined(_WIN32) && !defined(__MINGW32__)
+#define readosm_fseek	_fseeki64
+#define readosm_ftell	_ftelli64
+#else
+#define readosm_fseek	fseeko
+#define readosm_ftell	ftello
+#endif
+
+/* arena chunk size */
+#define READOSM_ARENA_SZ	65536
+
+typedef struct readosm_arena_chunk_struct
+{
+/* a memory chunk supporting the Arena allocator */
+    size_t size;		/* chunk capacity (in bytes) */
+    size_t used;		/* how many bytes are already allocated */
+    struct readosm_arena_chunk_struct *next;	/* supporting linked list */
+} readosm_arena_chunk;
+
+typedef struct readosm_arena_struct
+{
+/* 
+ / a bump-pointer Arena allocator
+ / any item allocated from the Arena will be released all at 
+ / once by reset_arena(); chunks are then recycled for reuse
+*/
+    readosm_arena_chunk *first;	/* pointers supporting a linked list */
+    readosm_arena_chunk *last;	/* of memory chunks */
+    readosm_arena_chunk *current;	/* chunk currently used for allocation */
+} readosm_arena;
+
 typedef struct readosm_internal_tag_struct
 {
 /* a struct wrapping TAG items */
@@ -93,11 +125,14 @@ typedef struct readosm_internal_node_struct
     long long id;		/* NODE-ID (unique value) */
     double latitude;		/* geographic latitude */
     double longitude;		/* geographic longitude */
+    int fixed_latitude;		/* latitude (units of 100 nanodegrees) */
+    int fixed_longitude;	/* longitude (units of 100 nanodegrees) */
     int version;		/* version id */
     long long changeset;	/* changeset id */
     char *user;			/* pointer to user name (NULL terminated string) */
     int uid;			/* uid identifying the user */
     char *timestamp;		/* last modified timestamp */
+    long long timestamp_epoch;	/* timestamp (seconds since the epoch) */
     int tag_count;		/* how many TAG items are there */
     readosm_internal_tag_block first_tag;	/* pointers supporting a linked list */
     readosm_internal_tag_block *last_tag;	/* of TAG blocks (first block is static) */
@@ -116,6 +151,9 @@ typedef struct readosm_export_node_struct
     char *timestamp;		/* last modified timestamp */
     int tag_count;		/* how many TAG items are there */
     readosm_export_tag *tags;	/* array of TAG items */
+    long long timestamp_epoch;	/* timestamp (seconds since the epoch) */
+    int fixed_latitude;		/* latitude (units of 100 nanodegrees) */
+    int fixed_longitude;	/* longitude (units of 100 nanodegrees) */
 } readosm_export_node;
 
 typedef struct readosm_internal_ref_struct
@@ -135,6 +173,7 @@ typedef struct readosm_internal_way_struct
     char *user;			/* pointer to user name (NULL terminated string) */
     int uid;			/* uid identifying the user */
     char *timestamp;		/* last modified timestamp */
+    long long timestamp_epoch;	/* timestamp (seconds since the epoch) */
     int ref_count;		/* how many WAY-ND items are there */
     readosm_internal_ref first_ref;	/* pointers supporting a linked list */
     readosm_internal_ref *last_ref;	/* of WAY-ND items (first block is static) */
@@ -156,6 +195,7 @@ typedef struct readosm_export_way_struct
     long long *node_refs;	/* array of WAY-ND items */
     int tag_count;		/* how many TAG items are there */
     readosm_export_tag *tags;	/* array of TAG items */
+    long long timestamp_epoch;	/* timestamp (seconds since the epoch) */
 } readosm_export_way;
 
 typedef struct readosm_internal_member_struct
@@ -191,6 +231,7 @@ typedef struct readosm_internal_relation_struct
     char *user;			/* pointer to user name (NULL terminated string) */
     int uid;			/* uid identifying the user */
     char *timestamp;		/* last modified timestamp */
+    long long timestamp_epoch;	/* timestamp (seconds since the epoch) */
     int member_count;		/* how many RELATION-MEMBER items are there */
     readosm_internal_member_block first_member;	/* pointers supporting a linked list */
     readosm_internal_member_block *last_member;	/* of RELATION-MEMBER items (first block is static) */
@@ -212,8 +253,52 @@ typedef struct readosm_export_relation_struct
     readosm_export_member *members;	/* array of RELATION-MEMBER items */
     int tag_count;		/* how many TAG items are there */
     readosm_export_tag *tags;	/* array of TAG items */
+    long long timestamp_epoch;	/* timestamp (seconds since the epoch) */
 } readosm_export_relation;
 
+typedef struct readosm_export_node_columns_struct
+{
+/* a struct intended to export NODE items in columnar form */
+    int count;			/* how many NODE items are there */
+    long long *ids;		/* array of NODE-IDs */
+    int *fixed_latitudes;	/* array of latitudes (100 nanodegrees) */
+    int *fixed_longitudes;	/* array of longitudes (100 nanodegrees) */
+    int *tag_offsets;		/* COUNT + 1 offsets into TAGS */
+    readosm_export_tag *tags;	/* array of TAG items */
+} readosm_export_node_columns;
+
+typedef struct readosm_export_block_struct
+{
+/* a struct intended to export PBF block index items */
+    long long file_offset;	/* file offset of the BlobHeader size */
+    unsigned int header_size;	/* BlobHeader size (in bytes) */
+    unsigned int datasize;	/* Blob size (in bytes) */
+    int object_types;		/* object types [bitmask of READOSM_BLOCK_xx] */
+    long long min_id;		/* min object ID */
+    long long max_id;		/* max object ID */
+} readosm_export_block;
+
+typedef struct readosm_export_header_struct
+{
+/* a struct intended to export the PBF HeaderBlock */
+    int has_bbox;		/* the bounding box is declared */
+    double min_longitude;	/* bounding box: left */
+    double max_longitude;	/* bounding box: right */
+    double min_latitude;	/* bounding box: bottom */
+    double max_latitude;	/* bounding box: top */
+    int required_feature_count;	/* how many required features are there */
+    char **required_features;	/* array of required features */
+    int optional_feature_count;	/* how many optional features are there */
+    char **optional_features;	/* array of optional features */
+    char *writing_program;	/* the program that wrote the file */
+    char *source;		/* the source of the data */
+    long long replication_timestamp;	/* replication timestamp (seconds since the epoch) */
+    long long replication_sequence;	/* replication sequence number */
+    char *replication_base_url;	/* replication base URL */
+    int sorted;			/* Sort.Type_then_ID is declared */
+    int locations_on_ways;	/* LocationsOnWays is declared */
+} readosm_export_header;
+
 typedef union readosm_endian4_union
 {
 /* a union used for 32 bit ints [cross-endian] */
@@ -238,42 +323,107 @@ typedef struct readosm_file_struct
 /* a struct representing an OSM input file */
     int magic1;			/* magic signature #1 */
     FILE *in;			/* file handle */
+    char *path;			/* file path */
+    unsigned char *map;		/* memory-mapped file contents (may be NULL) */
+    size_t map_size;		/* size (in bytes) of the mapped region */
+    size_t map_pos;		/* current read position into the mapped region */
     int file_format;		/* the actual file format */
+    int options;		/* READOSM_xx open options */
+    readosm_export_block *blocks;	/* PBF block index (may be NULL) */
+    int block_count;		/* how many indexed blocks are there */
+    int detailed_index;		/* object types and IDs are indexed too */
+    struct readosm_pbf_decoder_struct *decoder;	/* PBF decoder context (may be NULL) */
+    readosm_export_header *header;	/* PBF HeaderBlock (may be NULL) */
     char little_endian_cpu;	/* actual CPU endianness */
     int magic2;			/* magic signature #2 */
 } readosm_file;
 
-/* functions handling common OSM objects */
-READOSM_PRIVATE void release_internal_tag_block (readosm_internal_tag_block *
-						 tag_block, int destroy);
-READOSM_PRIVATE void
-release_internal_member_block (readosm_internal_member_block * member_block,
-			       int destroy);
-READOSM_PRIVATE void init_internal_node (readosm_internal_node * node);
+/* Arena allocator */
+READOSM_PRIVATE void init_arena (readosm_arena * arena);
+READOSM_PRIVATE void *arena_alloc (readosm_arena * arena, size_t size);
+READOSM_PRIVATE char *arena_strdup (readosm_arena * arena, const char *str);
+READOSM_PRIVATE void reset_arena (readosm_arena * arena);
+READOSM_PRIVATE void finalize_arena (readosm_arena * arena);
+
+/* 
+ / functions handling common OSM objects
+ / strings (Tag keys and values, Member roles) are simply referenced,
+ / and any further block is allocated from ARENA: both must remain
+ / valid until the callback has been called
+*/
 READOSM_PRIVATE void append_tag_to_node (readosm_internal_node * node,
-					 const char *key, const char *value);
-READOSM_PRIVATE void destroy_internal_node (readosm_internal_node * node);
-READOSM_PRIVATE readosm_internal_way *alloc_internal_way (void);
+					 readosm_arena * arena, char *key,
+					 char *value);
 READOSM_PRIVATE void append_reference_to_way (readosm_internal_way * way,
+					      readosm_arena * arena,
 					      long long node_ref);
 READOSM_PRIVATE void append_tag_to_way (readosm_internal_way * way,
-					const char *key, const char *value);
-READOSM_PRIVATE void destroy_internal_way (readosm_internal_way * way);
-READOSM_PRIVATE readosm_internal_relation *alloc_internal_relation (void);
+					readosm_arena * arena, char *key,
+					char *value);
 READOSM_PRIVATE void append_member_to_relation (readosm_internal_relation *
-						relation, int type,
-						long long id, const char *role);
+						relation,
+						readosm_arena * arena,
+						int type, long long id,
+						char *role);
 READOSM_PRIVATE void append_tag_to_relation (readosm_internal_relation *
-					     relation, const char *key,
-					     const char *value);
-READOSM_PRIVATE void destroy_internal_relation (readosm_internal_relation *
-						relation);
+					     relation, readosm_arena * arena,
+					     char *key, char *value);
+
+/* ISO-8601 timestamps */
+READOSM_PRIVATE int format_iso8601 (long long epoch, char *buffer);
+READOSM_PRIVATE int parse_iso8601 (const char *str, long long *epoch);
+READOSM_PRIVATE int fixed_coordinate (double degrees);
 
 /* XML and ProtoBuf parsers */
 READOSM_PRIVATE int parse_osm_pbf (readosm_file * input, const void *user_data,
 				   readosm_node_callback node_fnct,
 				   readosm_way_callback way_fnct,
 				   readosm_relation_callback relation_fnct);
+READOSM_PRIVATE int parse_osm_pbf_mt (readosm_file * input,
+				      const void *user_data,
+				      readosm_node_callback node_fnct,
+				      readosm_way_callback way_fnct,
+				      readosm_relation_callback relation_fnct,
+				      int threads);
+READOSM_PRIVATE int parse_osm_pbf_parallel (readosm_file * input,
+					    readosm_user_data_factory
+					    factory,
+					    const void *factory_data,
+					    readosm_node_callback node_fnct,
+					    readosm_way_callback way_fnct,
+					    readosm_relation_callback
+					    relation_fnct, int threads);
+READOSM_PRIVATE long long tell_osm_file (readosm_file * input);
+READOSM_PRIVATE int seek_osm_file (readosm_file * input, long long offset);
+READOSM_PRIVATE void destroy_pbf_decoder (struct readosm_pbf_decoder_struct
+					  *decoder);
+READOSM_PRIVATE int load_osm_header (readosm_file * input);
+READOSM_PRIVATE void destroy_osm_header (readosm_export_header * header);
+READOSM_PRIVATE int build_block_index (readosm_file * input);
+READOSM_PRIVATE int write_block_index (readosm_file * input);
+READOSM_PRIVATE void load_block_index (readosm_file * input);
+READOSM_PRIVATE int parse_osm_pbf_range (readosm_file * input,
+					 long long start_offset,
+					 long long end_offset,
+					 const void *user_data,
+					 readosm_node_callback node_fnct,
+					 readosm_way_callback way_fnct,
+					 readosm_relation_callback
+					 relation_fnct);
+READOSM_PRIVATE int parse_osm_pbf_batches (readosm_file * input,
+					   const void *user_data,
+					   readosm_node_batch_callback
+					   node_fnct,
+					   readosm_way_batch_callback way_fnct,
+					   readosm_relation_batch_callback
+					   relation_fnct);
+READOSM_PRIVATE int parse_osm_pbf_columns (readosm_file * input,
+					   const void *user_data,
+					   readosm_node_columns_callback
+					   node_fnct,
+					   readosm_way_batch_callback way_fnct,
+					   readosm_relation_batch_callback
+					   relation_fnct);
 READOSM_PRIVATE int parse_osm_xml (readosm_file * input, const void *user_data,
 				   readosm_node_callback node_fnct,
 				   readosm_way_callback way_fnct,
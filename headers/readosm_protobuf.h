@@ -87,28 +87,21 @@
 #define READOSM_MASK64_9	0x7f00000000000000
 #define READOSM_MASK64_A	0x8000000000000000
 
-typedef struct readosm_packed_infos_struct
-{
-/* a struct supporting DenseInfos parsing */
-    int ver_count;		/* how many Version values are there */
-    int *versions;		/* Version values array */
-    int tim_count;		/* how many Timestamp values are there */
-    int *timestamps;		/* Timestamp values array */
-    int cng_count;		/* how many Changeset values are there */
-    long long *changesets;	/* Changeset values array */
-    int uid_count;		/* how many UID values are there */
-    int *uids;			/* UID values array */
-    int usr_count;		/* how many User values are there */
-    int *users;			/* indexes to access corresponding Strings in StringTable */
-} readosm_packed_infos;
+/* PBF Blob compression types (matching the Blob field IDs) */
+#define READOSM_BLOB_RAW	1
+#define READOSM_BLOB_ZLIB	3
+#define READOSM_BLOB_LZMA	4
+#define READOSM_BLOB_BZIP2	5
+#define READOSM_BLOB_LZ4	6
+#define READOSM_BLOB_ZSTD	7
+
 
-typedef struct readosm_variant_hint_struct
+typedef struct readosm_field_table_struct
 {
-/* VariantHints for PBF parsing */
-    unsigned char field_id;	/* field ID */
-    unsigned char type;		/* expected type */
-    struct readosm_variant_hint_struct *next;	/* supporting linked list */
-} readosm_variant_hint;
+/* a static table of PBF field type hints, indexed by field ID */
+    unsigned int max_field_id;	/* the highest declared field ID */
+    const unsigned char *types;	/* expected types (READOSM_VAR_UNDEFINED if unknown) */
+} readosm_field_table;
 
 typedef struct readosm_variant_struct
 {
@@ -128,15 +121,14 @@ typedef struct readosm_variant_struct
     size_t length;		/* length in bytes [for strings] */
     unsigned char *pointer;	/* pointer to String value */
     char valid;			/* valid value */
-    readosm_variant_hint *first;	/* pointers supporting a linked list */
-    readosm_variant_hint *last;	/* of VariantHints items */
+    const readosm_field_table *fields;	/* expected fields for the current message */
 } readosm_variant;
 
 typedef struct readosm_string_struct
 {
 /* a String into a PBF StringTable */
     char *string;		/* pointer to string value (NULL terminated string) */
-    struct readosm_string_struct *next;	/*  supporting linked list */
+    int length;			/* string length (in bytes) */
 } readosm_string;
 
 typedef struct readosm_string_table_struct
@@ -152,56 +144,163 @@ typedef struct readosm_string_table_struct
  / encode string values; they'll use instead the corresponding
  / index referencing the appropriate string within the StringTable.
 */
-    readosm_string *first;	/* pointers supporting a linked list */
-    readosm_string *last;	/* of PBF string objects */
-    int count;			/* how many TAG items are there */
-    readosm_string **strings;	/* array of PBF string objects */
+    int count;			/* how many strings are there */
+    int max;			/* allocated array capacity */
+    readosm_string *strings;	/* contiguous array of PBF string objects */
+    char *buffer;		/* side buffer (strings not terminated in place) */
+    size_t buffer_used;		/* buffer bytes currently used */
+    size_t buffer_max;		/* buffer capacity (in bytes) */
 } readosm_string_table;
 
-typedef struct readosm_uint32_struct
-{
-/* a uint32 value into the PBF packed object */
-    unsigned int value;
-    struct readosm_uint32_struct *next;
-} readosm_uint32;
-
 typedef struct readosm_uint32_packed_struct
 {
-/* a PBF uint32 packed object */
-    readosm_uint32 *first;
-    readosm_uint32 *last;
-    int count;
+/* a PBF uint32 packed object (contiguous array) */
+    int count;			/* how many values are there */
+    int max;			/* allocated array capacity */
     unsigned int *values;
 } readosm_uint32_packed;
 
-typedef struct readosm_int32_struct
-{
-/* an int32 value into the PBF packed object */
-    int value;
-    struct readosm_int32_struct *next;
-} readosm_int32;
-
 typedef struct readosm_int32_packed_struct
 {
-/* a PBF int32 packed object */
-    readosm_int32 *first;
-    readosm_int32 *last;
-    int count;
+/* a PBF int32 packed object (contiguous array) */
+    int count;			/* how many values are there */
+    int max;			/* allocated array capacity */
     int *values;
 } readosm_int32_packed;
 
-typedef struct readosm_int64_struct
-{
-/* an int64 value into the PBF packed object */
-    long long value;
-    struct readosm_int64_struct *next;
-} readosm_int64;
-
 typedef struct readosm_int64_packed_struct
 {
-/* a PBF int64 packed object */
-    readosm_int64 *first;
-    readosm_int64 *last;
-    int count;
+/* a PBF int64 packed object (contiguous array) */
+    int count;			/* how many values are there */
+    int max;			/* allocated array capacity */
     long long *values;
 } readosm_int64_packed;
+
+typedef struct readosm_packed_infos_struct
+{
+/* a struct supporting DenseInfos parsing */
+    readosm_int32_packed versions;	/* Version values */
+    readosm_int64_packed timestamps;	/* Timestamp values */
+    readosm_int64_packed changesets;	/* Changeset values */
+    readosm_int32_packed uids;	/* UID values */
+    readosm_int32_packed users;	/* indexes to access corresponding Strings in StringTable */
+} readosm_packed_infos;
+
+typedef struct readosm_export_batch_struct
+{
+/* 
+ / export objects directly reassembled from a PrimitiveGroup
+ /
+ / DenseNodes are stored as a compact batch of export NODEs, and
+ / all Tags belonging to the batch share a single contiguous array
+ / (each Node simply points to its own first Tag): most Nodes have
+ / no Tags at all, and the whole batch easily fits into the L2 cache
+ /
+ / Ways and Relations are appended in the same way (Way node-refs
+ / accumulating into the refs packed object); they are delivered
+ / one at a time, or all at once at the end of the PrimitiveGroup
+ / when batch callbacks are used
+*/
+    readosm_export_node *nodes;	/* the current batch of Nodes */
+    int max_nodes;		/* allocated Nodes capacity */
+    readosm_export_way *ways;	/* pending Ways */
+    int way_count;		/* how many Ways are pending */
+    int max_ways;		/* allocated Ways capacity */
+    readosm_export_relation *relations;	/* pending Relations */
+    int relation_count;		/* how many Relations are pending */
+    int max_relations;		/* allocated Relations capacity */
+    readosm_export_member *members;	/* Members of pending Relations */
+    int member_count;		/* how many Members are there */
+    int max_members;		/* allocated Members capacity */
+    readosm_export_tag *tags;	/* Tags shared by all objects in the batch */
+    int tag_count;		/* how many Tags are there */
+    int max_tags;		/* allocated Tags capacity */
+} readosm_export_batch;
+
+typedef struct readosm_pbf_buffers_struct
+{
+/* 
+ / reusable buffers supporting PrimitiveBlock parsing
+ / they belong to a decoder context, and are recycled by all
+ / subsequent blocks and groups: each buffer simply grows up
+ / to the size required by the largest block ever found
+*/
+    readosm_string_table strings;	/* the current StringTable */
+    readosm_uint32_packed keys;	/* Tag keys (or DenseNodes keys_vals) */
+    readosm_uint32_packed values;	/* Tag values */
+    readosm_uint32_packed roles;	/* Relation member roles */
+    readosm_uint32_packed types;	/* Relation member types */
+    readosm_int64_packed ids;	/* DenseNodes IDs */
+    readosm_int64_packed lats;	/* DenseNodes latitudes */
+    readosm_int64_packed lons;	/* DenseNodes longitudes */
+    readosm_int64_packed refs;	/* Way node-refs or Relation member IDs */
+    readosm_int32_packed fixed_lats;	/* DenseNodes columns: latitudes */
+    readosm_int32_packed fixed_lons;	/* DenseNodes columns: longitudes */
+    readosm_int32_packed tag_offsets;	/* DenseNodes columns: Tag offsets */
+    readosm_packed_infos infos;	/* DenseInfos */
+    readosm_export_batch batch;	/* reassembled export objects */
+    readosm_arena arena;	/* Timestamps and further Tag/Ref/Member blocks */
+} readosm_pbf_buffers;
+
+typedef struct readosm_pbf_blob_struct
+{
+/* a raw (still compressed) OSMData Blob */
+    unsigned char *buf;		/* allocated buffer (NULL when memory-mapped) */
+    unsigned char *ptr;		/* pointer to the Blob bytes */
+    unsigned int size;		/* Blob size (in bytes) */
+} readosm_pbf_blob;
+
+typedef struct readosm_pbf_decoder_struct
+{
+/* 
+ / a reusable PBF decoder context
+ / both the inflate buffer and the zlib stream are kept alive
+ / across subsequent Blobs, so that steady-state decoding will
+ / never require large memory allocations
+*/
+    unsigned char *raw_buf;	/* inflate buffer */
+    unsigned int raw_max;	/* inflate buffer capacity (in bytes) */
+    z_stream strm;		/* persistent zlib stream */
+    int strm_ready;		/* the zlib stream has been initialized */
+#ifdef HAVE_LIBDEFLATE
+    struct libdeflate_decompressor *inflater;	/* libdeflate decompressor */
+#endif
+#ifdef HAVE_LIBZSTD
+    struct ZSTD_DCtx_s *zstd;	/* zstd decompression context */
+#endif
+    readosm_pbf_buffers buffers;	/* reusable parsing buffers */
+} readosm_pbf_decoder;
+
+struct pbf_params
+{
+/* an helper struct supporting PBF parsing */
+    const void *user_data;
+    readosm_node_callback node_callback;
+    readosm_way_callback way_callback;
+    readosm_relation_callback relation_callback;
+    readosm_node_batch_callback node_batch_callback;
+    readosm_way_batch_callback way_batch_callback;
+    readosm_relation_batch_callback relation_batch_callback;
+    readosm_node_columns_callback node_columns_callback;
+    int stop;
+    int skip_metadata;		/* ignoring any Info and DenseInfo */
+    int lazy_timestamps;	/* not formatting Timestamp strings */
+    int granularity;		/* current block: coordinates granularity */
+    long long lat_offset;	/* current block: latitude offset */
+    long long lon_offset;	/* current block: longitude offset */
+    int date_granularity;	/* current block: timestamps granularity */
+    int types;			/* READOSM_BLOCK_xx found in the current Blob */
+    readosm_pbf_buffers *buffers;	/* set by parse_osm_blob() */
+};
+
+/* PBF Blob handling */
+READOSM_PRIVATE int read_osm_header (readosm_file * input);
+READOSM_PRIVATE int read_osm_blob (readosm_file * input,
+				   readosm_pbf_blob * blob);
+READOSM_PRIVATE void release_osm_blob (readosm_pbf_blob * blob);
+READOSM_PRIVATE readosm_pbf_decoder *alloc_pbf_decoder (void);
+READOSM_PRIVATE readosm_pbf_decoder *get_pbf_decoder (readosm_file * input);
+READOSM_PRIVATE int parse_osm_blob (readosm_pbf_decoder * decoder,
+				    readosm_pbf_blob * blob,
+				    char little_endian_cpu,
+				    struct pbf_params *params);
@@ -0,0 +1,284 @@
+/*
+/ readosm_varint.h
+/
+/ internal declarations (Protocol Buffer varint decoders)
+/
+/ Author: the ReadOSM contributors, 2026
+/
+/ ------------------------------------------------------------------------------
+/
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the ReadOSM library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/
+/ Portions created by the Initial Developer are Copyright (C) 2012-2017
+/ the Initial Developer. All Rights Reserved.
+/
+/ Contributor(s):
+/
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/
+*/
+
+/*
+ * specialized base128 varint decoders
+ *
+ * all decoders share the same conventions used by the PBF parser:
+ * - START points to the first byte of the varint
+ * - STOP points to the last valid byte of the buffer
+ * - the returned pointer addresses the first byte following the
+ *   varint, or is NULL if the varint is malformed or truncated
+ *
+ * whenever at least 10 bytes are available the varint is decoded
+ * from a single (unaligned) 8-byte load, by locating the terminating
+ * byte and then compacting all 7-bit groups using a fixed sequence
+ * of masks and shifts; a byte-by-byte loop is only used near the
+ * end of the buffer
+ */
+
+#ifndef READOSM_VARINT_H
+#define READOSM_VARINT_H
+
+#include <string.h>
+
+#if defined(_MSC_VER)
+#define READOSM_INLINE static __inline
+#else
+#define READOSM_INLINE static inline
+#endif
+
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) \
+    || defined(_M_IX86) || defined(_M_X64) || defined(_M_ARM64)
+#define READOSM_VARINT_LE_LOAD	1
+#endif
+
+#define READOSM_VARINT_CONT	0x8080808080808080ULL
+#define READOSM_VARINT_CONT32	0x0000008080808080ULL
+#define READOSM_VARINT_DATA	0x7f7f7f7f7f7f7f7fULL
+
+READOSM_INLINE unsigned long long
+varint_load64 (const unsigned char *p)
+{
+/* loading 8 bytes (unaligned) as a little-endian word */
+#ifdef READOSM_VARINT_LE_LOAD
+    unsigned long long w;
+    memcpy (&w, p, 8);
+    return w;
+#else
+    return (unsigned long long) p[0] | ((unsigned long long) p[1] << 8) |
+	((unsigned long long) p[2] << 16) | ((unsigned long long) p[3] << 24)
+	| ((unsigned long long) p[4] << 32) | ((unsigned long long) p[5] <<
+					       40) |
+	((unsigned long long) p[6] << 48) | ((unsigned long long) p[7] << 56);
+#endif
+}
+
+READOSM_INLINE int
+varint_length (unsigned long long cont)
+{
+/*
+ / returning the byte length of a varint, given the (non-zero)
+ / mask of the terminating bytes within the loaded word
+*/
+#if defined(__GNUC__)
+    return (__builtin_ctzll (cont) >> 3) + 1;
+#else
+    int len = 1;
+    while ((cont & 0x80) == 0)
+      {
+	  cont >>= 8;
+	  len++;
+      }
+    return len;
+#endif
+}
+
+READOSM_INLINE unsigned long long
+varint_compact (unsigned long long w)
+{
+/* compacting up to eight 7-bit groups into a single value */
+    w &= READOSM_VARINT_DATA;
+    w = (w & 0x007f007f007f007fULL) | ((w & 0x7f007f007f007f00ULL) >> 1);
+    w = (w & 0x00003fff00003fffULL) | ((w & 0x3fff00003fff0000ULL) >> 2);
+    w = (w & 0x000000000fffffffULL) | ((w & 0x0fffffff00000000ULL) >> 4);
+    return w;
+}
+
+READOSM_INLINE unsigned char *
+read_varint64_slow (unsigned char *start, unsigned char *stop,
+		    unsigned long long *value)
+{
+/* decoding a varint byte by byte (close to the end of the buffer) */
+    unsigned char *ptr = start;
+    unsigned long long v = 0;
+    int shift = 0;
+    while (ptr <= stop && shift < 64)
+      {
+	  unsigned char c = *ptr++;
+	  v |= (unsigned long long) (c & 0x7f) << shift;
+	  if ((c & 0x80) == 0)
+	    {
+		*value = v;
+		return ptr;
+	    }
+	  shift += 7;
+      }
+    return NULL;
+}
+
+READOSM_INLINE unsigned char *
+read_varint64 (unsigned char *start, unsigned char *stop,
+	       unsigned long long *value)
+{
+/* decoding an UINT64 / INT64 varint */
+    unsigned long long w;
+    unsigned long long cont;
+    unsigned char c;
+
+    if (start <= stop && *start < 0x80)
+      {
+	  /* single byte varint: by far the most common case */
+	  *value = *start;
+	  return start + 1;
+      }
+    if (stop - start < 9)
+	return read_varint64_slow (start, stop, value);
+
+    w = varint_load64 (start);
+    cont = ~w & READOSM_VARINT_CONT;
+    if (cont != 0)
+      {
+	  /* masking all bytes following the terminating one */
+	  *value = varint_compact (w & (cont ^ (cont - 1)));
+	  return start + varint_length (cont);
+      }
+
+/* a 9 or 10 bytes varint */
+    w = varint_compact (w);
+    c = start[8];
+    w |= (unsigned long long) (c & 0x7f) << 56;
+    if (c < 0x80)
+      {
+	  *value = w;
+	  return start + 9;
+      }
+    c = start[9];
+    if (c >= 0x80)
+	return NULL;
+    *value = w | ((unsigned long long) c << 63);
+    return start + 10;
+}
+
+READOSM_INLINE unsigned char *
+read_varint32 (unsigned char *start, unsigned char *stop,
+	       unsigned int *value)
+{
+/*
+ / decoding an UINT32 / INT32 varint
+ / (negative INT32 values are always encoded on 10 bytes)
+*/
+    unsigned long long w;
+    unsigned long long cont;
+    unsigned char *ptr;
+
+    if (start <= stop && *start < 0x80)
+      {
+	  /* single byte varint: by far the most common case */
+	  *value = *start;
+	  return start + 1;
+      }
+    if (stop - start >= 9)
+      {
+	  w = varint_load64 (start);
+	  cont = ~w & READOSM_VARINT_CONT32;
+	  if (cont != 0)
+	    {
+		/* a varint of at most 5 bytes */
+		*value =
+		    (unsigned int) varint_compact (w & (cont ^ (cont - 1)));
+		return start + varint_length (cont);
+	    }
+      }
+    ptr = read_varint64 (start, stop, &w);
+    if (ptr != NULL)
+	*value = (unsigned int) w;
+    return ptr;
+}
+
+READOSM_INLINE int
+zigzag32 (unsigned int value)
+{
+/* decoding a ZigZag encoded SINT32 */
+    return (int) ((value >> 1) ^ (0U - (value & 1)));
+}
+
+READOSM_INLINE long long
+zigzag64 (unsigned long long value)
+{
+/* decoding a ZigZag encoded SINT64 */
+    return (long long) ((value >> 1) ^ (0ULL - (value & 1)));
+}
+
+READOSM_INLINE unsigned char *
+read_svarint32 (unsigned char *start, unsigned char *stop, int *value)
+{
+/* decoding a SINT32 varint */
+    unsigned int v;
+    unsigned char *ptr = read_varint32 (start, stop, &v);
+    if (ptr != NULL)
+	*value = zigzag32 (v);
+    return ptr;
+}
+
+READOSM_INLINE unsigned char *
+read_svarint64 (unsigned char *start, unsigned char *stop, long long *value)
+{
+/* decoding a SINT64 varint */
+    unsigned long long v;
+    unsigned char *ptr = read_varint64 (start, stop, &v);
+    if (ptr != NULL)
+	*value = zigzag64 (v);
+    return ptr;
+}
+
+/*
+ * bulk decoders for packed varint arrays [pbf_varint.c]
+ *
+ * VALUES must have room for (STOP - START + 1) + READOSM_PACKED_SLACK
+ * items; the number of decoded values is returned (-1 on error)
+ */
+#define READOSM_PACKED_SLACK	8
+
+READOSM_PRIVATE int packed_varint_simd (void);
+READOSM_PRIVATE int decode_packed_uint32 (unsigned char *start,
+					  unsigned char *stop,
+					  unsigned int *values);
+READOSM_PRIVATE int decode_packed_sint32 (unsigned char *start,
+					  unsigned char *stop, int *values);
+READOSM_PRIVATE int decode_packed_sint64 (unsigned char *start,
+					  unsigned char *stop,
+					  long long *values);
+
+#endif /* READOSM_VARINT_H */
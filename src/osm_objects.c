@@ -57,104 +57,104 @@
 #include "readosm.h"
 #include "readosm_internals.h"
 
-static void
-release_internal_tag (readosm_internal_tag * tag)
-{
-/* freeing an internal TAG object */
-    if (tag->key)
-	free (tag->key);
-    if (tag->value)
-	free (tag->value);
-}
+/* arena chunks payload starts here (suitably aligned) */
+#define ARENA_HDR_SZ ((sizeof (readosm_arena_chunk) + 15) & ~((size_t) 15))
 
 READOSM_PRIVATE void
-release_internal_tag_block (readosm_internal_tag_block * tag_blk, int destroy)
-{
-/* freeing an internal TAG block */
-    int i_tag;
-    for (i_tag = 0; i_tag < tag_blk->next_item; i_tag++)
-	release_internal_tag (tag_blk->tags + i_tag);
-    if (destroy)
-	free (tag_blk);
-    else
-      {
-	  tag_blk->next_item = 0;
-	  tag_blk->next = NULL;
-      }
-}
-
-static void
-release_internal_member (readosm_internal_member * member)
+init_arena (readosm_arena * arena)
 {
-/* freeing an internal MEMBER object */
-    if (member->role)
-	free (member->role);
+/* initializing an empty Arena */
+    arena->first = NULL;
+    arena->last = NULL;
+    arena->current = NULL;
 }
 
-READOSM_PRIVATE void
-release_internal_member_block (readosm_internal_member_block * mbr_blk,
-			       int destroy)
+READOSM_PRIVATE void *
+arena_alloc (readosm_arena * arena, size_t size)
 {
-/* freeing an internal MEMBER block */
-    int i_mbr;
-    for (i_mbr = 0; i_mbr < mbr_blk->next_item; i_mbr++)
-	release_internal_member (mbr_blk->members + i_mbr);
-    if (destroy)
-	free (mbr_blk);
-    else
+/* allocating some memory from the Arena */
+    size_t sz;
+    readosm_arena_chunk *chunk = arena->current;
+    size = (size + 7) & ~((size_t) 7);
+    while (chunk != NULL)
       {
-	  mbr_blk->next_item = 0;
-	  mbr_blk->next = NULL;
-      }
+	  if (chunk->size - chunk->used >= size)
+	    {
+		/* there is enough free room into this chunk */
+		void *ptr = (unsigned char *) chunk + ARENA_HDR_SZ + chunk->used;
+		chunk->used += size;
+		arena->current = chunk;
+		return ptr;
+	    }
+	  chunk = chunk->next;
+      }
+
+/* appending a further chunk */
+    sz = (size > READOSM_ARENA_SZ) ? size : READOSM_ARENA_SZ;
+    chunk = malloc (ARENA_HDR_SZ + sz);
+    if (chunk == NULL)
+	return NULL;
+    chunk->size = sz;
+    chunk->used = size;
+    chunk->next = NULL;
+    if (arena->first == NULL)
+	arena->first = chunk;
+    if (arena->last != NULL)
+	arena->last->next = chunk;
+    arena->last = chunk;
+    arena->current = chunk;
+    return (unsigned char *) chunk + ARENA_HDR_SZ;
 }
 
-READOSM_PRIVATE void
-init_export_tag (readosm_export_tag * tag)
+READOSM_PRIVATE char *
+arena_strdup (readosm_arena * arena, const char *str)
 {
-/* initializing an empty export TAG object */
-    if (tag == NULL)
-	return;
-    tag->key = NULL;
-    tag->value = NULL;
+/* copying a string into the Arena */
+    char *copy;
+    size_t len;
+    if (str == NULL)
+	return NULL;
+    len = strlen (str);
+    copy = arena_alloc (arena, len + 1);
+    if (copy != NULL)
+	memcpy (copy, str, len + 1);
+    return copy;
 }
 
 READOSM_PRIVATE void
-reset_export_tag (readosm_export_tag * tag)
+reset_arena (readosm_arena * arena)
 {
-/* resetting an export TAG object to initial empty state */
-    if (tag == NULL)
-	return;
-    if (tag->key)
-	free (tag->key);
-    if (tag->value)
-	free (tag->value);
-    init_export_tag (tag);
+/* releasing all at once any item allocated from the Arena */
+    readosm_arena_chunk *chunk = arena->first;
+    while (chunk != NULL)
+      {
+	  chunk->used = 0;
+	  chunk = chunk->next;
+      }
+    arena->current = arena->first;
 }
 
 READOSM_PRIVATE void
-init_internal_node (readosm_internal_node * node)
+finalize_arena (readosm_arena * arena)
 {
-/* allocating an empty internal NODE object */
-    node->id = READOSM_UNDEFINED;
-    node->latitude = READOSM_UNDEFINED;
-    node->longitude = READOSM_UNDEFINED;
-    node->version = READOSM_UNDEFINED;
-    node->changeset = READOSM_UNDEFINED;
-    node->user = NULL;
-    node->uid = READOSM_UNDEFINED;
-    node->timestamp = NULL;
-    node->tag_count = 0;
-    node->first_tag.next_item = 0;
-    node->first_tag.next = NULL;
-    node->last_tag = &(node->first_tag);
+/* cleaning any memory allocation for an Arena */
+    readosm_arena_chunk *chunk;
+    readosm_arena_chunk *chunk_n;
+    chunk = arena->first;
+    while (chunk != NULL)
+      {
+	  chunk_n = chunk->next;
+	  free (chunk);
+	  chunk = chunk_n;
+      }
+    init_arena (arena);
 }
 
 READOSM_PRIVATE void
-append_tag_to_node (readosm_internal_node * node, const char *key,
-		    const char *value)
+append_tag_to_node (readosm_internal_node * node, readosm_arena * arena,
+		    char *key, char *value)
 {
 /* appending a TAG to a Node object */
-    int len;
     readosm_internal_tag_block *tag_blk = node->last_tag;
     readosm_internal_tag *tag;
     if (tag_blk->next_item < READOSM_BLOCK_SZ)
@@ -166,7 +166,7 @@ append_tag_to_node (readosm_internal_node * node, const char *key,
     else
       {
 	  /* appending a further Tag block */
-	  tag_blk = malloc (sizeof (readosm_internal_tag_block));
+	  tag_blk = arena_alloc (arena, sizeof (readosm_internal_tag_block));
 	  tag_blk->next_item = 1;
 	  tag_blk->next = NULL;
 	  tag = tag_blk->tags;
@@ -174,103 +174,14 @@ append_tag_to_node (readosm_internal_node * node, const char *key,
 	  node->last_tag = tag_blk;
       }
 
-/* initializing the Tag */
-    len = strlen (key);
-    tag->key = malloc (len + 1);
-    strcpy (tag->key, key);
-    len = strlen (value);
-    tag->value = malloc (len + 1);
-    strcpy (tag->value, value);
+/* initializing the Tag (strings are simply referenced) */
+    tag->key = key;
+    tag->value = value;
 }
 
 READOSM_PRIVATE void
-destroy_internal_node (readosm_internal_node * node)
-{
-/* destroying an internal NODE object */
-    readosm_internal_tag_block *tag_blk;
-    readosm_internal_tag_block *tag_blk_n;
-    if (node == NULL)
-	return;
-    if (node->user)
-	free (node->user);
-    if (node->timestamp)
-	free (node->timestamp);
-    tag_blk = &(node->first_tag);
-    while (tag_blk)
-      {
-	  tag_blk_n = tag_blk->next;
-	  if (tag_blk == &(node->first_tag))
-	      release_internal_tag_block (tag_blk, 0);
-	  else
-	      release_internal_tag_block (tag_blk, 1);
-	  tag_blk = tag_blk_n;
-      }
-    node->last_tag = &(node->first_tag);
-}
-
-static void
-init_export_node (readosm_export_node * node)
-{
-/* initializing an empty export NODE object */
-    if (node == NULL)
-	return;
-    node->id = READOSM_UNDEFINED;
-    node->latitude = READOSM_UNDEFINED;
-    node->longitude = READOSM_UNDEFINED;
-    node->version = READOSM_UNDEFINED;
-    node->changeset = READOSM_UNDEFINED;
-    node->user = NULL;
-    node->uid = READOSM_UNDEFINED;
-    node->timestamp = NULL;
-    node->tag_count = 0;
-    node->tags = NULL;
-}
-
-static void
-reset_export_node (readosm_export_node * node)
-{
-/* resetting an export NODE object to initial empty state */
-    int i;
-    if (node == NULL)
-	return;
-    if (node->user)
-	free (node->user);
-    if (node->timestamp)
-	free (node->timestamp);
-    for (i = 0; i < node->tag_count; i++)
-      {
-	  readosm_export_tag *tag = node->tags + i;
-	  reset_export_tag (tag);
-      }
-    if (node->tags)
-	free (node->tags);
-    init_export_node (node);
-}
-
-READOSM_PRIVATE readosm_internal_way *
-alloc_internal_way (void)
-{
-/* allocating an empty internal WAY object */
-    readosm_internal_way *way = malloc (sizeof (readosm_internal_way));
-    way->id = 0;
-    way->version = 0;
-    way->changeset = 0;
-    way->user = NULL;
-    way->uid = 0;
-    way->timestamp = NULL;
-    way->ref_count = 0;
-    way->first_ref.next_item = 0;
-    way->first_ref.next = NULL;
-    way->last_ref = &(way->first_ref);
-    way->tag_count = 0;
-    way->first_tag.next_item = 0;
-    way->first_tag.next = NULL;
-    way->last_tag = &(way->first_tag);
-    return way;
-}
-
-READOSM_PRIVATE void
-append_reference_to_way (readosm_internal_way * way, long long node_ref)
+append_reference_to_way (readosm_internal_way * way, readosm_arena * arena,
+			 long long node_ref)
 {
 /* appending a NODE-REF to a WAY object */
     readosm_internal_ref *ref = way->last_ref;
@@ -283,7 +194,7 @@ append_reference_to_way (readosm_internal_way * way, long long node_ref)
     else
       {
 	  /* appending a further Ref block */
-	  ref = malloc (sizeof (readosm_internal_ref));
+	  ref = arena_alloc (arena, sizeof (readosm_internal_ref));
 	  *(ref->node_refs + 0) = node_ref;
 	  ref->next_item = 1;
 	  ref->next = NULL;
@@ -293,11 +204,10 @@ append_reference_to_way (readosm_internal_way * way, long long node_ref)
 }
 
 READOSM_PRIVATE void
-append_tag_to_way (readosm_internal_way * way, const char *key,
-		   const char *value)
+append_tag_to_way (readosm_internal_way * way, readosm_arena * arena,
+		   char *key, char *value)
 {
 /* appending a TAG to a WAY object */
-    int len;
     readosm_internal_tag_block *tag_blk = way->last_tag;
     readosm_internal_tag *tag;
     if (tag_blk->next_item < READOSM_BLOCK_SZ)
@@ -309,7 +219,7 @@ append_tag_to_way (readosm_internal_way * way, const char *key,
     else
       {
 	  /* appending a further Tag block */
-	  tag_blk = malloc (sizeof (readosm_internal_tag_block));
+	  tag_blk = arena_alloc (arena, sizeof (readosm_internal_tag_block));
 	  tag_blk->next_item = 1;
 	  tag_blk->next = NULL;
 	  tag = tag_blk->tags;
@@ -317,141 +227,17 @@ append_tag_to_way (readosm_internal_way * way, const char *key,
 	  way->last_tag = tag_blk;
       }
 
-/* initializing the Tag */
-    len = strlen (key);
-    tag->key = malloc (len + 1);
-    strcpy (tag->key, key);
-    len = strlen (value);
-    tag->value = malloc (len + 1);
-    strcpy (tag->value, value);
+/* initializing the Tag (strings are simply referenced) */
+    tag->key = key;
+    tag->value = value;
 }
 
 READOSM_PRIVATE void
-destroy_internal_way (readosm_internal_way * way)
-{
-/* destroying an internal WAY object */
-    readosm_internal_ref *ref;
-    readosm_internal_ref *ref_n;
-    readosm_internal_tag_block *tag_blk;
-    readosm_internal_tag_block *tag_blk_n;
-    if (way == NULL)
-	return;
-    if (way->user)
-	free (way->user);
-    if (way->timestamp)
-	free (way->timestamp);
-    ref = way->first_ref.next;
-    while (ref)
-      {
-	  ref_n = ref->next;
-	  free (ref);
-	  ref = ref_n;
-      }
-    tag_blk = &(way->first_tag);
-    while (tag_blk)
-      {
-	  tag_blk_n = tag_blk->next;
-	  if (tag_blk == &(way->first_tag))
-	      release_internal_tag_block (tag_blk, 0);
-	  else
-	      release_internal_tag_block (tag_blk, 1);
-	  tag_blk = tag_blk_n;
-      }
-    free (way);
-}
-
-static void
-init_export_way (readosm_export_way * way)
-{
-/* initializing an empty export WAY object */
-    if (way == NULL)
-	return;
-    way->id = 0;
-    way->version = 0;
-    way->changeset = 0;
-    way->user = NULL;
-    way->uid = 0;
-    way->timestamp = NULL;
-    way->node_ref_count = 0;
-    way->node_refs = NULL;
-    way->tag_count = 0;
-    way->tags = NULL;
-}
-
-static void
-reset_export_way (readosm_export_way * way)
-{
-/* resetting an export WAY object to initial empty state */
-    int i;
-    if (way == NULL)
-	return;
-    if (way->user)
-	free (way->user);
-    if (way->timestamp)
-	free (way->timestamp);
-    if (way->node_refs)
-	free (way->node_refs);
-    for (i = 0; i < way->tag_count; i++)
-      {
-	  readosm_export_tag *tag = way->tags + i;
-	  reset_export_tag (tag);
-      }
-    if (way->tags)
-	free (way->tags);
-    init_export_way (way);
-}
-
-static void
-init_export_member (readosm_export_member * member)
-{
-/* initializing an empty export RELATION-MEMBER object */
-    if (member == NULL)
-	return;
-    member->member_type = READOSM_UNDEFINED;
-    member->id = 0;
-    member->role = NULL;
-}
-
-static void
-reset_export_member (readosm_export_member * member)
-{
-/* resetting an export RELATION-MEMBER object to initial empty state */
-    if (member == NULL)
-	return;
-    if (member->role)
-	free (member->role);
-    init_export_member (member);
-}
-
-READOSM_PRIVATE readosm_internal_relation *
-alloc_internal_relation (void)
-{
-/* allocating an empty internal RELATION object */
-    readosm_internal_relation *rel =
-	malloc (sizeof (readosm_internal_relation));
-    rel->id = 0;
-    rel->version = 0;
-    rel->changeset = 0;
-    rel->user = NULL;
-    rel->uid = 0;
-    rel->timestamp = NULL;
-    rel->member_count = 0;
-    rel->first_member.next_item = 0;
-    rel->first_member.next = NULL;
-    rel->last_member = &(rel->first_member);
-    rel->tag_count = 0;
-    rel->first_tag.next_item = 0;
-    rel->first_tag.next = NULL;
-    rel->last_tag = &(rel->first_tag);
-    return rel;
-}
-
-READOSM_PRIVATE void
-append_member_to_relation (readosm_internal_relation * relation, int type,
-			   long long id, const char *role)
+append_member_to_relation (readosm_internal_relation * relation,
+			   readosm_arena * arena, int type, long long id,
+			   char *role)
 {
 /* appending a RELATION-MEMBER to a RELATION object */
-    int len;
     readosm_internal_member_block *mbr_blk = relation->last_member;
     readosm_internal_member *member;
     if (mbr_blk->next_item < READOSM_BLOCK_SZ)
@@ -463,7 +249,8 @@ append_member_to_relation (readosm_internal_relation * relation, int type,
     else
       {
 	  /* appending a further Member block */
-	  mbr_blk = malloc (sizeof (readosm_internal_member_block));
+	  mbr_blk =
+	      arena_alloc (arena, sizeof (readosm_internal_member_block));
 	  mbr_blk->next_item = 1;
 	  mbr_blk->next = NULL;
 	  member = mbr_blk->members;
@@ -473,17 +260,14 @@ append_member_to_relation (readosm_internal_relation * relation, int type,
 
     member->member_type = type;
     member->id = id;
-    len = strlen (role);
-    member->role = malloc (len + 1);
-    strcpy (member->role, role);
+    member->role = role;
 }
 
 READOSM_PRIVATE void
-append_tag_to_relation (readosm_internal_relation * relation, const char *key,
-			const char *value)
+append_tag_to_relation (readosm_internal_relation * relation,
+			readosm_arena * arena, char *key, char *value)
 {
 /* appending a TAG to a RELATION object */
-    int len;
     readosm_internal_tag_block *tag_blk = relation->last_tag;
     readosm_internal_tag *tag;
     if (tag_blk->next_item < READOSM_BLOCK_SZ)
@@ -495,7 +279,7 @@ append_tag_to_relation (readosm_internal_relation * relation, const char *key,
     else
       {
 	  /* appending a further Tag block */
-	  tag_blk = malloc (sizeof (readosm_internal_tag_block));
+	  tag_blk = arena_alloc (arena, sizeof (readosm_internal_tag_block));
 	  tag_blk->next_item = 1;
 	  tag_blk->next = NULL;
 	  tag = tag_blk->tags;
@@ -503,98 +287,128 @@ append_tag_to_relation (readosm_internal_relation * relation, const char *key,
 	  relation->last_tag = tag_blk;
       }
 
-/* initializing the Tag */
-    len = strlen (key);
-    tag->key = malloc (len + 1);
-    strcpy (tag->key, key);
-    len = strlen (value);
-    tag->value = malloc (len + 1);
-    strcpy (tag->value, value);
+/* initializing the Tag (strings are simply referenced) */
+    tag->key = key;
+    tag->value = value;
 }
 
-READOSM_PRIVATE void
-destroy_internal_relation (readosm_internal_relation * relation)
+static readosm_export_tag *
+export_tags (readosm_internal_tag_block * first_tag, int *count)
 {
-/* destroying an internal RELATION object */
-    readosm_internal_member_block *mbr_blk;
-    readosm_internal_member_block *mbr_blk_n;
-    readosm_internal_tag_block *tag_blk;
-    readosm_internal_tag_block *tag_blk_n;
-    if (relation == NULL)
-	return;
-    if (relation->user)
-	free (relation->user);
-    if (relation->timestamp)
-	free (relation->timestamp);
-    mbr_blk = &(relation->first_member);
-    while (mbr_blk)
+/*
+ / setting up an export TAG array
+ /
+ / internal and export TAGs share the same layout, so the first
+ / (static) block is directly exposed whenever it's the only one;
+ / otherwise a flattened array is built, but in any case the KEY
+ / and VALUE strings are never copied
+*/
+    int i = 0;
+    int i_tag;
+    readosm_export_tag *tags;
+    readosm_internal_tag_block *tag_blk = first_tag;
+    *count = 0;
+    while (tag_blk)
       {
-	  mbr_blk_n = mbr_blk->next;
-	  if (mbr_blk == &(relation->first_member))
-	      release_internal_member_block (mbr_blk, 0);
-	  else
-	      release_internal_member_block (mbr_blk, 1);
-	  mbr_blk = mbr_blk_n;
+	  *count += tag_blk->next_item;
+	  tag_blk = tag_blk->next;
       }
-    tag_blk = &(relation->first_tag);
+    if (*count == 0)
+	return NULL;
+    if (first_tag->next == NULL)
+	return (readosm_export_tag *) (first_tag->tags);
+
+    tags = malloc (sizeof (readosm_export_tag) * *count);
+    tag_blk = first_tag;
     while (tag_blk)
       {
-	  tag_blk_n = tag_blk->next;
-	  if (tag_blk == &(relation->first_tag))
-	      release_internal_tag_block (tag_blk, 0);
-	  else
-	      release_internal_tag_block (tag_blk, 1);
-	  tag_blk = tag_blk_n;
+	  for (i_tag = 0; i_tag < tag_blk->next_item; i_tag++)
+	    {
+		readosm_internal_tag *tag = tag_blk->tags + i_tag;
+		readosm_export_tag *p_tag = tags + i;
+		p_tag->key = tag->key;
+		p_tag->value = tag->value;
+		i++;
+	    }
+	  tag_blk = tag_blk->next;
       }
-    free (relation);
+    return tags;
 }
 
 static void
-init_export_relation (readosm_export_relation * relation)
+release_export_tags (readosm_export_tag * tags,
+		     readosm_internal_tag_block * first_tag)
 {
-/* initializing an empty export RELATION object */
-    if (relation == NULL)
-	return;
-    relation->id = 0;
-    relation->version = 0;
-    relation->changeset = 0;
-    relation->user = NULL;
-    relation->uid = 0;
-    relation->timestamp = NULL;
-    relation->member_count = 0;
-    relation->members = NULL;
-    relation->tag_count = 0;
-    relation->tags = NULL;
+/* freeing an export TAG array (only if not directly exposing a block) */
+    if (tags != NULL && tags != (readosm_export_tag *) (first_tag->tags))
+	free (tags);
 }
 
-static void
-reset_export_relation (readosm_export_relation * relation)
+static long long *
+export_refs (readosm_internal_ref * first_ref, int *count)
 {
-/* resetting an export RELATION object to initial empty state */
-    int i;
-    if (relation == NULL)
-	return;
-    if (relation->user)
-	free (relation->user);
-    if (relation->timestamp)
-	free (relation->timestamp);
-    for (i = 0; i < relation->member_count; i++)
+/* setting up an export NODE-REFs array (same as above) */
+    int i = 0;
+    readosm_internal_ref *ref = first_ref;
+    long long *refs;
+    *count = 0;
+    while (ref)
       {
-	  readosm_export_member *member = relation->members + i;
-	  reset_export_member (member);
+	  *count += ref->next_item;
+	  ref = ref->next;
       }
-    if (relation->members)
-	free (relation->members);
-    for (i = 0; i < relation->tag_count; i++)
+    if (*count == 0)
+	return NULL;
+    if (first_ref->next == NULL)
+	return first_ref->node_refs;
+
+    refs = malloc (sizeof (long long) * *count);
+    ref = first_ref;
+    while (ref)
       {
-	  readosm_export_tag *tag = relation->tags + i;
-	  reset_export_tag (tag);
+	  memcpy (refs + i, ref->node_refs, sizeof (long long) * ref->next_item);
+	  i += ref->next_item;
+	  ref = ref->next;
       }
-    if (relation->tags)
-	free (relation->tags);
-    init_export_relation (relation);
+    return refs;
 }
 
+static readosm_export_member *
+export_members (readosm_internal_member_block * first_member, int *count)
+{
+/* setting up an export RELATION-MEMBERs array (same as above) */
+    int i = 0;
+    int i_mbr;
+    readosm_export_member *members;
+    readosm_internal_member_block *mbr_blk = first_member;
+    *count = 0;
+    while (mbr_blk)
+      {
+	  *count += mbr_blk->next_item;
+	  mbr_blk = mbr_blk->next;
+      }
+    if (*count == 0)
+	return NULL;
+    if (first_member->next == NULL)
+	return (readosm_export_member *) (first_member->members);
+
+    members = malloc (sizeof (readosm_export_member) * *count);
+    mbr_blk = first_member;
+    while (mbr_blk)
+      {
+	  for (i_mbr = 0; i_mbr < mbr_blk->next_item; i_mbr++)
+	    {
+		readosm_internal_member *member = mbr_blk->members + i_mbr;
+		readosm_export_member *p_member = members + i;
+		p_member->member_type = member->member_type;
+		p_member->id = member->id;
+		p_member->role = member->role;
+		i++;
+	    }
+	  mbr_blk = mbr_blk->next;
+      }
+    return members;
+}
 
 READOSM_PRIVATE int
 call_node_callback (readosm_node_callback node_callback,
@@ -602,90 +416,36 @@ call_node_callback (readosm_node_callback node_callback,
 {
 /* calling the Node-handling callback function */
     int ret;
-    int len;
-    readosm_internal_tag *tag;
-    readosm_internal_tag_block *tag_blk;
-    int i_tag;
     readosm_export_node exp_node;
 
 /* 
  / please note: READONLY-NODE simply is the same as export 
  / NODE inteded to disabale any possible awful user action
+ /
+ / the export NODE object simply points to the strings and
+ / TAGs owned by the internal NODE object, which are surely
+ / stable for the whole lifetime of the callback
 */
     readosm_node *readonly_node = (readosm_node *) & exp_node;
 
-/*initialing an empty export NODE object */
-    init_export_node (&exp_node);
-
 /* setting up the export NODE object */
     exp_node.id = node->id;
     exp_node.latitude = node->latitude;
     exp_node.longitude = node->longitude;
+    exp_node.fixed_latitude = node->fixed_latitude;
+    exp_node.fixed_longitude = node->fixed_longitude;
     exp_node.version = node->version;
     exp_node.changeset = node->changeset;
-    if (node->user != NULL)
-      {
-	  len = strlen (node->user);
-	  exp_node.user = malloc (len + 1);
-	  strcpy (exp_node.user, node->user);
-      }
+    exp_node.user = node->user;
     exp_node.uid = node->uid;
-    if (node->timestamp != NULL)
-      {
-	  len = strlen (node->timestamp);
-	  exp_node.timestamp = malloc (len + 1);
-	  strcpy (exp_node.timestamp, node->timestamp);
-      }
-
-/* setting up the NODE-TAGs array */
-    tag_blk = &(node->first_tag);
-    while (tag_blk)
-      {
-	  exp_node.tag_count += tag_blk->next_item;
-	  tag_blk = tag_blk->next;
-      }
-    if (exp_node.tag_count > 0)
-      {
-	  int i;
-	  readosm_export_tag *p_tag;
-	  exp_node.tags =
-	      malloc (sizeof (readosm_export_tag) * exp_node.tag_count);
-	  for (i = 0; i < exp_node.tag_count; i++)
-	    {
-		p_tag = exp_node.tags + i;
-		init_export_tag (p_tag);
-	    }
-	  i = 0;
-	  tag_blk = &(node->first_tag);
-	  while (tag_blk)
-	    {
-		for (i_tag = 0; i_tag < tag_blk->next_item; i_tag++)
-		  {
-		      tag = tag_blk->tags + i_tag;
-		      p_tag = exp_node.tags + i;
-		      if (tag->key != NULL)
-			{
-			    len = strlen (tag->key);
-			    p_tag->key = malloc (len + 1);
-			    strcpy (p_tag->key, tag->key);
-			}
-		      if (tag->value != NULL)
-			{
-			    len = strlen (tag->value);
-			    p_tag->value = malloc (len + 1);
-			    strcpy (p_tag->value, tag->value);
-			}
-		      i++;
-		  }
-		tag_blk = tag_blk->next;
-	    }
-      }
+    exp_node.timestamp = node->timestamp;
+    exp_node.timestamp_epoch = node->timestamp_epoch;
+    exp_node.tags = export_tags (&(node->first_tag), &(exp_node.tag_count));
 
 /* calling the user-defined NODE handling callback function */
     ret = (*node_callback) (user_data, readonly_node);
 
-/* resetting the export WAY object */
-    reset_export_node (&exp_node);
+    release_export_tags (exp_node.tags, &(node->first_tag));
     return ret;
 }
 
@@ -695,13 +455,6 @@ call_way_callback (readosm_way_callback way_callback,
 {
 /* calling the Way-handling callback function */
     int ret;
-    int len;
-    int i;
-    readosm_internal_ref *ref;
-    readosm_internal_tag *tag;
-    readosm_internal_tag_block *tag_blk;
-    int i_tag;
-    int i_ref;
     readosm_export_way exp_way;
 
 /* 
@@ -710,99 +463,25 @@ call_way_callback (readosm_way_callback way_callback,
 */
     readosm_way *readonly_way = (readosm_way *) & exp_way;
 
-/*initialing an empty export WAY object */
-    init_export_way (&exp_way);
-
+/* setting up the export WAY object */
     exp_way.id = way->id;
     exp_way.version = way->version;
     exp_way.changeset = way->changeset;
-    if (way->user != NULL)
-      {
-	  len = strlen (way->user);
-	  exp_way.user = malloc (len + 1);
-	  strcpy (exp_way.user, way->user);
-      }
+    exp_way.user = way->user;
     exp_way.uid = way->uid;
-    if (way->timestamp != NULL)
-      {
-	  len = strlen (way->timestamp);
-	  exp_way.timestamp = malloc (len + 1);
-	  strcpy (exp_way.timestamp, way->timestamp);
-      }
-
-    ref = &(way->first_ref);
-    while (ref)
-      {
-	  exp_way.node_ref_count += ref->next_item;
-	  ref = ref->next;
-      }
-
-/* setting up the NODE-REFs array */
-    if (exp_way.node_ref_count > 0)
-      {
-	  exp_way.node_refs =
-	      malloc (sizeof (long long) * exp_way.node_ref_count);
-	  i = 0;
-	  ref = &(way->first_ref);
-	  while (ref)
-	    {
-		for (i_ref = 0; i_ref < ref->next_item; i_ref++)
-		  {
-		      *(exp_way.node_refs + i) = *(ref->node_refs + i_ref);
-		      i++;
-		  }
-		ref = ref->next;
-	    }
-      }
-
-/* setting up the WAY-TAGs array */
-    tag_blk = &(way->first_tag);
-    while (tag_blk)
-      {
-	  exp_way.tag_count += tag_blk->next_item;
-	  tag_blk = tag_blk->next;
-      }
-    if (exp_way.tag_count > 0)
-      {
-	  readosm_export_tag *p_tag;
-	  exp_way.tags =
-	      malloc (sizeof (readosm_export_tag) * exp_way.tag_count);
-	  for (i = 0; i < exp_way.tag_count; i++)
-	    {
-		p_tag = exp_way.tags + i;
-		init_export_tag (p_tag);
-	    }
-	  i = 0;
-	  tag_blk = &(way->first_tag);
-	  while (tag_blk)
-	    {
-		for (i_tag = 0; i_tag < tag_blk->next_item; i_tag++)
-		  {
-		      tag = tag_blk->tags + i_tag;
-		      p_tag = exp_way.tags + i;
-		      if (tag->key != NULL)
-			{
-			    len = strlen (tag->key);
-			    p_tag->key = malloc (len + 1);
-			    strcpy (p_tag->key, tag->key);
-			}
-		      if (tag->value != NULL)
-			{
-			    len = strlen (tag->value);
-			    p_tag->value = malloc (len + 1);
-			    strcpy (p_tag->value, tag->value);
-			}
-		      i++;
-		  }
-		tag_blk = tag_blk->next;
-	    }
-      }
+    exp_way.timestamp = way->timestamp;
+    exp_way.timestamp_epoch = way->timestamp_epoch;
+    exp_way.node_refs =
+	export_refs (&(way->first_ref), &(exp_way.node_ref_count));
+    exp_way.tags = export_tags (&(way->first_tag), &(exp_way.tag_count));
 
 /* calling the user-defined WAY handling callback function */
     ret = (*way_callback) (user_data, readonly_way);
 
-/* resetting the export WAY object */
-    reset_export_way (&exp_way);
+    if (exp_way.node_refs != NULL
+	&& exp_way.node_refs != way->first_ref.node_refs)
+	free (exp_way.node_refs);
+    release_export_tags (exp_way.tags, &(way->first_tag));
     return ret;
 }
 
@@ -813,14 +492,6 @@ call_relation_callback (readosm_relation_callback relation_callback,
 {
 /* calling the Relation-handling callback function */
     int ret;
-    int len;
-    int i;
-    readosm_internal_member *member;
-    readosm_internal_member_block *mbr_blk;
-    int i_mbr;
-    readosm_internal_tag *tag;
-    readosm_internal_tag_block *tag_blk;
-    int i_tag;
     readosm_export_relation exp_relation;
 
 /* 
@@ -829,113 +500,170 @@ call_relation_callback (readosm_relation_callback relation_callback,
 */
     readosm_relation *readonly_relation = (readosm_relation *) & exp_relation;
 
-/*initialing an empty export RELATION object */
-    init_export_relation (&exp_relation);
-
+/* setting up the export RELATION object */
     exp_relation.id = relation->id;
     exp_relation.version = relation->version;
     exp_relation.changeset = relation->changeset;
-    if (relation->user != NULL)
-      {
-	  len = strlen (relation->user);
-	  exp_relation.user = malloc (len + 1);
-	  strcpy (exp_relation.user, relation->user);
-      }
+    exp_relation.user = relation->user;
     exp_relation.uid = relation->uid;
-    if (relation->timestamp != NULL)
-      {
-	  len = strlen (relation->timestamp);
-	  exp_relation.timestamp = malloc (len + 1);
-	  strcpy (exp_relation.timestamp, relation->timestamp);
-      }
+    exp_relation.timestamp = relation->timestamp;
+    exp_relation.timestamp_epoch = relation->timestamp_epoch;
+    exp_relation.members =
+	export_members (&(relation->first_member),
+			&(exp_relation.member_count));
+    exp_relation.tags =
+	export_tags (&(relation->first_tag), &(exp_relation.tag_count));
 
-/* setting up the RELATION-MEMBERs array */
-    mbr_blk = &(relation->first_member);
-    while (mbr_blk)
-      {
-	  exp_relation.member_count += mbr_blk->next_item;
-	  mbr_blk = mbr_blk->next;
-      }
-    if (exp_relation.member_count > 0)
-      {
-	  readosm_export_member *p_member;
-	  exp_relation.members =
-	      malloc (sizeof (readosm_export_member) *
-		      exp_relation.member_count);
-	  for (i = 0; i < exp_relation.member_count; i++)
-	    {
-		p_member = exp_relation.members + i;
-		init_export_member (p_member);
-	    }
-	  i = 0;
-	  mbr_blk = &(relation->first_member);
-	  while (mbr_blk)
-	    {
-		for (i_mbr = 0; i_mbr < mbr_blk->next_item; i_mbr++)
-		  {
-		      member = mbr_blk->members + i_mbr;
-		      p_member = exp_relation.members + i;
-		      p_member->member_type = member->member_type;
-		      p_member->id = member->id;
-		      if (member->role != NULL)
-			{
-			    len = strlen (member->role);
-			    p_member->role = malloc (len + 1);
-			    strcpy (p_member->role, member->role);
-			}
-		      i++;
-		  }
-		mbr_blk = mbr_blk->next;
-	    }
-      }
+/* calling the user-defined RELATION handling callback function */
+    ret = (*relation_callback) (user_data, readonly_relation);
 
-/* setting up the RELATION-TAGs array */
-    tag_blk = &(relation->first_tag);
-    while (tag_blk)
-      {
-	  exp_relation.tag_count += tag_blk->next_item;
-	  tag_blk = tag_blk->next;
-      }
-    if (exp_relation.tag_count > 0)
+    if (exp_relation.members != NULL
+	&& exp_relation.members !=
+	(readosm_export_member *) (relation->first_member.members))
+	free (exp_relation.members);
+    release_export_tags (exp_relation.tags, &(relation->first_tag));
+    return ret;
+}
+
+READOSM_PRIVATE int
+format_iso8601 (long long epoch, char *buffer)
+{
+/* 
+ / formatting a timestamp (seconds since the epoch) as an ISO-8601
+ / string; BUFFER must be at least READOSM_TIMESTAMP_SIZE bytes
+ /
+ / a plain proleptic Gregorian calendar conversion is used instead of
+ / gmtime(), which is both slower and not necessarily thread-safe
+*/
+    long long days;
+    long long secs;
+    long long era;
+    long long doe;
+    long long yoe;
+    long long doy;
+    long long mp;
+    long long year;
+    int month;
+    int day;
+    *buffer = '\0';
+    if (epoch == READOSM_UNDEFINED)
+	return 0;
+    days = epoch / 86400;
+    secs = epoch % 86400;
+    if (secs < 0)
+      {
+	  secs += 86400;
+	  days -= 1;
+      }
+
+/* converting days since 1970-01-01 into a civil date */
+    days += 719468;
+    era = (days >= 0 ? days : days - 146096) / 146097;
+    doe = days - era * 146097;
+    yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    mp = (5 * doy + 2) / 153;
+    day = (int) (doy - (153 * mp + 2) / 5 + 1);
+    month = (int) (mp < 10 ? mp + 3 : mp - 9);
+    year = yoe + era * 400 + (month <= 2);
+    if (year < 0 || year > 9999)
+	return 0;
+
+/* "YYYY-MM-DDTHH:MM:SSZ" */
+    buffer[0] = '0' + (char) (year / 1000);
+    buffer[1] = '0' + (char) ((year / 100) % 10);
+    buffer[2] = '0' + (char) ((year / 10) % 10);
+    buffer[3] = '0' + (char) (year % 10);
+    buffer[4] = '-';
+    buffer[5] = '0' + (char) (month / 10);
+    buffer[6] = '0' + (char) (month % 10);
+    buffer[7] = '-';
+    buffer[8] = '0' + (char) (day / 10);
+    buffer[9] = '0' + (char) (day % 10);
+    buffer[10] = 'T';
+    buffer[11] = '0' + (char) (secs / 36000);
+    buffer[12] = '0' + (char) ((secs / 3600) % 10);
+    buffer[13] = ':';
+    buffer[14] = '0' + (char) ((secs % 3600) / 600);
+    buffer[15] = '0' + (char) (((secs % 3600) / 60) % 10);
+    buffer[16] = ':';
+    buffer[17] = '0' + (char) ((secs % 60) / 10);
+    buffer[18] = '0' + (char) (secs % 10);
+    buffer[19] = 'Z';
+    buffer[20] = '\0';
+    return 1;
+}
+
+static int
+parse_digits (const char *str, int count, int *value)
+{
+/* parsing a fixed number of decimal digits */
+    int i;
+    *value = 0;
+    for (i = 0; i < count; i++)
       {
-	  readosm_export_tag *p_tag;
-	  exp_relation.tags =
-	      malloc (sizeof (readosm_export_tag) * exp_relation.tag_count);
-	  for (i = 0; i < exp_relation.tag_count; i++)
-	    {
-		p_tag = exp_relation.tags + i;
-		init_export_tag (p_tag);
-	    }
-	  i = 0;
-	  tag_blk = &(relation->first_tag);
-	  while (tag_blk)
-	    {
-		for (i_tag = 0; i_tag < tag_blk->next_item; i_tag++)
-		  {
-		      tag = tag_blk->tags + i_tag;
-		      p_tag = exp_relation.tags + i;
-		      if (tag->key != NULL)
-			{
-			    len = strlen (tag->key);
-			    p_tag->key = malloc (len + 1);
-			    strcpy (p_tag->key, tag->key);
-			}
-		      if (tag->value != NULL)
-			{
-			    len = strlen (tag->value);
-			    p_tag->value = malloc (len + 1);
-			    strcpy (p_tag->value, tag->value);
-			}
-		      i++;
-		  }
-		tag_blk = tag_blk->next;
-	    }
+	  if (str[i] < '0' || str[i] > '9')
+	      return 0;
+	  *value = (*value * 10) + (str[i] - '0');
       }
+    return 1;
+}
 
-/* calling the user-defined RELATION handling callback function */
-    ret = (*relation_callback) (user_data, readonly_relation);
+READOSM_PRIVATE int
+parse_iso8601 (const char *str, long long *epoch)
+{
+/* 
+ / parsing an ISO-8601 UTC timestamp in the fixed format always
+ / used by OSM files: "YYYY-MM-DDTHH:MM:SSZ"
+ / returns 1 on success; EPOCH is left untouched on failure
+*/
+    int year;
+    int month;
+    int day;
+    int hour;
+    int minute;
+    int second;
+    long long era;
+    long long yoe;
+    long long doy;
+    long long doe;
+    if (!parse_digits (str, 4, &year) || str[4] != '-'
+	|| !parse_digits (str + 5, 2, &month) || str[7] != '-'
+	|| !parse_digits (str + 8, 2, &day) || str[10] != 'T'
+	|| !parse_digits (str + 11, 2, &hour) || str[13] != ':'
+	|| !parse_digits (str + 14, 2, &minute) || str[16] != ':'
+	|| !parse_digits (str + 17, 2, &second))
+	return 0;
+    if (str[19] != 'Z' && str[19] != '\0')
+	return 0;
+    if (month < 1 || month > 12 || day < 1 || day > 31 || hour > 23
+	|| minute > 59 || second > 60)
+	return 0;
+
+/* converting the civil date into days since 1970-01-01 */
+    if (month <= 2)
+	year -= 1;
+    era = (year >= 0 ? year : year - 399) / 400;
+    yoe = year - era * 400;
+    doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    *epoch =
+	(era * 146097 + doe - 719468) * 86400 + hour * 3600 + minute * 60 +
+	second;
+    return 1;
+}
 
-/* resetting the export RELATION object */
-    reset_export_relation (&exp_relation);
-    return ret;
+READOSM_PRIVATE int
+fixed_coordinate (double degrees)
+{
+/* 
+ / converting a coordinate into a fixed-point value (1e-7 degrees)
+ /
+ / READOSM_UNDEFINED (or any other value that cannot be represented
+ / as an int) is returned as READOSM_UNDEFINED_FIXED
+*/
+    double value = degrees * 10000000.0;
+    if (value <= -2147483648.0 || value >= 2147483647.0)
+	return READOSM_UNDEFINED_FIXED;
+    return (int) (value < 0.0 ? value - 0.5 : value + 0.5);
 }
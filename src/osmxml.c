@@ -66,6 +66,7 @@
 #endif
 
 #define BUFFSIZE	8192
+#define MAP_CHUNK	1048576
 
 struct xml_params
 {
@@ -79,6 +80,9 @@ struct xml_params
     readosm_internal_way way;
     readosm_internal_relation relation;
     int stop;
+    int skip_metadata;		/* ignoring any metadata attribute */
+    int lazy_timestamps;	/* not copying timestamp strings */
+    readosm_arena arena;	/* strings and blocks of the current element */
 };
 
 static void
@@ -96,11 +100,14 @@ xml_init_params (struct xml_params *params, const void *user_data,
     params->node.id = READOSM_UNDEFINED;
     params->node.latitude = READOSM_UNDEFINED;
     params->node.longitude = READOSM_UNDEFINED;
+    params->node.fixed_latitude = READOSM_UNDEFINED_FIXED;
+    params->node.fixed_longitude = READOSM_UNDEFINED_FIXED;
     params->node.version = READOSM_UNDEFINED;
     params->node.changeset = READOSM_UNDEFINED;
     params->node.user = NULL;
     params->node.uid = READOSM_UNDEFINED;
     params->node.timestamp = NULL;
+    params->node.timestamp_epoch = READOSM_UNDEFINED;
     params->node.tag_count = 0;
     params->node.first_tag.next_item = 0;
     params->node.first_tag.next = NULL;
@@ -112,6 +119,7 @@ xml_init_params (struct xml_params *params, const void *user_data,
     params->way.user = NULL;
     params->way.uid = READOSM_UNDEFINED;
     params->way.timestamp = NULL;
+    params->way.timestamp_epoch = READOSM_UNDEFINED;
     params->way.ref_count = 0;
     params->way.first_ref.next_item = 0;
     params->way.first_ref.next = NULL;
@@ -127,6 +135,7 @@ xml_init_params (struct xml_params *params, const void *user_data,
     params->relation.user = NULL;
     params->relation.uid = READOSM_UNDEFINED;
     params->relation.timestamp = NULL;
+    params->relation.timestamp_epoch = READOSM_UNDEFINED;
     params->relation.member_count = 0;
     params->relation.first_member.next_item = 0;
     params->relation.first_member.next = NULL;
@@ -142,92 +151,12 @@ xml_init_params (struct xml_params *params, const void *user_data,
 static void
 xml_reset_params (struct xml_params *params)
 {
-/* resetting the XML helper structure to initial empty state */
-    readosm_internal_tag_block *tag_blk;
-    readosm_internal_tag_block *tag_blk_n;
-    readosm_internal_ref *ref;
-    readosm_internal_ref *ref_n;
-    readosm_internal_member_block *mbr_blk;
-    readosm_internal_member_block *mbr_blk_n;
-
-    if (params->node.user)
-	free (params->node.user);
-    if (params->node.timestamp)
-
-	free (params->node.timestamp);
-    tag_blk = &(params->node.first_tag);
-    while (tag_blk)
-      {
-	  tag_blk_n = tag_blk->next;
-	  if (tag_blk == &(params->node.first_tag))
-	      release_internal_tag_block (tag_blk, 0);
-	  else
-	      release_internal_tag_block (tag_blk, 1);
-	  tag_blk = tag_blk_n;
-      }
-    params->node.first_tag.next_item = 0;
-    params->node.first_tag.next = NULL;
-    params->node.last_tag = &(params->node.first_tag);
-
-    if (params->way.user)
-	free (params->way.user);
-    if (params->way.timestamp)
-	free (params->way.timestamp);
-    ref = params->way.first_ref.next;
-    while (ref)
-      {
-	  ref_n = ref->next;
-	  free (ref);
-	  ref = ref_n;
-      }
-    params->way.first_ref.next_item = 0;
-    params->way.first_ref.next = NULL;
-    params->way.last_ref = &(params->way.first_ref);
-    tag_blk = &(params->way.first_tag);
-    while (tag_blk)
-      {
-	  tag_blk_n = tag_blk->next;
-	  if (tag_blk == &(params->way.first_tag))
-	      release_internal_tag_block (tag_blk, 0);
-	  else
-	      release_internal_tag_block (tag_blk, 1);
-	  tag_blk = tag_blk_n;
-      }
-    params->way.first_tag.next_item = 0;
-    params->way.first_tag.next = NULL;
-    params->way.last_tag = &(params->way.first_tag);
-
-    if (params->relation.user)
-	free (params->relation.user);
-    if (params->relation.timestamp)
-	free (params->relation.timestamp);
-    mbr_blk = &(params->relation.first_member);
-    while (mbr_blk)
-      {
-	  mbr_blk_n = mbr_blk->next;
-	  if (mbr_blk == &(params->relation.first_member))
-	      release_internal_member_block (mbr_blk, 0);
-	  else
-	      release_internal_member_block (mbr_blk, 1);
-	  mbr_blk = mbr_blk_n;
-      }
-    params->relation.first_member.next_item = 0;
-    params->relation.first_member.next = NULL;
-    params->relation.last_member = &(params->relation.first_member);
-    tag_blk = &(params->relation.first_tag);
-    while (tag_blk)
-      {
-	  tag_blk_n = tag_blk->next;
-	  if (tag_blk == &(params->relation.first_tag))
-	      release_internal_tag_block (tag_blk, 0);
-	  else
-	      release_internal_tag_block (tag_blk, 1);
-	  tag_blk = tag_blk_n;
-      }
-    params->relation.first_tag.next_item = 0;
-    params->relation.first_tag.next = NULL;
-    params->relation.last_tag = &(params->relation.first_tag);
-
+/* 
+ / resetting the XML helper structure to initial empty state
+ / all strings and blocks of the previous element are released
+ / at once by resetting the Arena
+*/
+    reset_arena (&(params->arena));
     xml_init_params (params, params->user_data, params->node_callback,
 		     params->way_callback, params->relation_callback,
 		     params->stop);
@@ -238,33 +167,43 @@ xml_start_node (struct xml_params *params, const char **attr)
 {
 /* an XML Node starts here */
     int i;
-    int len;
     xml_reset_params (params);
     for (i = 0; attr[i]; i += 2)
       {
 	  if (strcmp (attr[i], "id") == 0)
 	      params->node.id = atol_64 (attr[i + 1]);
 	  if (strcmp (attr[i], "lat") == 0)
-	      params->node.latitude = atof (attr[i + 1]);
+	    {
+		params->node.latitude = atof (attr[i + 1]);
+		params->node.fixed_latitude =
+		    fixed_coordinate (params->node.latitude);
+	    }
 	  if (strcmp (attr[i], "lon") == 0)
-	      params->node.longitude = atof (attr[i + 1]);
+	    {
+		params->node.longitude = atof (attr[i + 1]);
+		params->node.fixed_longitude =
+		    fixed_coordinate (params->node.longitude);
+	    }
+	  if (params->skip_metadata)
+	      continue;
 	  if (strcmp (attr[i], "version") == 0)
 	      params->node.version = atoi (attr[i + 1]);
 	  if (strcmp (attr[i], "changeset") == 0)
 	      params->node.changeset = atol_64 (attr[i + 1]);
 	  if (strcmp (attr[i], "user") == 0)
 	    {
-		len = strlen (attr[i + 1]);
-		params->node.user = malloc (len + 1);
-		strcpy (params->node.user, attr[i + 1]);
+		params->node.user =
+		    arena_strdup (&(params->arena), attr[i + 1]);
 	    }
 	  if (strcmp (attr[i], "uid") == 0)
 	      params->node.uid = atoi (attr[i + 1]);
 	  if (strcmp (attr[i], "timestamp") == 0)
 	    {
-		len = strlen (attr[i + 1]);
-		params->node.timestamp = malloc (len + 1);
-		strcpy (params->node.timestamp, attr[i + 1]);
+		parse_iso8601 (attr[i + 1], &(params->node.timestamp_epoch));
+		if (params->lazy_timestamps)
+		    continue;
+		params->node.timestamp =
+		    arena_strdup (&(params->arena), attr[i + 1]);
 	    }
       }
     params->current_tag = READOSM_CURRENT_TAG_IS_NODE;
@@ -290,29 +229,31 @@ xml_start_way (struct xml_params *params, const char **attr)
 {
 /* an XML Way starts here */
     int i;
-    int len;
     xml_reset_params (params);
     for (i = 0; attr[i]; i += 2)
       {
 	  if (strcmp (attr[i], "id") == 0)
 	      params->way.id = atol_64 (attr[i + 1]);
+	  if (params->skip_metadata)
+	      continue;
 	  if (strcmp (attr[i], "version") == 0)
 	      params->way.version = atoi (attr[i + 1]);
 	  if (strcmp (attr[i], "changeset") == 0)
 	      params->way.changeset = atol_64 (attr[i + 1]);
 	  if (strcmp (attr[i], "user") == 0)
 	    {
-		len = strlen (attr[i + 1]);
-		params->way.user = malloc (len + 1);
-		strcpy (params->way.user, attr[i + 1]);
+		params->way.user =
+		    arena_strdup (&(params->arena), attr[i + 1]);
 	    }
 	  if (strcmp (attr[i], "uid") == 0)
 	      params->way.uid = atoi (attr[i + 1]);
 	  if (strcmp (attr[i], "timestamp") == 0)
 	    {
-		len = strlen (attr[i + 1]);
-		params->way.timestamp = malloc (len + 1);
-		strcpy (params->way.timestamp, attr[i + 1]);
+		parse_iso8601 (attr[i + 1], &(params->way.timestamp_epoch));
+		if (params->lazy_timestamps)
+		    continue;
+		params->way.timestamp =
+		    arena_strdup (&(params->arena), attr[i + 1]);
 	    }
       }
     params->current_tag = READOSM_CURRENT_TAG_IS_WAY;
@@ -337,29 +278,31 @@ xml_start_relation (struct xml_params *params, const char **attr)
 {
 /* an XML Relation starts here */
     int i;
-    int len;
     xml_reset_params (params);
     for (i = 0; attr[i]; i += 2)
       {
 	  if (strcmp (attr[i], "id") == 0)
 	      params->relation.id = atol_64 (attr[i + 1]);
+	  if (params->skip_metadata)
+	      continue;
 	  if (strcmp (attr[i], "version") == 0)
 	      params->relation.version = atoi (attr[i + 1]);
 	  if (strcmp (attr[i], "changeset") == 0)
 	      params->relation.changeset = atol_64 (attr[i + 1]);
 	  if (strcmp (attr[i], "user") == 0)
 	    {
-		len = strlen (attr[i + 1]);
-		params->relation.user = malloc (len + 1);
-		strcpy (params->relation.user, attr[i + 1]);
+		params->relation.user =
+		    arena_strdup (&(params->arena), attr[i + 1]);
 	    }
 	  if (strcmp (attr[i], "uid") == 0)
 	      params->relation.uid = atoi (attr[i + 1]);
 	  if (strcmp (attr[i], "timestamp") == 0)
 	    {
-		len = strlen (attr[i + 1]);
-		params->relation.timestamp = malloc (len + 1);
-		strcpy (params->relation.timestamp, attr[i + 1]);
+		parse_iso8601 (attr[i + 1], &(params->relation.timestamp_epoch));
+		if (params->lazy_timestamps)
+		    continue;
+		params->relation.timestamp =
+		    arena_strdup (&(params->arena), attr[i + 1]);
 	    }
       }
     params->current_tag = READOSM_CURRENT_TAG_IS_RELATION;
@@ -386,6 +329,8 @@ xml_start_xtag (struct xml_params *params, const char **attr)
 /* an XML Tag starts here */
     const char *key = NULL;
     const char *value = NULL;
+    char *k;
+    char *v;
     int i;
 
     if (params->current_tag == READOSM_CURRENT_TAG_IS_NODE
@@ -399,12 +344,15 @@ xml_start_xtag (struct xml_params *params, const char **attr)
 		if (strcmp (attr[i], "v") == 0)
 		    value = attr[i + 1];
 	    }
+	  k = arena_strdup (&(params->arena), key);
+	  v = arena_strdup (&(params->arena), value);
 	  if (params->current_tag == READOSM_CURRENT_TAG_IS_NODE)
-	      append_tag_to_node (&(params->node), key, value);
+	      append_tag_to_node (&(params->node), &(params->arena), k, v);
 	  if (params->current_tag == READOSM_CURRENT_TAG_IS_WAY)
-	      append_tag_to_way (&(params->way), key, value);
+	      append_tag_to_way (&(params->way), &(params->arena), k, v);
 	  if (params->current_tag == READOSM_CURRENT_TAG_IS_RELATION)
-	      append_tag_to_relation (&(params->relation), key, value);
+	      append_tag_to_relation (&(params->relation), &(params->arena), k,
+				      v);
       }
 }
 
@@ -419,7 +367,7 @@ xml_start_nd (struct xml_params *params, const char **attr)
 	  for (i = 0; attr[i]; i += 2)
 	    {
 		if (strcmp (attr[i], "ref") == 0)
-		    append_reference_to_way (&(params->way),
+		    append_reference_to_way (&(params->way), &(params->arena),
 					     atol_64 (attr[i + 1]));
 	    }
       }
@@ -452,7 +400,9 @@ xml_start_member (struct xml_params *params, const char **attr)
 		if (strcmp (attr[i], "role") == 0)
 		    role = attr[i + 1];
 	    }
-	  append_member_to_relation (&(params->relation), type, id, role);
+	  append_member_to_relation (&(params->relation), &(params->arena),
+				     type, id,
+				     arena_strdup (&(params->arena), role));
       }
 }
 
@@ -496,32 +446,61 @@ parse_osm_xml (readosm_file * input, const void *user_data,
 /* parsing the input file [OSM XML format] */
     XML_Parser parser;
     char xml_buff[BUFFSIZE];
+    const char *chunk;
     int done = 0;
     int len;
+    int ret = READOSM_OK;
     struct xml_params params;
 
     xml_init_params (&params, user_data, node_fnct, way_fnct, relation_fnct, 0);
+    params.skip_metadata = (input->options & READOSM_SKIP_METADATA) ? 1 : 0;
+    params.lazy_timestamps =
+	(input->options & READOSM_LAZY_TIMESTAMPS) ? 1 : 0;
 
     parser = XML_ParserCreate (NULL);
     if (!parser)
 	return READOSM_CREATE_XML_PARSER_ERROR;
+    init_arena (&(params.arena));
 
     XML_SetUserData (parser, &params);
     XML_SetElementHandler (parser, xml_start_tag, xml_end_tag);
     while (!done)
       {
-	  len = fread (xml_buff, 1, BUFFSIZE, input->in);
-	  if (ferror (input->in))
-	      return READOSM_READ_ERROR;
-	  done = feof (input->in);
-	  if (!XML_Parse (parser, xml_buff, len, done))
-	      return READOSM_XML_ERROR;
+	  if (input->map != NULL)
+	    {
+		/* memory-mapped input: feeding Expat straight from the mapped pages */
+		size_t left = input->map_size - input->map_pos;
+		len = (left > MAP_CHUNK) ? MAP_CHUNK : (int) left;
+		chunk = (const char *) (input->map + input->map_pos);
+		input->map_pos += len;
+		done = (input->map_pos == input->map_size);
+	    }
+	  else
+	    {
+		len = fread (xml_buff, 1, BUFFSIZE, input->in);
+		if (ferror (input->in))
+		  {
+		      ret = READOSM_READ_ERROR;
+		      break;
+		  }
+		done = feof (input->in);
+		chunk = xml_buff;
+	    }
+	  if (!XML_Parse (parser, chunk, len, done))
+	    {
+		ret = READOSM_XML_ERROR;
+		break;
+	    }
 	  if (params.stop)
-	      return READOSM_ABORT;
+	    {
+		ret = READOSM_ABORT;
+		break;
+	    }
       }
     XML_ParserFree (parser);
+    finalize_arena (&(params.arena));
 
-    return READOSM_OK;
+    return ret;
 }
 
 READOSM_DECLARE const char *
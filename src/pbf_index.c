@@ -0,0 +1,389 @@
+/* 
+/ pbf_index.c
+/
+/ persistent PBF block index (.pbf.idx sidecar file)
+/
+/ Author: the ReadOSM contributors, 2026
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the ReadOSM library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2012-2017
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/ 
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <zlib.h>
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include "config-msvc.h"
+#else
+#include "config.h"
+#endif
+
+#include "readosm.h"
+#include "readosm_internals.h"
+#include "readosm_protobuf.h"
+
+/*
+ * the .pbf.idx sidecar file layout (all values are little-endian)
+ *
+ * header [32 bytes]:
+ *   magic [8 bytes]          "RDOSMIDX"
+ *   version [uint32]         READOSM_IDX_VERSION
+ *   block count [uint32]
+ *   PBF file size [int64]    used for validation
+ *   PBF file mtime [int64]   used for validation
+ *
+ * followed by one entry for each OSMData block [36 bytes]:
+ *   file offset [int64]
+ *   BlobHeader size [uint32]
+ *   Blob size [uint32]
+ *   object types [uint32]    bitmask of READOSM_BLOCK_xx
+ *   min object ID [int64]
+ *   max object ID [int64]
+ */
+#define READOSM_IDX_MAGIC	"RDOSMIDX"
+#define READOSM_IDX_VERSION	1
+#define READOSM_IDX_HDR_SZ	32
+#define READOSM_IDX_ENTRY_SZ	36
+
+static void
+put_uint32 (unsigned char *p, unsigned int value)
+{
+/* encoding a little-endian uint32 */
+    p[0] = value & 0xff;
+    p[1] = (value >> 8) & 0xff;
+    p[2] = (value >> 16) & 0xff;
+    p[3] = (value >> 24) & 0xff;
+}
+
+static void
+put_int64 (unsigned char *p, long long value)
+{
+/* encoding a little-endian int64 */
+    unsigned long long v = (unsigned long long) value;
+    put_uint32 (p, (unsigned int) (v & 0xffffffff));
+    put_uint32 (p + 4, (unsigned int) (v >> 32));
+}
+
+static unsigned int
+get_uint32 (const unsigned char *p)
+{
+/* decoding a little-endian uint32 */
+    return (unsigned int) p[0] | ((unsigned int) p[1] << 8) |
+	((unsigned int) p[2] << 16) | ((unsigned int) p[3] << 24);
+}
+
+static long long
+get_int64 (const unsigned char *p)
+{
+/* decoding a little-endian int64 */
+    unsigned long long v = get_uint32 (p + 4);
+    v = (v << 32) | get_uint32 (p);
+    return (long long) v;
+}
+
+static void
+update_block (readosm_export_block * blk, int type, long long id)
+{
+/* updating object types and ID range of a block */
+    if (blk->object_types == 0)
+      {
+	  blk->min_id = id;
+	  blk->max_id = id;
+      }
+    if (id < blk->min_id)
+	blk->min_id = id;
+    if (id > blk->max_id)
+	blk->max_id = id;
+    blk->object_types |= type;
+}
+
+static int
+index_node (const void *user_data, const readosm_node * node)
+{
+/* NODE callback: updating the block index */
+    update_block ((readosm_export_block *) user_data, READOSM_BLOCK_NODES,
+		  node->id);
+    return READOSM_OK;
+}
+
+static int
+index_way (const void *user_data, const readosm_way * way)
+{
+/* WAY callback: updating the block index */
+    update_block ((readosm_export_block *) user_data, READOSM_BLOCK_WAYS,
+		  way->id);
+    return READOSM_OK;
+}
+
+static int
+index_relation (const void *user_data, const readosm_relation * relation)
+{
+/* RELATION callback: updating the block index */
+    update_block ((readosm_export_block *) user_data,
+		  READOSM_BLOCK_RELATIONS, relation->id);
+    return READOSM_OK;
+}
+
+static int
+detail_block_index (readosm_file * input)
+{
+/* 
+ / completing the block index by decoding each block, so 
+ / to collect object types and ID ranges
+*/
+    int i;
+    int ret;
+    long long current;
+    readosm_pbf_blob blob;
+    struct pbf_params params;
+    readosm_pbf_decoder *decoder;
+
+    ret = build_block_index (input);
+    if (ret != READOSM_OK)
+	return ret;
+    if (input->detailed_index)
+	return READOSM_OK;
+
+    decoder = get_pbf_decoder (input);
+    if (decoder == NULL)
+	return READOSM_INSUFFICIENT_MEMORY;
+    current = tell_osm_file (input);
+    params.node_callback = index_node;
+    params.way_callback = index_way;
+    params.relation_callback = index_relation;
+    params.node_batch_callback = NULL;
+    params.way_batch_callback = NULL;
+    params.relation_batch_callback = NULL;
+    params.node_columns_callback = NULL;
+    params.stop = 0;
+    params.skip_metadata = 1;
+    params.lazy_timestamps = 1;
+    for (i = 0; i < input->block_count; i++)
+      {
+	  readosm_export_block *blk = input->blocks + i;
+	  blk->object_types = 0;
+	  blk->min_id = 0;
+	  blk->max_id = 0;
+	  if (!seek_osm_file (input, blk->file_offset))
+	    {
+		ret = READOSM_READ_ERROR;
+		goto stop;
+	    }
+	  if (read_osm_blob (input, &blob) <= 0)
+	    {
+		ret = READOSM_INVALID_PBF_HEADER;
+		goto stop;
+	    }
+	  params.user_data = blk;
+	  ret =
+	      parse_osm_blob (decoder, &blob, input->little_endian_cpu,
+			      &params);
+	  release_osm_blob (&blob);
+	  if (ret != READOSM_OK)
+	      goto stop;
+      }
+    ret = READOSM_OK;
+    input->detailed_index = 1;
+
+  stop:
+    seek_osm_file (input, current);
+    return ret;
+}
+
+static char *
+sidecar_path (const char *path)
+{
+/* building the sidecar file path: <path>.idx */
+    size_t len = strlen (path);
+    char *idx_path = malloc (len + 5);
+    if (idx_path == NULL)
+	return NULL;
+    memcpy (idx_path, path, len);
+    strcpy (idx_path + len, ".idx");
+    return idx_path;
+}
+
+READOSM_PRIVATE int
+write_block_index (readosm_file * input)
+{
+/* writing the .pbf.idx sidecar file */
+    int i;
+    int ret;
+    char *idx_path;
+    FILE *out;
+    struct stat st;
+    unsigned char hdr[READOSM_IDX_HDR_SZ];
+    unsigned char entry[READOSM_IDX_ENTRY_SZ];
+
+    if (input->path == NULL)
+	return READOSM_WRITE_ERROR;
+    if (stat (input->path, &st) != 0)
+	return READOSM_READ_ERROR;
+    ret = detail_block_index (input);
+    if (ret != READOSM_OK)
+	return ret;
+
+    idx_path = sidecar_path (input->path);
+    if (idx_path == NULL)
+	return READOSM_INSUFFICIENT_MEMORY;
+    out = fopen (idx_path, "wb");
+    if (out == NULL)
+      {
+	  free (idx_path);
+	  return READOSM_WRITE_ERROR;
+      }
+
+    memcpy (hdr, READOSM_IDX_MAGIC, 8);
+    put_uint32 (hdr + 8, READOSM_IDX_VERSION);
+    put_uint32 (hdr + 12, input->block_count);
+    put_int64 (hdr + 16, st.st_size);
+    put_int64 (hdr + 24, st.st_mtime);
+    if (fwrite (hdr, 1, READOSM_IDX_HDR_SZ, out) != READOSM_IDX_HDR_SZ)
+	goto error;
+    for (i = 0; i < input->block_count; i++)
+      {
+	  readosm_export_block *blk = input->blocks + i;
+	  put_int64 (entry, blk->file_offset);
+	  put_uint32 (entry + 8, blk->header_size);
+	  put_uint32 (entry + 12, blk->datasize);
+	  put_uint32 (entry + 16, blk->object_types);
+	  put_int64 (entry + 20, blk->min_id);
+	  put_int64 (entry + 28, blk->max_id);
+	  if (fwrite (entry, 1, READOSM_IDX_ENTRY_SZ, out) !=
+	      READOSM_IDX_ENTRY_SZ)
+	      goto error;
+      }
+    if (fclose (out) != 0)
+      {
+	  out = NULL;
+	  goto error;
+      }
+    free (idx_path);
+    return READOSM_OK;
+
+  error:
+    if (out != NULL)
+	fclose (out);
+    remove (idx_path);
+    free (idx_path);
+    return READOSM_WRITE_ERROR;
+}
+
+READOSM_PRIVATE void
+load_block_index (readosm_file * input)
+{
+/* 
+ / attempting to load the .pbf.idx sidecar file
+ / any missing, stale or invalid sidecar will be silently ignored
+*/
+    int i;
+    unsigned int count;
+    long long file_size;
+    long long next_offset = 0;
+    char *idx_path;
+    FILE *in = NULL;
+    struct stat st;
+    unsigned char hdr[READOSM_IDX_HDR_SZ];
+    unsigned char entry[READOSM_IDX_ENTRY_SZ];
+    readosm_export_block *blocks = NULL;
+
+    if (input->path == NULL || input->blocks != NULL)
+	return;
+    if (stat (input->path, &st) != 0)
+	return;
+    idx_path = sidecar_path (input->path);
+    if (idx_path == NULL)
+	return;
+    in = fopen (idx_path, "rb");
+    free (idx_path);
+    if (in == NULL)
+	return;
+
+/* validating the header */
+    if (fread (hdr, 1, READOSM_IDX_HDR_SZ, in) != READOSM_IDX_HDR_SZ)
+	goto error;
+    if (memcmp (hdr, READOSM_IDX_MAGIC, 8) != 0)
+	goto error;
+    if (get_uint32 (hdr + 8) != READOSM_IDX_VERSION)
+	goto error;
+    count = get_uint32 (hdr + 12);
+    file_size = get_int64 (hdr + 16);
+    if (file_size != (long long) (st.st_size)
+	|| get_int64 (hdr + 24) != (long long) (st.st_mtime))
+	goto error;		/* stale sidecar */
+    if (count == 0 || count > (unsigned int) (file_size / 8))
+	goto error;
+
+/* loading the block entries */
+    blocks = malloc (sizeof (readosm_export_block) * count);
+    if (blocks == NULL)
+	goto error;
+    for (i = 0; i < (int) count; i++)
+      {
+	  readosm_export_block *blk = blocks + i;
+	  if (fread (entry, 1, READOSM_IDX_ENTRY_SZ, in) !=
+	      READOSM_IDX_ENTRY_SZ)
+	      goto error;
+	  blk->file_offset = get_int64 (entry);
+	  blk->header_size = get_uint32 (entry + 8);
+	  blk->datasize = get_uint32 (entry + 12);
+	  blk->object_types = get_uint32 (entry + 16);
+	  blk->min_id = get_int64 (entry + 20);
+	  blk->max_id = get_int64 (entry + 28);
+	  if (blk->file_offset < next_offset)
+	      goto error;
+	  next_offset =
+	      blk->file_offset + 4 + (long long) blk->header_size +
+	      blk->datasize;
+	  if (next_offset > file_size)
+	      goto error;
+      }
+    fclose (in);
+    input->blocks = blocks;
+    input->block_count = count;
+    input->detailed_index = 1;
+    return;
+
+  error:
+    if (blocks != NULL)
+	free (blocks);
+    fclose (in);
+}
@@ -0,0 +1,805 @@
+/* 
+/ pbf_threads.c
+/
+/ multi-threaded Protocol Buffer (.pbf) decoding
+/
+/ Author: the ReadOSM contributors, 2026
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the ReadOSM library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2012-2017
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/ 
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include "config-msvc.h"
+#else
+#include "config.h"
+#endif
+
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+#include <zlib.h>
+
+#include "readosm.h"
+#include "readosm_internals.h"
+#include "readosm_protobuf.h"
+
+#ifdef HAVE_PTHREAD_H		/* POSIX threads are supported */
+
+/* maximum number of worker threads */
+#define MAX_THREADS	256
+
+/* job states */
+#define JOB_FREE	0
+#define JOB_PENDING	1
+#define JOB_DONE	2
+
+struct pbf_record
+{
+/* a decoded object waiting to be delivered in file order */
+    int type;			/* object type [READOSM_CURRENT_TAG_IS_xx] */
+    union pbf_record_object
+    {
+	readosm_export_node node;
+	readosm_export_way way;
+	readosm_export_relation relation;
+    } obj;
+};
+
+struct pbf_job
+{
+/* a single OSMData Blob going through the worker pool */
+    int state;			/* current state [JOB_xx] */
+    readosm_pbf_blob blob;	/* the raw (still compressed) Blob */
+    int ret;			/* decoding result [READOSM_xx] */
+    struct pbf_record *records;	/* decoded objects */
+    int rec_count;		/* how many records are there */
+    int rec_max;		/* how many records are allocated */
+    readosm_arena arena;	/* strings and arrays supporting records */
+};
+
+struct pbf_pool
+{
+/* the worker pool supporting multi-threaded PBF decoding */
+    pthread_mutex_t mutex;	/* protecting any field below */
+    pthread_cond_t job_ready;	/* a Blob is ready to be decoded */
+    pthread_cond_t job_done;	/* a Blob has been decoded */
+    struct pbf_job *jobs;	/* ring buffer of in-flight Blobs */
+    int max_jobs;		/* ring buffer capacity */
+    int next_read;		/* sequence of the next Blob to be read */
+    int next_decode;		/* sequence of the next Blob to be decoded */
+    int shutdown;		/* no further Blob will be queued */
+    int abort;			/* any pending Blob should be discarded */
+    int ordered;		/* objects must be delivered in file order */
+    int ret;			/* first error raised by a worker [unordered] */
+    char little_endian_cpu;	/* actual CPU endianness */
+    int skip_metadata;		/* READOSM_SKIP_METADATA */
+    int lazy_timestamps;	/* READOSM_LAZY_TIMESTAMPS */
+    const void *user_data;	/* the user-supplied data */
+    const void **thread_data;	/* per-thread user data [unordered] */
+    pthread_t *workers;		/* the worker threads */
+    int started;		/* how many worker threads are running */
+    readosm_node_callback node_callback;
+    readosm_way_callback way_callback;
+    readosm_relation_callback relation_callback;
+};
+
+static struct pbf_record *
+alloc_record (struct pbf_job *job, int type)
+{
+/* appending a further record to the job */
+    struct pbf_record *rec;
+    if (job->rec_count == job->rec_max)
+      {
+	  int max = (job->rec_max == 0) ? 1024 : job->rec_max * 2;
+	  rec = realloc (job->records, sizeof (struct pbf_record) * max);
+	  if (rec == NULL)
+	      return NULL;
+	  job->records = rec;
+	  job->rec_max = max;
+      }
+    rec = job->records + job->rec_count;
+    job->rec_count += 1;
+    rec->type = type;
+    return rec;
+}
+
+static int
+record_string (struct pbf_job *job, char **dest, const char *str)
+{
+/* copying a string into the job Arena */
+    *dest = NULL;
+    if (str == NULL)
+	return 1;
+    *dest = arena_strdup (&(job->arena), str);
+    return (*dest != NULL);
+}
+
+static int
+record_tags (struct pbf_job *job, readosm_export_tag ** dest, int count,
+	     const readosm_tag * tags)
+{
+/* copying an array of TAGs into the job Arena */
+    int i;
+    *dest = NULL;
+    if (count <= 0)
+	return 1;
+    *dest = arena_alloc (&(job->arena), sizeof (readosm_export_tag) * count);
+    if (*dest == NULL)
+	return 0;
+    for (i = 0; i < count; i++)
+      {
+	  readosm_export_tag *tag = *dest + i;
+	  if (!record_string (job, &(tag->key), (tags + i)->key))
+	      return 0;
+	  if (!record_string (job, &(tag->value), (tags + i)->value))
+	      return 0;
+      }
+    return 1;
+}
+
+static int
+record_node (const void *user_data, const readosm_node * node)
+{
+/* NODE callback: recording the Node for later delivery */
+    struct pbf_job *job = (struct pbf_job *) user_data;
+    readosm_export_node *nd;
+    struct pbf_record *rec = alloc_record (job, READOSM_CURRENT_TAG_IS_NODE);
+    if (rec == NULL)
+	goto error;
+    nd = &(rec->obj.node);
+    nd->id = node->id;
+    nd->latitude = node->latitude;
+    nd->longitude = node->longitude;
+    nd->fixed_latitude = node->fixed_latitude;
+    nd->fixed_longitude = node->fixed_longitude;
+    nd->version = node->version;
+    nd->changeset = node->changeset;
+    nd->uid = node->uid;
+    nd->timestamp_epoch = node->timestamp_epoch;
+    nd->tag_count = node->tag_count;
+    if (!record_string (job, &(nd->user), node->user))
+	goto error;
+    if (!record_string (job, &(nd->timestamp), node->timestamp))
+	goto error;
+    if (!record_tags (job, &(nd->tags), node->tag_count, node->tags))
+	goto error;
+    return READOSM_OK;
+
+  error:
+    job->ret = READOSM_INSUFFICIENT_MEMORY;
+    return READOSM_INSUFFICIENT_MEMORY;
+}
+
+static int
+record_way (const void *user_data, const readosm_way * way)
+{
+/* WAY callback: recording the Way for later delivery */
+    struct pbf_job *job = (struct pbf_job *) user_data;
+    readosm_export_way *wy;
+    struct pbf_record *rec = alloc_record (job, READOSM_CURRENT_TAG_IS_WAY);
+    if (rec == NULL)
+	goto error;
+    wy = &(rec->obj.way);
+    wy->id = way->id;
+    wy->version = way->version;
+    wy->changeset = way->changeset;
+    wy->uid = way->uid;
+    wy->timestamp_epoch = way->timestamp_epoch;
+    wy->node_ref_count = way->node_ref_count;
+    wy->tag_count = way->tag_count;
+    wy->node_refs = NULL;
+    if (!record_string (job, &(wy->user), way->user))
+	goto error;
+    if (!record_string (job, &(wy->timestamp), way->timestamp))
+	goto error;
+    if (way->node_ref_count > 0)
+      {
+	  size_t sz = sizeof (long long) * way->node_ref_count;
+	  wy->node_refs = arena_alloc (&(job->arena), sz);
+	  if (wy->node_refs == NULL)
+	      goto error;
+	  memcpy (wy->node_refs, way->node_refs, sz);
+      }
+    if (!record_tags (job, &(wy->tags), way->tag_count, way->tags))
+	goto error;
+    return READOSM_OK;
+
+  error:
+    job->ret = READOSM_INSUFFICIENT_MEMORY;
+    return READOSM_INSUFFICIENT_MEMORY;
+}
+
+static int
+record_relation (const void *user_data, const readosm_relation * relation)
+{
+/* RELATION callback: recording the Relation for later delivery */
+    int i;
+    struct pbf_job *job = (struct pbf_job *) user_data;
+    readosm_export_relation *rel;
+    struct pbf_record *rec =
+	alloc_record (job, READOSM_CURRENT_TAG_IS_RELATION);
+    if (rec == NULL)
+	goto error;
+    rel = &(rec->obj.relation);
+    rel->id = relation->id;
+    rel->version = relation->version;
+    rel->changeset = relation->changeset;
+    rel->uid = relation->uid;
+    rel->timestamp_epoch = relation->timestamp_epoch;
+    rel->member_count = relation->member_count;
+    rel->tag_count = relation->tag_count;
+    rel->members = NULL;
+    if (!record_string (job, &(rel->user), relation->user))
+	goto error;
+    if (!record_string (job, &(rel->timestamp), relation->timestamp))
+	goto error;
+    if (relation->member_count > 0)
+      {
+	  rel->members =
+	      arena_alloc (&(job->arena),
+			   sizeof (readosm_export_member) *
+			   relation->member_count);
+	  if (rel->members == NULL)
+	      goto error;
+	  for (i = 0; i < relation->member_count; i++)
+	    {
+		readosm_export_member *mbr = rel->members + i;
+		const readosm_member *member = relation->members + i;
+		mbr->member_type = member->member_type;
+		mbr->id = member->id;
+		if (!record_string (job, &(mbr->role), member->role))
+		    goto error;
+	    }
+      }
+    if (!record_tags (job, &(rel->tags), relation->tag_count, relation->tags))
+	goto error;
+    return READOSM_OK;
+
+  error:
+    job->ret = READOSM_INSUFFICIENT_MEMORY;
+    return READOSM_INSUFFICIENT_MEMORY;
+}
+
+static void
+reset_job (struct pbf_job *job)
+{
+/* resetting a job to its initial empty state (ready for reuse) */
+    release_osm_blob (&(job->blob));
+    job->state = JOB_FREE;
+    job->ret = READOSM_OK;
+    job->rec_count = 0;
+    reset_arena (&(job->arena));
+}
+
+static void
+decode_job (struct pbf_pool *pool, struct pbf_job *job,
+	    readosm_pbf_decoder * decoder)
+{
+/* decoding a Blob: any object will be recorded for later delivery */
+    int ret;
+    struct pbf_params params;
+    params.user_data = job;
+    params.node_callback = (pool->node_callback) ? record_node : NULL;
+    params.way_callback = (pool->way_callback) ? record_way : NULL;
+    params.relation_callback =
+	(pool->relation_callback) ? record_relation : NULL;
+    params.node_batch_callback = NULL;
+    params.way_batch_callback = NULL;
+    params.relation_batch_callback = NULL;
+    params.node_columns_callback = NULL;
+    params.stop = 0;
+    params.skip_metadata = pool->skip_metadata;
+    params.lazy_timestamps = pool->lazy_timestamps;
+    job->ret = READOSM_OK;
+    ret = parse_osm_blob (decoder, &(job->blob), pool->little_endian_cpu,
+			  &params);
+    if (job->ret != READOSM_OK)
+	;			/* memory allocation failure while recording */
+    else if (ret != READOSM_OK)
+	job->ret = ret;
+    else if (params.stop)
+	job->ret = READOSM_ABORT;
+}
+
+static int
+deliver_job (struct pbf_pool *pool, struct pbf_job *job)
+{
+/* delivering any object decoded from a Blob in its original order */
+    int i;
+    int ret = READOSM_OK;
+    for (i = 0; i < job->rec_count; i++)
+      {
+	  struct pbf_record *rec = job->records + i;
+	  switch (rec->type)
+	    {
+	    case READOSM_CURRENT_TAG_IS_NODE:
+		ret = (*(pool->node_callback)) (pool->user_data,
+						(readosm_node *) &
+						(rec->obj.node));
+		break;
+	    case READOSM_CURRENT_TAG_IS_WAY:
+		ret = (*(pool->way_callback)) (pool->user_data,
+					       (readosm_way *) &
+					       (rec->obj.way));
+		break;
+	    case READOSM_CURRENT_TAG_IS_RELATION:
+		ret = (*(pool->relation_callback)) (pool->user_data,
+						    (readosm_relation *) &
+						    (rec->obj.relation));
+		break;
+	    };
+	  if (ret != READOSM_OK)
+	      return READOSM_ABORT;
+      }
+    return READOSM_OK;
+}
+
+static void
+decode_job_direct (struct pbf_pool *pool, struct pbf_job *job,
+		   readosm_pbf_decoder * decoder, const void *user_data)
+{
+/* decoding a Blob: any object will be immediately passed to the callbacks */
+    int ret = READOSM_OK;
+    struct pbf_params params;
+    params.user_data = user_data;
+    params.node_callback = pool->node_callback;
+    params.way_callback = pool->way_callback;
+    params.relation_callback = pool->relation_callback;
+    params.node_batch_callback = NULL;
+    params.way_batch_callback = NULL;
+    params.relation_batch_callback = NULL;
+    params.node_columns_callback = NULL;
+    params.stop = 0;
+    params.skip_metadata = pool->skip_metadata;
+    params.lazy_timestamps = pool->lazy_timestamps;
+    ret = parse_osm_blob (decoder, &(job->blob), pool->little_endian_cpu,
+			  &params);
+    if (ret == READOSM_OK && params.stop)
+	ret = READOSM_ABORT;
+    if (ret != READOSM_OK)
+      {
+	  /* stopping all other threads as soon as possible */
+	  pthread_mutex_lock (&(pool->mutex));
+	  if (pool->ret == READOSM_OK)
+	      pool->ret = ret;
+	  pool->abort = 1;
+	  pthread_cond_broadcast (&(pool->job_done));
+	  pthread_mutex_unlock (&(pool->mutex));
+      }
+}
+
+struct pbf_worker_arg
+{
+/* arguments passed to each worker thread */
+    struct pbf_pool *pool;	/* the worker pool */
+    int index;			/* thread index */
+    readosm_pbf_decoder *decoder;	/* per-thread decoder context */
+};
+
+static void *
+pbf_worker (void *arg)
+{
+/* a worker thread: decoding Blobs until the pool is shut down */
+    struct pbf_worker_arg *wrk = (struct pbf_worker_arg *) arg;
+    struct pbf_pool *pool = wrk->pool;
+    struct pbf_job *job;
+    int abort;
+
+    pthread_mutex_lock (&(pool->mutex));
+    while (1)
+      {
+	  while (!pool->shutdown && pool->next_decode == pool->next_read)
+	      pthread_cond_wait (&(pool->job_ready), &(pool->mutex));
+	  if (pool->next_decode == pool->next_read)
+	      break;		/* shutting down: no further Blob */
+	  job = pool->jobs + (pool->next_decode % pool->max_jobs);
+	  pool->next_decode += 1;
+	  abort = pool->abort;
+	  pthread_mutex_unlock (&(pool->mutex));
+
+	  /* decoding the Blob (outside the lock) */
+	  if (abort)
+	      job->ret = READOSM_ABORT;
+	  else if (pool->ordered)
+	      decode_job (pool, job, wrk->decoder);
+	  else
+	      decode_job_direct (pool, job, wrk->decoder,
+				 *(pool->thread_data + wrk->index));
+	  if (!pool->ordered)
+	      release_osm_blob (&(job->blob));
+
+	  pthread_mutex_lock (&(pool->mutex));
+	  job->state = (pool->ordered) ? JOB_DONE : JOB_FREE;
+	  pthread_cond_broadcast (&(pool->job_done));
+      }
+    pthread_mutex_unlock (&(pool->mutex));
+    return NULL;
+}
+
+static int
+create_pool (struct pbf_pool *pool, readosm_file * input, int threads,
+	     int ordered, const void *user_data,
+	     readosm_node_callback node_fnct, readosm_way_callback way_fnct,
+	     readosm_relation_callback relation_fnct)
+{
+/* initializing the worker pool (threads are not yet started) */
+    int i;
+    pool->max_jobs = threads * 2;
+    pool->jobs = malloc (sizeof (struct pbf_job) * pool->max_jobs);
+    pool->workers = malloc (sizeof (pthread_t) * threads);
+    pool->thread_data = malloc (sizeof (const void *) * threads);
+    if (pool->jobs == NULL || pool->workers == NULL
+	|| pool->thread_data == NULL)
+      {
+	  if (pool->jobs != NULL)
+	      free (pool->jobs);
+	  if (pool->workers != NULL)
+	      free (pool->workers);
+	  if (pool->thread_data != NULL)
+	      free (pool->thread_data);
+	  return 0;
+      }
+    for (i = 0; i < pool->max_jobs; i++)
+      {
+	  struct pbf_job *job = pool->jobs + i;
+	  job->state = JOB_FREE;
+	  job->blob.buf = NULL;
+	  job->blob.ptr = NULL;
+	  job->blob.size = 0;
+	  job->ret = READOSM_OK;
+	  job->records = NULL;
+	  job->rec_count = 0;
+	  job->rec_max = 0;
+	  init_arena (&(job->arena));
+      }
+    for (i = 0; i < threads; i++)
+	*(pool->thread_data + i) = user_data;
+    pool->next_read = 0;
+    pool->next_decode = 0;
+    pool->shutdown = 0;
+    pool->abort = 0;
+    pool->ordered = ordered;
+    pool->ret = READOSM_OK;
+    pool->started = 0;
+    pool->little_endian_cpu = input->little_endian_cpu;
+    pool->skip_metadata = (input->options & READOSM_SKIP_METADATA) ? 1 : 0;
+    pool->lazy_timestamps =
+	(input->options & READOSM_LAZY_TIMESTAMPS) ? 1 : 0;
+    pool->user_data = user_data;
+    pool->node_callback = node_fnct;
+    pool->way_callback = way_fnct;
+    pool->relation_callback = relation_fnct;
+    pthread_mutex_init (&(pool->mutex), NULL);
+    pthread_cond_init (&(pool->job_ready), NULL);
+    pthread_cond_init (&(pool->job_done), NULL);
+    return 1;
+}
+
+static void
+start_pool (struct pbf_pool *pool, struct pbf_worker_arg *args, int threads)
+{
+/* starting the worker threads */
+    int i;
+    for (i = 0; i < threads; i++)
+      {
+	  struct pbf_worker_arg *wrk = args + pool->started;
+	  wrk->pool = pool;
+	  wrk->index = pool->started;
+	  wrk->decoder = alloc_pbf_decoder ();
+	  if (wrk->decoder == NULL)
+	      break;
+	  if (pthread_create
+	      (pool->workers + pool->started, NULL, pbf_worker, wrk) == 0)
+	      pool->started++;
+	  else
+	      destroy_pbf_decoder (wrk->decoder);
+      }
+}
+
+static void
+destroy_pool (struct pbf_pool *pool, struct pbf_worker_arg *args, int abort)
+{
+/* shutting down the worker pool and releasing any related resource */
+    int i;
+    pthread_mutex_lock (&(pool->mutex));
+    pool->shutdown = 1;
+    if (abort)
+	pool->abort = 1;
+    pthread_cond_broadcast (&(pool->job_ready));
+    pthread_mutex_unlock (&(pool->mutex));
+    for (i = 0; i < pool->started; i++)
+      {
+	  pthread_join (*(pool->workers + i), NULL);
+	  destroy_pbf_decoder ((args + i)->decoder);
+      }
+    pthread_mutex_destroy (&(pool->mutex));
+    pthread_cond_destroy (&(pool->job_ready));
+    pthread_cond_destroy (&(pool->job_done));
+    for (i = 0; i < pool->max_jobs; i++)
+      {
+	  struct pbf_job *job = pool->jobs + i;
+	  release_osm_blob (&(job->blob));
+	  if (job->records != NULL)
+	      free (job->records);
+	  finalize_arena (&(job->arena));
+      }
+    free (pool->jobs);
+    free (pool->workers);
+    free (pool->thread_data);
+}
+
+static int
+queue_blob (readosm_file * input, struct pbf_pool *pool, struct pbf_job *job)
+{
+/* reading the next Blob and queuing it for decoding */
+    int rd = read_osm_blob (input, &(job->blob));
+    if (rd <= 0)
+	return rd;
+    pthread_mutex_lock (&(pool->mutex));
+    job->state = JOB_PENDING;
+    pool->next_read += 1;
+    pthread_cond_signal (&(pool->job_ready));
+    pthread_mutex_unlock (&(pool->mutex));
+    return 1;
+}
+
+READOSM_PRIVATE int
+parse_osm_pbf_mt (readosm_file * input, const void *user_data,
+		  readosm_node_callback node_fnct,
+		  readosm_way_callback way_fnct,
+		  readosm_relation_callback relation_fnct, int threads)
+{
+/* 
+ / parsing the input file [OSM PBF format] by a pool of threads
+ /
+ / the main thread sequentially reads the raw Blobs, and the 
+ / worker threads concurrently decode them; the main thread 
+ / then delivers the decoded objects to the callbacks in the
+ / same order they appear in the file, so to fully preserve
+ / the usual single-threaded semantics
+*/
+    int ret = READOSM_OK;
+    int eof = 0;
+    int next_deliver = 0;
+    struct pbf_pool pool;
+    struct pbf_worker_arg args[MAX_THREADS];
+
+    if (threads <= 1)
+	return parse_osm_pbf (input, user_data, node_fnct, way_fnct,
+			      relation_fnct);
+    if (threads > MAX_THREADS)
+	threads = MAX_THREADS;
+
+/* initializing the worker pool */
+    if (!create_pool
+	(&pool, input, threads, 1, user_data, node_fnct, way_fnct,
+	 relation_fnct))
+	return READOSM_INSUFFICIENT_MEMORY;
+    start_pool (&pool, args, threads);
+    if (pool.started == 0)
+      {
+	  /* unable to start any thread: falling back to a single thread */
+	  ret = parse_osm_pbf (input, user_data, node_fnct, way_fnct,
+			       relation_fnct);
+	  goto stop;
+      }
+
+/* testing OSMHeader */
+    if (!read_osm_header (input))
+      {
+	  ret = READOSM_INVALID_PBF_HEADER;
+	  goto stop;
+      }
+
+    while (1)
+      {
+	  struct pbf_job *job;
+
+	  /* filling the ring buffer with further Blobs */
+	  while (!eof && pool.next_read - next_deliver < pool.max_jobs)
+	    {
+		int rd;
+		job = pool.jobs + (pool.next_read % pool.max_jobs);
+		rd = queue_blob (input, &pool, job);
+		if (rd == 0)
+		  {
+		      eof = 1;
+		      break;
+		  }
+		if (rd < 0)
+		  {
+		      ret = READOSM_INVALID_PBF_HEADER;
+		      goto stop;
+		  }
+	    }
+	  if (next_deliver == pool.next_read)
+	      break;		/* all done */
+
+	  /* waiting for the oldest Blob to be decoded */
+	  job = pool.jobs + (next_deliver % pool.max_jobs);
+	  pthread_mutex_lock (&(pool.mutex));
+	  while (job->state != JOB_DONE)
+	      pthread_cond_wait (&(pool.job_done), &(pool.mutex));
+	  pthread_mutex_unlock (&(pool.mutex));
+
+	  /* delivering the decoded objects in file order */
+	  ret = job->ret;
+	  if (ret == READOSM_OK)
+	      ret = deliver_job (&pool, job);
+	  if (ret != READOSM_OK)
+	      goto stop;
+	  reset_job (job);
+	  next_deliver++;
+      }
+
+  stop:
+    destroy_pool (&pool, args, ret != READOSM_OK);
+    return ret;
+}
+
+READOSM_PRIVATE int
+parse_osm_pbf_parallel (readosm_file * input,
+			readosm_user_data_factory factory,
+			const void *factory_data,
+			readosm_node_callback node_fnct,
+			readosm_way_callback way_fnct,
+			readosm_relation_callback relation_fnct, int threads)
+{
+/* 
+ / parsing the input file [OSM PBF format] by a pool of threads
+ / [unordered mode]
+ /
+ / the main thread sequentially reads the raw Blobs, and the 
+ / worker threads concurrently decode them, directly calling
+ / the callbacks with their own per-thread user data; no 
+ / reordering at all is required, so any thread can freely
+ / proceed at its own pace
+*/
+    int i;
+    int ret = READOSM_OK;
+    struct pbf_pool pool;
+    struct pbf_worker_arg args[MAX_THREADS];
+
+    if (threads <= 1)
+      {
+	  const void *user_data = factory_data;
+	  if (factory != NULL)
+	      user_data = (*factory) (factory_data, 0);
+	  return parse_osm_pbf (input, user_data, node_fnct, way_fnct,
+				relation_fnct);
+      }
+    if (threads > MAX_THREADS)
+	threads = MAX_THREADS;
+
+/* initializing the worker pool */
+    if (!create_pool
+	(&pool, input, threads, 0, factory_data, node_fnct, way_fnct,
+	 relation_fnct))
+	return READOSM_INSUFFICIENT_MEMORY;
+    if (factory != NULL)
+      {
+	  for (i = 0; i < threads; i++)
+	      *(pool.thread_data + i) = (*factory) (factory_data, i);
+      }
+    start_pool (&pool, args, threads);
+    if (pool.started == 0)
+      {
+	  /* unable to start any thread: falling back to a single thread */
+	  ret = parse_osm_pbf (input, *(pool.thread_data + 0), node_fnct,
+			       way_fnct, relation_fnct);
+	  goto stop;
+      }
+
+/* testing OSMHeader */
+    if (!read_osm_header (input))
+      {
+	  ret = READOSM_INVALID_PBF_HEADER;
+	  goto stop;
+      }
+
+    while (1)
+      {
+	  int rd;
+	  int abort;
+	  struct pbf_job *job = pool.jobs + (pool.next_read % pool.max_jobs);
+
+	  /* waiting for a free slot in the ring buffer */
+	  pthread_mutex_lock (&(pool.mutex));
+	  while (job->state != JOB_FREE && !pool.abort)
+	      pthread_cond_wait (&(pool.job_done), &(pool.mutex));
+	  abort = pool.abort;
+	  pthread_mutex_unlock (&(pool.mutex));
+	  if (abort)
+	      break;
+
+	  rd = queue_blob (input, &pool, job);
+	  if (rd == 0)
+	      break;		/* all done */
+	  if (rd < 0)
+	    {
+		ret = READOSM_INVALID_PBF_HEADER;
+		goto stop;
+	    }
+      }
+
+  stop:
+/* waiting for any pending Blob to be decoded */
+    destroy_pool (&pool, args, ret != READOSM_OK);
+    if (ret == READOSM_OK)
+	ret = pool.ret;
+    return ret;
+}
+
+#else /* POSIX threads are not supported */
+
+READOSM_PRIVATE int
+parse_osm_pbf_mt (readosm_file * input, const void *user_data,
+		  readosm_node_callback node_fnct,
+		  readosm_way_callback way_fnct,
+		  readosm_relation_callback relation_fnct, int threads)
+{
+/* multi-threading is not supported: parsing by a single thread */
+    if (threads > 1)
+	threads = 1;		/* silencing stupid compiler warnings */
+    return parse_osm_pbf (input, user_data, node_fnct, way_fnct,
+			  relation_fnct);
+}
+
+READOSM_PRIVATE int
+parse_osm_pbf_parallel (readosm_file * input,
+			readosm_user_data_factory factory,
+			const void *factory_data,
+			readosm_node_callback node_fnct,
+			readosm_way_callback way_fnct,
+			readosm_relation_callback relation_fnct, int threads)
+{
+/* multi-threading is not supported: parsing by a single thread */
+    const void *user_data = factory_data;
+    if (threads > 1)
+	threads = 1;		/* silencing stupid compiler warnings */
+    if (factory != NULL)
+	user_data = (*factory) (factory_data, 0);
+    return parse_osm_pbf (input, user_data, node_fnct, way_fnct,
+			  relation_fnct);
+}
+
+#endif /* end POSIX threads conditional */
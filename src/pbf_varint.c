@@ -0,0 +1,677 @@
+/* 
+/ pbf_varint.c
+/
+/ bulk decoding of PBF packed varint arrays
+/
+/ Author: the ReadOSM contributors, 2026
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the ReadOSM library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2012-2017
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/ 
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32) && !defined(__MINGW32__)
+#include "config-msvc.h"
+#else
+#include "config.h"
+#endif
+
+#include "readosm.h"
+#include "readosm_varint.h"
+
+#ifndef READOSM_NO_SIMD
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define READOSM_SSE41 1
+#define SSE41_TARGET __attribute__ ((target ("sse4.1")))
+#include <smmintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define READOSM_SSE41 1
+#define SSE41_TARGET
+#include <intrin.h>
+#include <smmintrin.h>
+#endif
+#endif
+
+/*
+ * all decoders share the same contract:
+ * - any varint between START and STOP (inclusive) will be decoded
+ * - VALUES must have room for (STOP - START + 1) + READOSM_PACKED_SLACK
+ *   items: each varint requires at least one byte, and the SIMD
+ *   decoders always store a whole vector of results
+ * - the number of decoded values is returned, or -1 if the packed
+ *   array is malformed
+ */
+
+static int
+scalar_uint32 (unsigned char *start, unsigned char *stop,
+	       unsigned int *values)
+{
+/* decoding an UINT32 packed array one varint at each time */
+    unsigned char *ptr = start;
+    int count = 0;
+    while (ptr <= stop)
+      {
+	  ptr = read_varint32 (ptr, stop, values + count);
+	  if (ptr == NULL)
+	      return -1;
+	  count++;
+      }
+    return count;
+}
+
+static int
+scalar_sint32 (unsigned char *start, unsigned char *stop, int *values)
+{
+/* decoding a SINT32 packed array one varint at each time */
+    unsigned char *ptr = start;
+    int count = 0;
+    while (ptr <= stop)
+      {
+	  ptr = read_svarint32 (ptr, stop, values + count);
+	  if (ptr == NULL)
+	      return -1;
+	  count++;
+      }
+    return count;
+}
+
+static int
+scalar_sint64 (unsigned char *start, unsigned char *stop, long long *values)
+{
+/* decoding a SINT64 packed array one varint at each time */
+    unsigned char *ptr = start;
+    int count = 0;
+    while (ptr <= stop)
+      {
+	  ptr = read_svarint64 (ptr, stop, values + count);
+	  if (ptr == NULL)
+	      return -1;
+	  count++;
+      }
+    return count;
+}
+
+#ifdef READOSM_SSE41
+
+/*
+ * masked-VByte style decoding
+ *
+ * the continuation bits of the next 16 bytes are collected by a
+ * single MOVMSK:
+ * - if no continuation bit is set, all 16 bytes simply are single
+ *   byte varints, and are directly widened to the output type
+ * - otherwise the continuation bits of the first 8 bytes are used
+ *   to look up a shuffle mask gathering up to eight 1 or 2 bytes
+ *   varints into 16 bit lanes, so to decode all of them at once
+ * - a longer varint at the current position is decoded by the
+ *   scalar decoder
+ *
+ * varint_windows[] has been generated by enumerating all 256 masks
+ * of continuation bits: COUNT is the number of varints (of at most
+ * 2 bytes) entirely contained within the first 8 bytes, CONSUMED
+ * is their total length in bytes, and SHUFFLE places the low/high
+ * byte of each varint into its 16 bit lane (Z_ stands for zero)
+ */
+
+struct varint_window
+{
+    unsigned char count;
+    unsigned char consumed;
+    unsigned char shuffle[16];
+};
+
+#define Z_ 0x80
+static const struct varint_window varint_windows[256] = {
+    {8, 8, {0, Z_, 1, Z_, 2, Z_, 3, Z_, 4, Z_, 5, Z_, 6, Z_, 7, Z_}},
+    {7, 8, {0, 1, 2, Z_, 3, Z_, 4, Z_, 5, Z_, 6, Z_, 7, Z_, Z_, Z_}},
+    {7, 8, {0, Z_, 1, 2, 3, Z_, 4, Z_, 5, Z_, 6, Z_, 7, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {7, 8, {0, Z_, 1, Z_, 2, 3, 4, Z_, 5, Z_, 6, Z_, 7, Z_, Z_, Z_}},
+    {6, 8, {0, 1, 2, 3, 4, Z_, 5, Z_, 6, Z_, 7, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {7, 8, {0, Z_, 1, Z_, 2, Z_, 3, 4, 5, Z_, 6, Z_, 7, Z_, Z_, Z_}},
+    {6, 8, {0, 1, 2, Z_, 3, 4, 5, Z_, 6, Z_, 7, Z_, Z_, Z_, Z_, Z_}},
+    {6, 8, {0, Z_, 1, 2, 3, 4, 5, Z_, 6, Z_, 7, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 2, {0, Z_, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 2, {0, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {7, 8, {0, Z_, 1, Z_, 2, Z_, 3, Z_, 4, 5, 6, Z_, 7, Z_, Z_, Z_}},
+    {6, 8, {0, 1, 2, Z_, 3, Z_, 4, 5, 6, Z_, 7, Z_, Z_, Z_, Z_, Z_}},
+    {6, 8, {0, Z_, 1, 2, 3, Z_, 4, 5, 6, Z_, 7, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {6, 8, {0, Z_, 1, Z_, 2, 3, 4, 5, 6, Z_, 7, Z_, Z_, Z_, Z_, Z_}},
+    {5, 8, {0, 1, 2, 3, 4, 5, 6, Z_, 7, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 3, {0, Z_, 1, Z_, 2, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 3, {0, 1, 2, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 3, {0, Z_, 1, 2, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 2, {0, Z_, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 2, {0, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {7, 8, {0, Z_, 1, Z_, 2, Z_, 3, Z_, 4, Z_, 5, 6, 7, Z_, Z_, Z_}},
+    {6, 8, {0, 1, 2, Z_, 3, Z_, 4, Z_, 5, 6, 7, Z_, Z_, Z_, Z_, Z_}},
+    {6, 8, {0, Z_, 1, 2, 3, Z_, 4, Z_, 5, 6, 7, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {6, 8, {0, Z_, 1, Z_, 2, 3, 4, Z_, 5, 6, 7, Z_, Z_, Z_, Z_, Z_}},
+    {5, 8, {0, 1, 2, 3, 4, Z_, 5, 6, 7, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {6, 8, {0, Z_, 1, Z_, 2, Z_, 3, 4, 5, 6, 7, Z_, Z_, Z_, Z_, Z_}},
+    {5, 8, {0, 1, 2, Z_, 3, 4, 5, 6, 7, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {5, 8, {0, Z_, 1, 2, 3, 4, 5, 6, 7, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 2, {0, Z_, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 2, {0, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {4, 4, {0, Z_, 1, Z_, 2, Z_, 3, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 4, {0, 1, 2, Z_, 3, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 4, {0, Z_, 1, 2, 3, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 4, {0, Z_, 1, Z_, 2, 3, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 4, {0, 1, 2, 3, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 3, {0, Z_, 1, Z_, 2, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 3, {0, 1, 2, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 3, {0, Z_, 1, 2, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 2, {0, Z_, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 2, {0, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {7, 8, {0, Z_, 1, Z_, 2, Z_, 3, Z_, 4, Z_, 5, Z_, 6, 7, Z_, Z_}},
+    {6, 8, {0, 1, 2, Z_, 3, Z_, 4, Z_, 5, Z_, 6, 7, Z_, Z_, Z_, Z_}},
+    {6, 8, {0, Z_, 1, 2, 3, Z_, 4, Z_, 5, Z_, 6, 7, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {6, 8, {0, Z_, 1, Z_, 2, 3, 4, Z_, 5, Z_, 6, 7, Z_, Z_, Z_, Z_}},
+    {5, 8, {0, 1, 2, 3, 4, Z_, 5, Z_, 6, 7, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {6, 8, {0, Z_, 1, Z_, 2, Z_, 3, 4, 5, Z_, 6, 7, Z_, Z_, Z_, Z_}},
+    {5, 8, {0, 1, 2, Z_, 3, 4, 5, Z_, 6, 7, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {5, 8, {0, Z_, 1, 2, 3, 4, 5, Z_, 6, 7, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 2, {0, Z_, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 2, {0, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {6, 8, {0, Z_, 1, Z_, 2, Z_, 3, Z_, 4, 5, 6, 7, Z_, Z_, Z_, Z_}},
+    {5, 8, {0, 1, 2, Z_, 3, Z_, 4, 5, 6, 7, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {5, 8, {0, Z_, 1, 2, 3, Z_, 4, 5, 6, 7, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {5, 8, {0, Z_, 1, Z_, 2, 3, 4, 5, 6, 7, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {4, 8, {0, 1, 2, 3, 4, 5, 6, 7, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 3, {0, Z_, 1, Z_, 2, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 3, {0, 1, 2, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 3, {0, Z_, 1, 2, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 2, {0, Z_, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 2, {0, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {5, 5, {0, Z_, 1, Z_, 2, Z_, 3, Z_, 4, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {4, 5, {0, 1, 2, Z_, 3, Z_, 4, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {4, 5, {0, Z_, 1, 2, 3, Z_, 4, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {4, 5, {0, Z_, 1, Z_, 2, 3, 4, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 5, {0, 1, 2, 3, 4, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {4, 5, {0, Z_, 1, Z_, 2, Z_, 3, 4, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 5, {0, 1, 2, Z_, 3, 4, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 5, {0, Z_, 1, 2, 3, 4, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 2, {0, Z_, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 2, {0, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {4, 4, {0, Z_, 1, Z_, 2, Z_, 3, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 4, {0, 1, 2, Z_, 3, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 4, {0, Z_, 1, 2, 3, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 4, {0, Z_, 1, Z_, 2, 3, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 4, {0, 1, 2, 3, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 3, {0, Z_, 1, Z_, 2, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 3, {0, 1, 2, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 3, {0, Z_, 1, 2, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 2, {0, Z_, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 2, {0, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {7, 7, {0, Z_, 1, Z_, 2, Z_, 3, Z_, 4, Z_, 5, Z_, 6, Z_, Z_, Z_}},
+    {6, 7, {0, 1, 2, Z_, 3, Z_, 4, Z_, 5, Z_, 6, Z_, Z_, Z_, Z_, Z_}},
+    {6, 7, {0, Z_, 1, 2, 3, Z_, 4, Z_, 5, Z_, 6, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {6, 7, {0, Z_, 1, Z_, 2, 3, 4, Z_, 5, Z_, 6, Z_, Z_, Z_, Z_, Z_}},
+    {5, 7, {0, 1, 2, 3, 4, Z_, 5, Z_, 6, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {6, 7, {0, Z_, 1, Z_, 2, Z_, 3, 4, 5, Z_, 6, Z_, Z_, Z_, Z_, Z_}},
+    {5, 7, {0, 1, 2, Z_, 3, 4, 5, Z_, 6, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {5, 7, {0, Z_, 1, 2, 3, 4, 5, Z_, 6, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 2, {0, Z_, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 2, {0, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {6, 7, {0, Z_, 1, Z_, 2, Z_, 3, Z_, 4, 5, 6, Z_, Z_, Z_, Z_, Z_}},
+    {5, 7, {0, 1, 2, Z_, 3, Z_, 4, 5, 6, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {5, 7, {0, Z_, 1, 2, 3, Z_, 4, 5, 6, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {5, 7, {0, Z_, 1, Z_, 2, 3, 4, 5, 6, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {4, 7, {0, 1, 2, 3, 4, 5, 6, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 3, {0, Z_, 1, Z_, 2, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 3, {0, 1, 2, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 3, {0, Z_, 1, 2, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 2, {0, Z_, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 2, {0, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {6, 7, {0, Z_, 1, Z_, 2, Z_, 3, Z_, 4, Z_, 5, 6, Z_, Z_, Z_, Z_}},
+    {5, 7, {0, 1, 2, Z_, 3, Z_, 4, Z_, 5, 6, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {5, 7, {0, Z_, 1, 2, 3, Z_, 4, Z_, 5, 6, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {5, 7, {0, Z_, 1, Z_, 2, 3, 4, Z_, 5, 6, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {4, 7, {0, 1, 2, 3, 4, Z_, 5, 6, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {5, 7, {0, Z_, 1, Z_, 2, Z_, 3, 4, 5, 6, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {4, 7, {0, 1, 2, Z_, 3, 4, 5, 6, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {4, 7, {0, Z_, 1, 2, 3, 4, 5, 6, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 2, {0, Z_, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 2, {0, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {4, 4, {0, Z_, 1, Z_, 2, Z_, 3, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 4, {0, 1, 2, Z_, 3, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 4, {0, Z_, 1, 2, 3, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 4, {0, Z_, 1, Z_, 2, 3, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 4, {0, 1, 2, 3, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 3, {0, Z_, 1, Z_, 2, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 3, {0, 1, 2, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 3, {0, Z_, 1, 2, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 2, {0, Z_, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 2, {0, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {6, 6, {0, Z_, 1, Z_, 2, Z_, 3, Z_, 4, Z_, 5, Z_, Z_, Z_, Z_, Z_}},
+    {5, 6, {0, 1, 2, Z_, 3, Z_, 4, Z_, 5, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {5, 6, {0, Z_, 1, 2, 3, Z_, 4, Z_, 5, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {5, 6, {0, Z_, 1, Z_, 2, 3, 4, Z_, 5, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {4, 6, {0, 1, 2, 3, 4, Z_, 5, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {5, 6, {0, Z_, 1, Z_, 2, Z_, 3, 4, 5, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {4, 6, {0, 1, 2, Z_, 3, 4, 5, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {4, 6, {0, Z_, 1, 2, 3, 4, 5, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 2, {0, Z_, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 2, {0, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {5, 6, {0, Z_, 1, Z_, 2, Z_, 3, Z_, 4, 5, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {4, 6, {0, 1, 2, Z_, 3, Z_, 4, 5, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {4, 6, {0, Z_, 1, 2, 3, Z_, 4, 5, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {4, 6, {0, Z_, 1, Z_, 2, 3, 4, 5, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 6, {0, 1, 2, 3, 4, 5, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 3, {0, Z_, 1, Z_, 2, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 3, {0, 1, 2, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 3, {0, Z_, 1, 2, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 2, {0, Z_, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 2, {0, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {5, 5, {0, Z_, 1, Z_, 2, Z_, 3, Z_, 4, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {4, 5, {0, 1, 2, Z_, 3, Z_, 4, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {4, 5, {0, Z_, 1, 2, 3, Z_, 4, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {4, 5, {0, Z_, 1, Z_, 2, 3, 4, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 5, {0, 1, 2, 3, 4, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {4, 5, {0, Z_, 1, Z_, 2, Z_, 3, 4, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 5, {0, 1, 2, Z_, 3, 4, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 5, {0, Z_, 1, 2, 3, 4, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 2, {0, Z_, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 2, {0, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {4, 4, {0, Z_, 1, Z_, 2, Z_, 3, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 4, {0, 1, 2, Z_, 3, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 4, {0, Z_, 1, 2, 3, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 4, {0, Z_, 1, Z_, 2, 3, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 4, {0, 1, 2, 3, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {3, 3, {0, Z_, 1, Z_, 2, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 3, {0, 1, 2, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 3, {0, Z_, 1, 2, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {2, 2, {0, Z_, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 2, {0, 1, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {1, 1, {0, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}},
+    {0, 0, {Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_, Z_}}
+
+};
+#undef Z_
+
+static int
+sse41_available (void)
+{
+/* checking if the current CPU supports SSE4.1 */
+#if defined(__GNUC__)
+    return __builtin_cpu_supports ("sse4.1");
+#else
+    static int available = -1;
+    if (available < 0)
+      {
+	  int info[4];
+	  __cpuid (info, 1);
+	  available = (info[2] & (1 << 19)) ? 1 : 0;
+      }
+    return available;
+#endif
+}
+
+SSE41_TARGET static __m128i
+window_lanes (__m128i in, const struct varint_window *window)
+{
+/* decoding up to eight 1 or 2 bytes varints into 16 bit lanes */
+    __m128i v =
+	_mm_shuffle_epi8 (in,
+			  _mm_loadu_si128 ((const __m128i *)
+					   window->shuffle));
+    __m128i lo = _mm_and_si128 (v, _mm_set1_epi16 (0x007f));
+    __m128i hi = _mm_and_si128 (v, _mm_set1_epi16 (0x7f00));
+    return _mm_or_si128 (lo, _mm_srli_epi16 (hi, 1));
+}
+
+SSE41_TARGET static __m128i
+zigzag_lanes (__m128i v)
+{
+/* decoding ZigZag encoded 16 bit lanes */
+    __m128i neg = _mm_sub_epi16 (_mm_setzero_si128 (),
+				 _mm_and_si128 (v, _mm_set1_epi16 (1)));
+    return _mm_xor_si128 (_mm_srli_epi16 (v, 1), neg);
+}
+
+SSE41_TARGET static int
+sse41_uint32 (unsigned char *start, unsigned char *stop,
+	      unsigned int *values)
+{
+/* decoding an UINT32 packed array (SSE4.1) */
+    unsigned char *ptr = start;
+    unsigned int *out = values;
+    int count;
+
+    while (stop - ptr >= 15)
+      {
+	  __m128i in = _mm_loadu_si128 ((const __m128i *) ptr);
+	  int mask = _mm_movemask_epi8 (in);
+	  const struct varint_window *window;
+	  __m128i v;
+	  if (mask == 0)
+	    {
+		/* sixteen single byte varints */
+		_mm_storeu_si128 ((__m128i *) out, _mm_cvtepu8_epi32 (in));
+		_mm_storeu_si128 ((__m128i *) (out + 4),
+				  _mm_cvtepu8_epi32 (_mm_srli_si128 (in, 4)));
+		_mm_storeu_si128 ((__m128i *) (out + 8),
+				  _mm_cvtepu8_epi32 (_mm_srli_si128 (in, 8)));
+		_mm_storeu_si128 ((__m128i *) (out + 12),
+				  _mm_cvtepu8_epi32 (_mm_srli_si128
+						     (in, 12)));
+		ptr += 16;
+		out += 16;
+		continue;
+	    }
+	  window = varint_windows + (mask & 0xff);
+	  if (window->count == 0)
+	    {
+		/* a longer varint */
+		ptr = read_varint32 (ptr, stop, out);
+		if (ptr == NULL)
+		    return -1;
+		out++;
+		continue;
+	    }
+	  v = window_lanes (in, window);
+	  _mm_storeu_si128 ((__m128i *) out, _mm_cvtepu16_epi32 (v));
+	  _mm_storeu_si128 ((__m128i *) (out + 4),
+			    _mm_cvtepu16_epi32 (_mm_srli_si128 (v, 8)));
+	  ptr += window->consumed;
+	  out += window->count;
+      }
+
+/* decoding the tail */
+    count = scalar_uint32 (ptr, stop, out);
+    if (count < 0)
+	return -1;
+    return (int) (out - values) + count;
+}
+
+SSE41_TARGET static int
+sse41_sint32 (unsigned char *start, unsigned char *stop, int *values)
+{
+/* decoding a SINT32 packed array (SSE4.1) */
+    unsigned char *ptr = start;
+    int *out = values;
+    int count;
+
+    while (stop - ptr >= 15)
+      {
+	  __m128i in = _mm_loadu_si128 ((const __m128i *) ptr);
+	  int mask = _mm_movemask_epi8 (in);
+	  const struct varint_window *window;
+	  __m128i v;
+	  if (mask == 0)
+	    {
+		/* sixteen single byte varints */
+		__m128i v0 = zigzag_lanes (_mm_cvtepu8_epi16 (in));
+		__m128i v1 =
+		    zigzag_lanes (_mm_cvtepu8_epi16 (_mm_srli_si128 (in, 8)));
+		_mm_storeu_si128 ((__m128i *) out, _mm_cvtepi16_epi32 (v0));
+		_mm_storeu_si128 ((__m128i *) (out + 4),
+				  _mm_cvtepi16_epi32 (_mm_srli_si128 (v0, 8)));
+		_mm_storeu_si128 ((__m128i *) (out + 8),
+				  _mm_cvtepi16_epi32 (v1));
+		_mm_storeu_si128 ((__m128i *) (out + 12),
+				  _mm_cvtepi16_epi32 (_mm_srli_si128 (v1, 8)));
+		ptr += 16;
+		out += 16;
+		continue;
+	    }
+	  window = varint_windows + (mask & 0xff);
+	  if (window->count == 0)
+	    {
+		/* a longer varint */
+		ptr = read_svarint32 (ptr, stop, out);
+		if (ptr == NULL)
+		    return -1;
+		out++;
+		continue;
+	    }
+	  v = zigzag_lanes (window_lanes (in, window));
+	  _mm_storeu_si128 ((__m128i *) out, _mm_cvtepi16_epi32 (v));
+	  _mm_storeu_si128 ((__m128i *) (out + 4),
+			    _mm_cvtepi16_epi32 (_mm_srli_si128 (v, 8)));
+	  ptr += window->consumed;
+	  out += window->count;
+      }
+
+/* decoding the tail */
+    count = scalar_sint32 (ptr, stop, out);
+    if (count < 0)
+	return -1;
+    return (int) (out - values) + count;
+}
+
+SSE41_TARGET static void
+store_lanes64 (long long *out, __m128i v)
+{
+/* sign-extending eight 16 bit lanes into INT64 values */
+    _mm_storeu_si128 ((__m128i *) out, _mm_cvtepi16_epi64 (v));
+    _mm_storeu_si128 ((__m128i *) (out + 2),
+		      _mm_cvtepi16_epi64 (_mm_srli_si128 (v, 4)));
+    _mm_storeu_si128 ((__m128i *) (out + 4),
+		      _mm_cvtepi16_epi64 (_mm_srli_si128 (v, 8)));
+    _mm_storeu_si128 ((__m128i *) (out + 6),
+		      _mm_cvtepi16_epi64 (_mm_srli_si128 (v, 12)));
+}
+
+SSE41_TARGET static int
+sse41_sint64 (unsigned char *start, unsigned char *stop, long long *values)
+{
+/* decoding a SINT64 packed array (SSE4.1) */
+    unsigned char *ptr = start;
+    long long *out = values;
+    int count;
+
+    while (stop - ptr >= 15)
+      {
+	  __m128i in = _mm_loadu_si128 ((const __m128i *) ptr);
+	  int mask = _mm_movemask_epi8 (in);
+	  const struct varint_window *window;
+	  if (mask == 0)
+	    {
+		/* sixteen single byte varints */
+		store_lanes64 (out, zigzag_lanes (_mm_cvtepu8_epi16 (in)));
+		store_lanes64 (out + 8,
+			       zigzag_lanes (_mm_cvtepu8_epi16
+					     (_mm_srli_si128 (in, 8))));
+		ptr += 16;
+		out += 16;
+		continue;
+	    }
+	  window = varint_windows + (mask & 0xff);
+	  if (window->count == 0)
+	    {
+		/* a longer varint */
+		ptr = read_svarint64 (ptr, stop, out);
+		if (ptr == NULL)
+		    return -1;
+		out++;
+		continue;
+	    }
+	  store_lanes64 (out, zigzag_lanes (window_lanes (in, window)));
+	  ptr += window->consumed;
+	  out += window->count;
+      }
+
+/* decoding the tail */
+    count = scalar_sint64 (ptr, stop, out);
+    if (count < 0)
+	return -1;
+    return (int) (out - values) + count;
+}
+
+#endif /* READOSM_SSE41 */
+
+READOSM_PRIVATE int
+packed_varint_simd (void)
+{
+/* checking if the SIMD decoders are going to be used */
+#ifdef READOSM_SSE41
+    return sse41_available ();
+#else
+    return 0;
+#endif
+}
+
+READOSM_PRIVATE int
+decode_packed_uint32 (unsigned char *start, unsigned char *stop,
+		      unsigned int *values)
+{
+/* decoding an UINT32 packed array */
+#ifdef READOSM_SSE41
+    if (sse41_available ())
+	return sse41_uint32 (start, stop, values);
+#endif
+    return scalar_uint32 (start, stop, values);
+}
+
+READOSM_PRIVATE int
+decode_packed_sint32 (unsigned char *start, unsigned char *stop, int *values)
+{
+/* decoding a SINT32 packed array */
+#ifdef READOSM_SSE41
+    if (sse41_available ())
+	return sse41_sint32 (start, stop, values);
+#endif
+    return scalar_sint32 (start, stop, values);
+}
+
+READOSM_PRIVATE int
+decode_packed_sint64 (unsigned char *start, unsigned char *stop,
+		      long long *values)
+{
+/* decoding a SINT64 packed array */
+#ifdef READOSM_SSE41
+    if (sse41_available ())
+	return sse41_sint64 (start, stop, values);
+#endif
+    return scalar_sint64 (start, stop, values);
+}
@@ -48,7 +48,6 @@
 #include <stdio.h>
 #include <string.h>
 #include <memory.h>
-#include <time.h>
 
 #include <zlib.h>
 
@@ -58,24 +57,145 @@
 #include "config.h"
 #endif
 
+#ifdef HAVE_LIBDEFLATE
+#include <libdeflate.h>
+#endif
+
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
+
+#ifdef HAVE_LIBLZ4
+#include <lz4.h>
+#endif
+
 #include "readosm.h"
 #include "readosm_internals.h"
 #include "readosm_protobuf.h"
+#include "readosm_varint.h"
 
 #define MAX_NODES 1024
 
-struct pbf_params
-{
-/* an helper struct supporting PBF parsing */
-    const void *user_data;
-    readosm_node_callback node_callback;
-    readosm_way_callback way_callback;
-    readosm_relation_callback relation_callback;
-    int stop;
+/*
+ / static field tables: one per PBF message type, indexed by field ID
+ / (any field ID not declared here is simply skipped while parsing)
+*/
+#define F___	READOSM_VAR_UNDEFINED
+#define F_I32	READOSM_VAR_INT32
+#define F_I64	READOSM_VAR_INT64
+#define F_S64	READOSM_VAR_SINT64
+#define F_LEN	READOSM_LEN_BYTES
+
+#define FIELD_TABLE(name) \
+    static const readosm_field_table name = \
+	{ sizeof (name##_types) - 1, name##_types }
+
+/* BlobHeader: type, indexdata, datasize */
+static const unsigned char blob_header_fields_types[] = {
+    F___, F_LEN, F_LEN, F_I32
+};
+
+FIELD_TABLE (blob_header_fields);
+
+/* Blob: raw, raw_size, zlib_data, lzma_data, bzip2_data, lz4_data, zstd_data */
+static const unsigned char blob_fields_types[] = {
+    F___, F_LEN, F_I32, F_LEN, F_LEN, F_LEN, F_LEN, F_LEN
+};
+
+FIELD_TABLE (blob_fields);
+
+/*
+ / HeaderBlock: bbox, required_features, optional_features,
+ / writingprogram, source, osmosis_replication_timestamp,
+ / osmosis_replication_sequence_number, osmosis_replication_base_url
+*/
+static const unsigned char header_block_fields_types[] = {
+    F___, F_LEN, F___, F___, F_LEN, F_LEN, F___, F___,	/*  0 -  7 */
+    F___, F___, F___, F___, F___, F___, F___, F___,	/*  8 - 15 */
+    F_LEN, F_LEN, F___, F___, F___, F___, F___, F___,	/* 16 - 23 */
+    F___, F___, F___, F___, F___, F___, F___, F___,	/* 24 - 31 */
+    F_I64, F_I64, F_LEN	/* 32 - 34 */
+};
+
+FIELD_TABLE (header_block_fields);
+
+/* HeaderBBox: left, right, top, bottom */
+static const unsigned char header_bbox_fields_types[] = {
+    F___, F_S64, F_S64, F_S64, F_S64
+};
+
+FIELD_TABLE (header_bbox_fields);
+
+/*
+ / PrimitiveBlock: stringtable, primitivegroup, granularity,
+ / date_granularity, lat_offset, lon_offset
+*/
+static const unsigned char primitive_block_fields_types[] = {
+    F___, F_LEN, F_LEN, F___, F___, F___, F___, F___,	/*  0 -  7 */
+    F___, F___, F___, F___, F___, F___, F___, F___,	/*  8 - 15 */
+    F___, F_I32, F_I32, F_I64, F_I64	/* 16 - 20 */
+};
+
+FIELD_TABLE (primitive_block_fields);
+
+/* StringTable: s */
+static const unsigned char string_table_fields_types[] = {
+    F___, F_LEN
+};
+
+FIELD_TABLE (string_table_fields);
+
+/* PrimitiveGroup: nodes, dense, ways, relations, changesets */
+static const unsigned char primitive_group_fields_types[] = {
+    F___, F_LEN, F_LEN, F_LEN, F_LEN, F_LEN
+};
+
+FIELD_TABLE (primitive_group_fields);
+
+/* DenseNodes: id, denseinfo, lat, lon, keys_vals */
+static const unsigned char dense_nodes_fields_types[] = {
+    F___, F_LEN, F___, F___, F___, F_LEN, F___, F___, F_LEN, F_LEN, F_LEN
+};
+
+FIELD_TABLE (dense_nodes_fields);
+
+/* DenseInfo: version, timestamp, changeset, uid, user_sid (all packed) */
+static const unsigned char dense_infos_fields_types[] = {
+    F___, F_LEN, F_LEN, F_LEN, F_LEN, F_LEN, F_LEN
+};
+
+FIELD_TABLE (dense_infos_fields);
+
+/* Info: version, timestamp, changeset, uid, user_sid, visible */
+static const unsigned char info_fields_types[] = {
+    F___, F_I32, F_I64, F_I64, F_I32, F_I32, F_I32
 };
 
+FIELD_TABLE (info_fields);
+
+/* Way: id, keys, vals, info, refs */
+static const unsigned char way_fields_types[] = {
+    F___, F_I64, F_LEN, F_LEN, F_LEN, F___, F___, F___, F_LEN
+};
+
+FIELD_TABLE (way_fields);
+
+/* Relation: id, keys, vals, info, roles_sid, memids, types */
+static const unsigned char relation_fields_types[] = {
+    F___, F_I64, F_LEN, F_LEN, F_LEN, F___, F___, F___, F_LEN, F_LEN, F_LEN
+};
+
+FIELD_TABLE (relation_fields);
+
+#undef F___
+#undef F_I32
+#undef F_I64
+#undef F_S64
+#undef F_LEN
+
 static void
-init_variant (readosm_variant * variant, int little_endian_cpu)
+init_variant (readosm_variant * variant, int little_endian_cpu,
+	      const readosm_field_table * fields)
 {
 /* initializing an empty PBF Variant object */
     variant->little_endian_cpu = little_endian_cpu;
@@ -84,8 +204,7 @@ init_variant (readosm_variant * variant, int little_endian_cpu)
     variant->length = 0;
     variant->pointer = NULL;
     variant->valid = 0;
-    variant->first = NULL;
-    variant->last = NULL;
+    variant->fields = fields;
 }
 
 static void
@@ -99,399 +218,387 @@ reset_variant (readosm_variant * variant)
     variant->valid = 0;
 }
 
-static void
-add_variant_hints (readosm_variant * variant, unsigned char type,
-		   unsigned char field_id)
-{
-/* adding a field hint to a PBF Variant object */
-    readosm_variant_hint *hint = malloc (sizeof (readosm_variant_hint));
-    hint->type = type;
-    hint->field_id = field_id;
-    hint->next = NULL;
-    if (variant->first == NULL)
-	variant->first = hint;
-    if (variant->last != NULL)
-	variant->last->next = hint;
-    variant->last = hint;
-}
-
 static int
-find_type_hint (readosm_variant * variant, unsigned char field_id,
+find_type_hint (readosm_variant * variant, unsigned int field_id,
 		unsigned char type, unsigned char *type_hint)
 {
 /* attempting to find the type hint for some PBF Variant field */
-    readosm_variant_hint *hint = variant->first;
-    while (hint)
+    const readosm_field_table *fields = variant->fields;
+    unsigned char hint;
+    if (fields == NULL || field_id > fields->max_field_id)
+	return 0;
+    hint = fields->types[field_id];
+    switch (type)
       {
-	  if (hint->field_id == field_id)
+      case 0:
+	  switch (hint)
 	    {
-		switch (type)
-		  {
-		  case 0:
-		      switch (hint->type)
-			{
-			case READOSM_VAR_INT32:
-			case READOSM_VAR_INT64:
-			case READOSM_VAR_UINT32:
-			case READOSM_VAR_UINT64:
-			case READOSM_VAR_SINT32:
-			case READOSM_VAR_SINT64:
-			case READOSM_VAR_BOOL:
-			case READOSM_VAR_ENUM:
-			    *type_hint = hint->type;
-			    return 1;
-			}
-		      break;
-		  case 2:
-		      if (hint->type == READOSM_LEN_BYTES)
-			{
-			    *type_hint = hint->type;
-			    return 1;
-			}
-		      break;
-		  };
+	    case READOSM_VAR_INT32:
+	    case READOSM_VAR_INT64:
+	    case READOSM_VAR_UINT32:
+	    case READOSM_VAR_UINT64:
+	    case READOSM_VAR_SINT32:
+	    case READOSM_VAR_SINT64:
+	    case READOSM_VAR_BOOL:
+	    case READOSM_VAR_ENUM:
+		*type_hint = hint;
+		return 1;
 	    }
-	  hint = hint->next;
-      }
+	  break;
+      case 2:
+	  if (hint == READOSM_LEN_BYTES)
+	    {
+		*type_hint = hint;
+		return 1;
+	    }
+	  break;
+      };
     return 0;
 }
 
-static void
-finalize_variant (readosm_variant * variant)
-{
-/* cleaning any memory allocation for a PBF Variant object */
-    readosm_variant_hint *hint;
-    readosm_variant_hint *hint_n;
-    hint = variant->first;
-    while (hint)
-      {
-	  hint_n = hint->next;
-	  free (hint);
-	  hint = hint_n;
-      }
-    variant->first = NULL;
-    variant->last = NULL;
-}
-
 static void
 init_string_table (readosm_string_table * string_table)
 {
 /* initializing an empty PBF StringTable object */
-    string_table->first = NULL;
-    string_table->last = NULL;
     string_table->count = 0;
+    string_table->max = 0;
     string_table->strings = NULL;
+    string_table->buffer = NULL;
+    string_table->buffer_used = 0;
+    string_table->buffer_max = 0;
 }
 
 static void
-append_string_to_table (readosm_string_table * string_table,
-			readosm_variant * variant)
+reset_string_table (readosm_string_table * string_table)
 {
-/* appending a string to a PBF StringTable object */
-    readosm_string *string = malloc (sizeof (readosm_string));
-    string->string = malloc (variant->length + 1);
-    memcpy (string->string, variant->pointer, variant->length);
-    *(string->string + variant->length) = '\0';
-    string->next = NULL;
-    if (string_table->first == NULL)
-	string_table->first = string;
-    if (string_table->last != NULL)
-	string_table->last->next = string;
-    string_table->last = string;
+/* resetting a StringTable to empty state (preserving its buffers) */
+    string_table->count = 0;
+    string_table->buffer_used = 0;
 }
 
-static void
-array_from_string_table (readosm_string_table * string_table)
+static int
+grow_string_table (readosm_string_table * string_table, int count,
+		   size_t bytes)
 {
-/* creating a pointer array supporting a StringTable object */
-    int i;
-    readosm_string *string = string_table->first;
-    while (string != NULL)
+/* ensuring room for further COUNT strings requiring BYTES bytes */
+    if (string_table->count + count > string_table->max)
       {
-	  /* counting how many strings are into the table */
-	  string_table->count++;
-	  string = string->next;
+	  int max = string_table->count + count;
+	  readosm_string *strings = realloc (string_table->strings,
+					     sizeof (readosm_string) * max);
+	  if (strings == NULL)
+	      return 0;
+	  string_table->strings = strings;
+	  string_table->max = max;
       }
-    if (string_table->count <= 0)
-	return;
-
-/* allocating the pointer array */
-    string_table->strings =
-	malloc (sizeof (readosm_string *) * string_table->count);
-    i = 0;
-    string = string_table->first;
-    while (string != NULL)
+    if (string_table->buffer_used + bytes > string_table->buffer_max)
       {
-	  /* setting up pointers to strings */
-	  *(string_table->strings + i) = string;
-	  i++;
-	  string = string->next;
+	  /* strings already stored must be relocated */
+	  int i;
+	  size_t max = string_table->buffer_used + bytes;
+	  char *buffer = malloc (max);
+	  if (buffer == NULL)
+	      return 0;
+	  if (string_table->buffer != NULL)
+	    {
+		char *old = string_table->buffer;
+		memcpy (buffer, old, string_table->buffer_used);
+		for (i = 0; i < string_table->count; i++)
+		  {
+		      readosm_string *string = string_table->strings + i;
+		      if (string->string >= old
+			  && string->string < old + string_table->buffer_used)
+			  string->string = buffer + (string->string - old);
+		  }
+		free (string_table->buffer);
+	    }
+	  string_table->buffer = buffer;
+	  string_table->buffer_max = max;
       }
+    return 1;
+}
+
+static readosm_string *
+append_string_to_table (readosm_string_table * string_table,
+			readosm_variant * variant)
+{
+/* 
+ / appending a string to a PBF StringTable object
+ / (room has already been reserved by grow_string_table)
+ /
+ / the string simply points into the PrimitiveBlock itself; the
+ / caller is responsible for NULL terminating it later on
+*/
+    readosm_string *string = string_table->strings + string_table->count;
+    string->string = (char *) (variant->pointer);
+    string->length = (int) (variant->length);
+    string_table->count += 1;
+    return string;
+}
+
+static void
+copy_string_to_buffer (readosm_string_table * string_table,
+		       readosm_string * string)
+{
+/* 
+ / copying a string into the StringTable side buffer, so to
+ / NULL terminate it without touching the PrimitiveBlock
+*/
+    char *copy = string_table->buffer + string_table->buffer_used;
+    memcpy (copy, string->string, string->length);
+    *(copy + string->length) = '\0';
+    string->string = copy;
+    string_table->buffer_used += string->length + 1;
 }
 
 static void
 finalize_string_table (readosm_string_table * string_table)
 {
 /* cleaning any memory allocation for a StringTable object */
-    readosm_string *string;
-    readosm_string *string_n;
-    string = string_table->first;
-    while (string)
-      {
-	  string_n = string->next;
-	  if (string->string)
-	      free (string->string);
-	  free (string);
-	  string = string_n;
-      }
     if (string_table->strings)
 	free (string_table->strings);
+    if (string_table->buffer)
+	free (string_table->buffer);
 }
 
 static void
 init_uint32_packed (readosm_uint32_packed * packed)
 {
 /* initialing an empty PBF uint32 packed object */
-    packed->first = NULL;
-    packed->last = NULL;
     packed->count = 0;
+    packed->max = 0;
     packed->values = NULL;
 }
 
-static void
-append_uint32_packed (readosm_uint32_packed * packed, unsigned int val)
-{
-/* appending an uint32 value to a PBF packed object */
-    readosm_uint32 *value = malloc (sizeof (readosm_uint32));
-    value->value = val;
-    value->next = NULL;
-    if (packed->first == NULL)
-	packed->first = value;
-    if (packed->last != NULL)
-	packed->last->next = value;
-    packed->last = value;
-}
-
-static void
-array_from_uint32_packed (readosm_uint32_packed * packed)
+static int
+grow_uint32_packed (readosm_uint32_packed * packed, int needed)
 {
-/* creating an array supporting an uint32 packed object */
-    int i;
-    readosm_uint32 *value = packed->first;
-    while (value != NULL)
-      {
-	  /* counting how many values are into the packed list */
-	  packed->count++;
-	  value = value->next;
-      }
-    if (packed->count <= 0)
-	return;
-
-/* allocating the array */
-    packed->values = malloc (sizeof (unsigned int) * packed->count);
-    i = 0;
-    value = packed->first;
-    while (value != NULL)
-      {
-	  /* setting up array values */
-	  *(packed->values + i) = value->value;
-	  i++;
-	  value = value->next;
-      }
+/* ensuring room for further NEEDED values into a PBF packed object */
+    unsigned int *values;
+    int max = packed->count + needed;
+    if (max <= packed->max)
+	return 1;
+    values = realloc (packed->values, sizeof (unsigned int) * max);
+    if (values == NULL)
+	return 0;
+    packed->values = values;
+    packed->max = max;
+    return 1;
 }
 
 static void
 finalize_uint32_packed (readosm_uint32_packed * packed)
 {
 /* cleaning any memory allocation for an uint32 packed object */
-    readosm_uint32 *value;
-    readosm_uint32 *value_n;
-    value = packed->first;
-    while (value)
-      {
-	  value_n = value->next;
-	  free (value);
-	  value = value_n;
-      }
     if (packed->values)
 	free (packed->values);
-
-}
-
-static void
-reset_uint32_packed (readosm_uint32_packed * packed)
-{
-/* resetting an uint32 packed object to empty initial state */
-    finalize_uint32_packed (packed);
-    packed->first = NULL;
-    packed->last = NULL;
-    packed->count = 0;
-    packed->values = NULL;
 }
 
 static void
 init_int32_packed (readosm_int32_packed * packed)
 {
 /* initialing an empty PBF int32 packed object */
-    packed->first = NULL;
-    packed->last = NULL;
     packed->count = 0;
+    packed->max = 0;
     packed->values = NULL;
 }
 
-static void
-append_int32_packed (readosm_int32_packed * packed, int val)
+static int
+grow_int32_packed (readosm_int32_packed * packed, int needed)
 {
-/* appending an int32 value to a PBF packed object */
-    readosm_int32 *value = malloc (sizeof (readosm_int32));
-    value->value = val;
-    value->next = NULL;
-    if (packed->first == NULL)
-	packed->first = value;
-    if (packed->last != NULL)
-	packed->last->next = value;
-    packed->last = value;
+/* ensuring room for further NEEDED values into a PBF packed object */
+    int *values;
+    int max = packed->count + needed;
+    if (max <= packed->max)
+	return 1;
+    values = realloc (packed->values, sizeof (int) * max);
+    if (values == NULL)
+	return 0;
+    packed->values = values;
+    packed->max = max;
+    return 1;
 }
 
 static void
 finalize_int32_packed (readosm_int32_packed * packed)
 {
 /* cleaning any memory allocation for an int32 packed object */
-    readosm_int32 *value;
-    readosm_int32 *value_n;
-    value = packed->first;
-    while (value)
-      {
-	  value_n = value->next;
-	  free (value);
-	  value = value_n;
-      }
     if (packed->values)
 	free (packed->values);
-
 }
 
 static void
-reset_int32_packed (readosm_int32_packed * packed)
+init_int64_packed (readosm_int64_packed * packed)
 {
-/* resetting an int32 packed object to empty initial state */
-    finalize_int32_packed (packed);
-    packed->first = NULL;
-    packed->last = NULL;
+/* initialing an empty PBF int64 packed object */
     packed->count = 0;
+    packed->max = 0;
     packed->values = NULL;
 }
 
+static int
+grow_int64_packed (readosm_int64_packed * packed, int needed)
+{
+/* ensuring room for further NEEDED values into a PBF packed object */
+    long long *values;
+    int max = packed->count + needed;
+    if (max <= packed->max)
+	return 1;
+    values = realloc (packed->values, sizeof (long long) * max);
+    if (values == NULL)
+	return 0;
+    packed->values = values;
+    packed->max = max;
+    return 1;
+}
+
 static void
-init_int64_packed (readosm_int64_packed * packed)
+finalize_int64_packed (readosm_int64_packed * packed)
 {
-/* initialing an empty PBF int64 packed object */
-    packed->first = NULL;
-    packed->last = NULL;
-    packed->count = 0;
-    packed->values = NULL;
+/* cleaning any memory allocation for an int64 packed object */
+    if (packed->values)
+	free (packed->values);
 }
 
 static void
-append_int64_packed (readosm_int64_packed * packed, long long val)
+init_packed_infos (readosm_packed_infos * packed)
 {
-/* appending an int64 value to a PBF packed object */
-    readosm_int64 *value = malloc (sizeof (readosm_int64));
-    value->value = val;
-    value->next = NULL;
-    if (packed->first == NULL)
-	packed->first = value;
-    if (packed->last != NULL)
-	packed->last->next = value;
-    packed->last = value;
+/* initialing an empty PBF  packed Infos object */
+    init_int32_packed (&(packed->versions));
+    init_int64_packed (&(packed->timestamps));
+    init_int64_packed (&(packed->changesets));
+    init_int32_packed (&(packed->uids));
+    init_int32_packed (&(packed->users));
 }
 
 static void
-array_from_int64_packed (readosm_int64_packed * packed)
+reset_packed_infos (readosm_packed_infos * packed)
 {
-/* creating an array supporting an int64 packed object */
-    int i;
-    readosm_int64 *value = packed->first;
-    while (value != NULL)
-      {
-	  /* counting how many values are into the packed list */
-	  packed->count++;
-	  value = value->next;
-      }
-    if (packed->count <= 0)
-	return;
+/* resetting a packed Infos object to empty state */
+    packed->versions.count = 0;
+    packed->timestamps.count = 0;
+    packed->changesets.count = 0;
+    packed->uids.count = 0;
+    packed->users.count = 0;
+}
 
-/* allocating the array */
-    packed->values = malloc (sizeof (long long) * packed->count);
-    i = 0;
-    value = packed->first;
-    while (value != NULL)
-      {
-	  /* setting up array values */
-	  *(packed->values + i) = value->value;
-	  i++;
-	  value = value->next;
-      }
+static void
+finalize_packed_infos (readosm_packed_infos * packed)
+{
+/* cleaning any memory allocation for a packed Infos object */
+    finalize_int32_packed (&(packed->versions));
+    finalize_int64_packed (&(packed->timestamps));
+    finalize_int64_packed (&(packed->changesets));
+    finalize_int32_packed (&(packed->uids));
+    finalize_int32_packed (&(packed->users));
 }
 
 static void
-finalize_int64_packed (readosm_int64_packed * packed)
+init_export_batch (readosm_export_batch * batch)
 {
-/* cleaning any memory allocation for an int64 packed object */
-    readosm_int64 *value;
-    readosm_int64 *value_n;
-    value = packed->first;
-    while (value)
-      {
-	  value_n = value->next;
-	  free (value);
-	  value = value_n;
-      }
-    if (packed->values)
-	free (packed->values);
+/* initializing an empty batch of export objects */
+    batch->nodes = NULL;
+    batch->max_nodes = 0;
+    batch->ways = NULL;
+    batch->way_count = 0;
+    batch->max_ways = 0;
+    batch->relations = NULL;
+    batch->relation_count = 0;
+    batch->max_relations = 0;
+    batch->members = NULL;
+    batch->member_count = 0;
+    batch->max_members = 0;
+    batch->tags = NULL;
+    batch->tag_count = 0;
+    batch->max_tags = 0;
 }
 
 static void
-reset_int64_packed (readosm_int64_packed * packed)
+reset_export_batch (readosm_export_batch * batch)
 {
-/* resetting an int64 packed object to empty initial state */
-    finalize_int64_packed (packed);
-    packed->first = NULL;
-    packed->last = NULL;
-    packed->count = 0;
-    packed->values = NULL;
+/* resetting a batch to empty state (preserving its buffers) */
+    batch->way_count = 0;
+    batch->relation_count = 0;
+    batch->member_count = 0;
+    batch->tag_count = 0;
+}
+
+static void *
+grow_batch_array (void *items, int *max, int needed, size_t item_size)
+{
+/* 
+ / ensuring room for NEEDED items into a batch array (preserving
+ / its content); NULL is returned on allocation failure
+*/
+    void *array;
+    int max_items = *max * 2;
+    if (needed <= *max)
+	return items;
+    if (max_items < needed)
+	max_items = needed;
+    array = realloc (items, item_size * max_items);
+    if (array == NULL)
+	return NULL;
+    *max = max_items;
+    return array;
 }
 
 static void
-init_packed_infos (readosm_packed_infos * packed)
+finalize_export_batch (readosm_export_batch * batch)
 {
-/* initialing an empty PBF  packed Infos object */
-    packed->ver_count = 0;
-    packed->versions = NULL;
-    packed->tim_count = 0;
-    packed->timestamps = NULL;
-    packed->cng_count = 0;
-    packed->changesets = NULL;
-    packed->uid_count = 0;
-    packed->uids = NULL;
-    packed->usr_count = 0;
-    packed->users = NULL;
+/* cleaning any memory allocation for a batch of export objects */
+    if (batch->nodes)
+	free (batch->nodes);
+    if (batch->ways)
+	free (batch->ways);
+    if (batch->relations)
+	free (batch->relations);
+    if (batch->members)
+	free (batch->members);
+    if (batch->tags)
+	free (batch->tags);
 }
 
 static void
-finalize_packed_infos (readosm_packed_infos * packed)
+init_pbf_buffers (readosm_pbf_buffers * buffers)
 {
-/* cleaning any memory allocation for a packed Infos object */
-    if (packed->versions)
-	free (packed->versions);
-    if (packed->timestamps)
-	free (packed->timestamps);
-    if (packed->changesets)
-	free (packed->changesets);
-    if (packed->uids)
-	free (packed->uids);
-    if (packed->users)
-	free (packed->users);
+/* initializing empty PBF parsing buffers */
+    init_string_table (&(buffers->strings));
+    init_uint32_packed (&(buffers->keys));
+    init_uint32_packed (&(buffers->values));
+    init_uint32_packed (&(buffers->roles));
+    init_uint32_packed (&(buffers->types));
+    init_int64_packed (&(buffers->ids));
+    init_int64_packed (&(buffers->lats));
+    init_int64_packed (&(buffers->lons));
+    init_int64_packed (&(buffers->refs));
+    init_int32_packed (&(buffers->fixed_lats));
+    init_int32_packed (&(buffers->fixed_lons));
+    init_int32_packed (&(buffers->tag_offsets));
+    init_packed_infos (&(buffers->infos));
+    init_export_batch (&(buffers->batch));
+    init_arena (&(buffers->arena));
+}
+
+static void
+finalize_pbf_buffers (readosm_pbf_buffers * buffers)
+{
+/* cleaning any memory allocation for PBF parsing buffers */
+    finalize_string_table (&(buffers->strings));
+    finalize_uint32_packed (&(buffers->keys));
+    finalize_uint32_packed (&(buffers->values));
+    finalize_uint32_packed (&(buffers->roles));
+    finalize_uint32_packed (&(buffers->types));
+    finalize_int64_packed (&(buffers->ids));
+    finalize_int64_packed (&(buffers->lats));
+    finalize_int64_packed (&(buffers->lons));
+    finalize_int64_packed (&(buffers->refs));
+    finalize_int32_packed (&(buffers->fixed_lats));
+    finalize_int32_packed (&(buffers->fixed_lons));
+    finalize_int32_packed (&(buffers->tag_offsets));
+    finalize_packed_infos (&(buffers->infos));
+    finalize_export_batch (&(buffers->batch));
+    finalize_arena (&(buffers->arena));
 }
 
 static unsigned char *
@@ -516,238 +623,34 @@ read_var (unsigned char *start, unsigned char *stop, readosm_variant * variant)
  / for more details please see:
  / https://developers.google.com/protocol-buffers/docs/encoding
 */
-    unsigned char *ptr = start;
-    unsigned char c;
+    unsigned char *ptr;
     unsigned int v32;
     unsigned long long v64;
-    unsigned int value32 = 0x00000000;
-    unsigned long long value64 = 0x0000000000000000;
-    readosm_endian4 endian4;
-    readosm_endian8 endian8;
-    int next;
-    int count = 0;
-    int neg;
-
-    while (1)
-      {
-	  if (ptr > stop)
-	      return NULL;
-	  c = *ptr++;
-	  if ((c & 0x80) == 0x80)
-	      next = 1;
-	  else
-	      next = 0;
-	  c &= 0x7f;
-	  switch (variant->type)
-	    {
-	    case READOSM_VAR_INT32:
-	    case READOSM_VAR_UINT32:
-	    case READOSM_VAR_SINT32:
-		switch (count)
-		  {
-		  case 0:
-		      memset (endian4.bytes, 0x00, 4);
-		      if (variant->little_endian_cpu)
-			  endian4.bytes[0] = c;
-		      else
-			  endian4.bytes[3] = c;
-		      v32 = endian4.uint32_value;
-		      v32 &= READOSM_MASK32_1;
-		      value32 |= v32;
-		      break;
-		  case 1:
-		      memset (endian4.bytes, 0x00, 4);
-		      if (variant->little_endian_cpu)
-			  endian4.bytes[0] = c;
-		      else
-			  endian4.bytes[3] = c;
-		      v32 = endian4.uint32_value << 7;
-		      v32 &= READOSM_MASK32_2;
-		      value32 |= v32;
-		      break;
-		  case 2:
-		      memset (endian4.bytes, 0x00, 4);
-		      if (variant->little_endian_cpu)
-			  endian4.bytes[0] = c;
-		      else
-			  endian4.bytes[3] = c;
-		      v32 = endian4.uint32_value << 14;
-		      v32 &= READOSM_MASK32_3;
-		      value32 |= v32;
-		      break;
-		  case 3:
-		      memset (endian4.bytes, 0x00, 4);
-		      if (variant->little_endian_cpu)
-			  endian4.bytes[0] = c;
-		      else
-			  endian4.bytes[3] = c;
-		      v32 = endian4.uint32_value << 21;
-		      v32 &= READOSM_MASK32_4;
-		      value32 |= v32;
-		      break;
-		  case 4:
-		      memset (endian4.bytes, 0x00, 4);
-		      if (variant->little_endian_cpu)
-			  endian4.bytes[0] = c;
-		      else
-			  endian4.bytes[3] = c;
-		      v32 = endian4.uint32_value << 28;
-		      v32 &= READOSM_MASK32_5;
-		      value32 |= v32;
-		      break;
-		  default:
-		      return NULL;
-		  };
-		break;
-	    case READOSM_VAR_INT64:
-	    case READOSM_VAR_UINT64:
-	    case READOSM_VAR_SINT64:
-		switch (count)
-		  {
-		  case 0:
-		      memset (endian8.bytes, 0x00, 8);
-		      if (variant->little_endian_cpu)
-			  endian8.bytes[0] = c;
-		      else
-			  endian8.bytes[7] = c;
-		      v64 = endian8.uint64_value;
-		      v64 &= READOSM_MASK64_1;
-		      value64 |= v64;
-		      break;
-		  case 1:
-		      memset (endian8.bytes, 0x00, 8);
-		      if (variant->little_endian_cpu)
-			  endian8.bytes[0] = c;
-		      else
-			  endian8.bytes[7] = c;
-		      v64 = endian8.uint64_value << 7;
-		      v64 &= READOSM_MASK64_2;
-		      value64 |= v64;
-		      break;
-		  case 2:
-		      memset (endian8.bytes, 0x00, 8);
-		      if (variant->little_endian_cpu)
-			  endian8.bytes[0] = c;
-		      else
-			  endian8.bytes[7] = c;
-		      v64 = endian8.uint64_value << 14;
-		      v64 &= READOSM_MASK64_3;
-		      value64 |= v64;
-		      break;
-		  case 3:
-		      memset (endian8.bytes, 0x00, 8);
-		      if (variant->little_endian_cpu)
-			  endian8.bytes[0] = c;
-		      else
-			  endian8.bytes[7] = c;
-		      v64 = endian8.uint64_value << 21;
-		      v64 &= READOSM_MASK64_4;
-		      value64 |= v64;
-		      break;
-		  case 4:
-		      memset (endian8.bytes, 0x00, 8);
-		      if (variant->little_endian_cpu)
-			  endian8.bytes[0] = c;
-		      else
-			  endian8.bytes[7] = c;
-		      v64 = endian8.uint64_value << 28;
-		      v64 &= READOSM_MASK64_5;
-		      value64 |= v64;
-		      break;
-		  case 5:
-		      memset (endian8.bytes, 0x00, 8);
-		      if (variant->little_endian_cpu)
-			  endian8.bytes[0] = c;
-		      else
-			  endian8.bytes[7] = c;
-		      v64 = endian8.uint64_value << 35;
-		      v64 &= READOSM_MASK64_6;
-		      value64 |= v64;
-		      break;
-		  case 6:
-		      memset (endian8.bytes, 0x00, 8);
-		      if (variant->little_endian_cpu)
-			  endian8.bytes[0] = c;
-		      else
-			  endian8.bytes[7] = c;
-		      v64 = endian8.uint64_value << 42;
-		      v64 &= READOSM_MASK64_7;
-		      value64 |= v64;
-		      break;
-		  case 7:
-		      memset (endian8.bytes, 0x00, 8);
-		      if (variant->little_endian_cpu)
-			  endian8.bytes[0] = c;
-		      else
-			  endian8.bytes[7] = c;
-		      v64 = endian8.uint64_value << 49;
-		      v64 &= READOSM_MASK64_8;
-		      value64 |= v64;
-		      break;
-		  case 8:
-		      memset (endian8.bytes, 0x00, 8);
-		      if (variant->little_endian_cpu)
-			  endian8.bytes[0] = c;
-		      else
-			  endian8.bytes[7] = c;
-		      v64 = endian8.uint64_value << 56;
-		      v64 &= READOSM_MASK64_9;
-		      value64 |= v64;
-		      break;
-		  case 9:
-		      memset (endian8.bytes, 0x00, 8);
-		      if (variant->little_endian_cpu)
-			  endian8.bytes[0] = c;
-		      else
-			  endian8.bytes[7] = c;
-		      v64 = endian8.uint64_value << 63;
-		      v64 &= READOSM_MASK64_A;
-		      value64 |= v64;
-		      break;
-		  default:
-		      return NULL;
-		  };
-		break;
-	    };
-	  count++;
-	  if (!next)
-	      break;
-      }
 
     switch (variant->type)
       {
       case READOSM_VAR_INT32:
-	  variant->value.int32_value = (int) value32;
-	  variant->valid = 1;
-	  return ptr;
       case READOSM_VAR_UINT32:
-	  variant->value.uint32_value = value32;
-	  variant->valid = 1;
-	  return ptr;
       case READOSM_VAR_SINT32:
-	  if ((value32 & 0x00000001) == 0)
-	      neg = 1;
+	  ptr = read_varint32 (start, stop, &v32);
+	  if (ptr == NULL)
+	      return NULL;
+	  if (variant->type == READOSM_VAR_SINT32)
+	      variant->value.int32_value = zigzag32 (v32);
 	  else
-	      neg = -1;
-	  v32 = (value32 + 1) / 2;
-	  variant->value.int32_value = v32 * neg;
+	      variant->value.uint32_value = v32;
 	  variant->valid = 1;
 	  return ptr;
       case READOSM_VAR_INT64:
-	  variant->value.int64_value = (int) value64;
-	  variant->valid = 1;
-	  return ptr;
       case READOSM_VAR_UINT64:
-	  variant->value.uint64_value = value64;
-	  variant->valid = 1;
-	  return ptr;
       case READOSM_VAR_SINT64:
-	  if ((value64 & 0x0000000000000001) == 0)
-	      neg = 1;
+	  ptr = read_varint64 (start, stop, &v64);
+	  if (ptr == NULL)
+	      return NULL;
+	  if (variant->type == READOSM_VAR_SINT64)
+	      variant->value.int64_value = zigzag64 (v64);
 	  else
-	      neg = -1;
-	  v64 = (value64 + 1) / 2;
-	  variant->value.int64_value = v64 * neg;
+	      variant->value.uint64_value = v64;
 	  variant->valid = 1;
 	  return ptr;
       };
@@ -764,109 +667,91 @@ read_bytes (unsigned char *start, unsigned char *stop,
  / - an INT32 field declares the expected length
  / - then the string (no terminating NULL char) follows
 */
-    unsigned char *ptr = start;
-    readosm_variant varlen;
+    unsigned char *ptr;
     unsigned int len;
 
-/* initializing an empty variant field (length) */
-    init_variant (&varlen, variant->little_endian_cpu);
-    varlen.type = READOSM_VAR_UINT32;
-
-    ptr = read_var (ptr, stop, &varlen);
-    if (varlen.valid)
-      {
-	  len = varlen.value.uint32_value;
-	  if ((ptr + len - 1) > stop)
-	      return NULL;
-	  variant->pointer = ptr;
-	  variant->length = len;
-	  variant->valid = 1;
-	  return ptr + len;
-      }
-    return NULL;
+    ptr = read_varint32 (start, stop, &len);
+    if (ptr == NULL)
+	return NULL;
+    if (len > (size_t) (stop - ptr + 1))
+	return NULL;
+    variant->pointer = ptr;
+    variant->length = len;
+    variant->valid = 1;
+    return ptr + len;
 }
 
 static int
 parse_uint32_packed (readosm_uint32_packed * packed, unsigned char *start,
-		     unsigned char *stop, char little_endian_cpu)
+		     unsigned char *stop)
 {
 /* parsing a uint32 packed object */
-    unsigned char *ptr = start;
-    readosm_variant variant;
+    int count;
 
-/* initializing an empty variant field (length) */
-    init_variant (&variant, little_endian_cpu);
-    variant.type = READOSM_VAR_UINT32;
+/* each varint requires at least one byte */
+    if (!grow_uint32_packed (packed, (int) (stop - start + 1) +
+			    READOSM_PACKED_SLACK))
+	return 0;
+    count = decode_packed_uint32 (start, stop, packed->values + packed->count);
+    if (count < 0)
+	return 0;
+    packed->count += count;
+    return 1;
+}
 
-    while (1)
-      {
-	  ptr = read_var (start, stop, &variant);
-	  if (variant.valid)
-	    {
-		append_uint32_packed (packed, variant.value.uint32_value);
-		if (ptr > stop)
-		    break;
-		start = ptr;
-		continue;
-	    }
-	  return 0;
-      }
+static int
+parse_int32_packed (readosm_int32_packed * packed, unsigned char *start,
+		    unsigned char *stop)
+{
+/* parsing an int32 packed object (not ZigZag encoded) */
+    int count;
+
+/* each varint requires at least one byte */
+    if (!grow_int32_packed (packed, (int) (stop - start + 1) +
+			    READOSM_PACKED_SLACK))
+	return 0;
+    count = decode_packed_uint32 (start, stop,
+				  (unsigned int *) (packed->values +
+						    packed->count));
+    if (count < 0)
+	return 0;
+    packed->count += count;
     return 1;
 }
 
 static int
 parse_sint32_packed (readosm_int32_packed * packed, unsigned char *start,
-		     unsigned char *stop, char little_endian_cpu)
+		     unsigned char *stop)
 {
 /* parsing an int32 packed object */
-    unsigned char *ptr = start;
-    readosm_variant variant;
-
-/* initializing an empty variant field (length) */
-    init_variant (&variant, little_endian_cpu);
-    variant.type = READOSM_VAR_SINT32;
+    int count;
 
-    while (1)
-      {
-	  ptr = read_var (start, stop, &variant);
-	  if (variant.valid)
-	    {
-		append_int32_packed (packed, variant.value.int32_value);
-		if (ptr > stop)
-		    break;
-		start = ptr;
-		continue;
-	    }
-	  return 0;
-      }
+/* each varint requires at least one byte */
+    if (!grow_int32_packed (packed, (int) (stop - start + 1) +
+			    READOSM_PACKED_SLACK))
+	return 0;
+    count = decode_packed_sint32 (start, stop, packed->values + packed->count);
+    if (count < 0)
+	return 0;
+    packed->count += count;
     return 1;
 }
 
 static int
 parse_sint64_packed (readosm_int64_packed * packed, unsigned char *start,
-		     unsigned char *stop, char little_endian_cpu)
+		     unsigned char *stop)
 {
 /* parsing a sint64 packed object */
-    unsigned char *ptr = start;
-    readosm_variant variant;
-
-/* initializing an empty variant field (length) */
-    init_variant (&variant, little_endian_cpu);
-    variant.type = READOSM_VAR_SINT64;
+    int count;
 
-    while (1)
-      {
-	  ptr = read_var (start, stop, &variant);
-	  if (variant.valid)
-	    {
-		append_int64_packed (packed, variant.value.int64_value);
-		if (ptr > stop)
-		    break;
-		start = ptr;
-		continue;
-	    }
-	  return 0;
-      }
+/* each varint requires at least one byte */
+    if (!grow_int64_packed (packed, (int) (stop - start + 1) +
+			    READOSM_PACKED_SLACK))
+	return 0;
+    count = decode_packed_sint64 (start, stop, packed->values + packed->count);
+    if (count < 0)
+	return 0;
+    packed->count += count;
     return 1;
 }
 
@@ -896,6 +781,52 @@ get_header_size (unsigned char *buf, int little_endian_cpu)
     return endian4.uint32_value;
 }
 
+static unsigned char *
+skip_field (unsigned char *start, unsigned char *stop, unsigned char type,
+	    readosm_variant * variant)
+{
+/* skipping an unknown field, accordingly to its wire type */
+    unsigned char *ptr = start;
+    readosm_variant varlen;
+    switch (type)
+      {
+      case 0:
+	  /* varint */
+	  while (ptr <= stop)
+	    {
+		if ((*ptr++ & 0x80) == 0)
+		  {
+		      variant->valid = 1;
+		      return ptr;
+		  }
+	    }
+	  return NULL;
+      case 1:
+	  /* fixed 64 bit */
+	  ptr += 8;
+	  break;
+      case 2:
+	  /* length-delimited */
+	  init_variant (&varlen, variant->little_endian_cpu, NULL);
+	  varlen.type = READOSM_VAR_UINT32;
+	  ptr = read_var (ptr, stop, &varlen);
+	  if (!varlen.valid)
+	      return NULL;
+	  ptr += varlen.value.uint32_value;
+	  break;
+      case 5:
+	  /* fixed 32 bit */
+	  ptr += 4;
+	  break;
+      default:
+	  return NULL;
+      };
+    if (ptr > stop + 1)
+	return NULL;
+    variant->valid = 1;
+    return ptr;
+}
+
 static unsigned char *
 parse_field (unsigned char *start, unsigned char *stop,
 	     readosm_variant * variant)
@@ -903,27 +834,36 @@ parse_field (unsigned char *start, unsigned char *stop,
 /* attempting to parse a variant field */
     unsigned char *ptr = start;
     unsigned char type;
-    unsigned char field_id;
+    unsigned int field_id;
     unsigned char type_hint;
+    unsigned int tag;
 
     if (ptr > stop)
 	return NULL;
 
 /*
- / any PBF field is prefixed by a single byte
+ / any PBF field is prefixed by a base128 varint tag
  / a bitwise mask is used so to store both the
- / field-id and the field-type on a single byte
+ / field-id and the field-type on the same tag; field-ids
+ / lesser than 16 simply require a single byte
 */
-    type = *ptr & 0x07;
-    field_id = (*ptr & 0xf8) >> 3;
+    ptr = read_varint32 (ptr, stop, &tag);
+    if (ptr == NULL)
+	return NULL;
+    type = tag & 0x07;
+    field_id = tag >> 3;
 
 /* attempting to identify the field accordingly to declared hints */
     if (!find_type_hint (variant, field_id, type, &type_hint))
-	return NULL;
+      {
+	  /* unknown field: simply skipping it */
+	  variant->type = READOSM_VAR_UNDEFINED;
+	  variant->field_id = 0;
+	  return skip_field (ptr, stop, type, variant);
+      }
 
     variant->type = type_hint;
     variant->field_id = field_id;
-    ptr++;
 
 /* parsing the field value */
     switch (variant->type)
@@ -942,36 +882,104 @@ parse_field (unsigned char *start, unsigned char *stop,
 }
 
 static int
-skip_osm_header (readosm_file * input, unsigned int sz)
+read_header_size (readosm_file * input, unsigned int *hdsz)
 {
-/*
- / expecting to retrieve a valid OSMHeader header 
- / there is nothing really interesting here, so we'll
- / simply discard the whole block, simply advancing
- / the read file-pointer as appropriate
+/* 
+ / attempting to read the 4 bytes BlobHeader size
+ / returns 1 on success, 0 on a clean EOF and -1 on error
+*/
+    unsigned char buf[4];
+    unsigned char *ptr;
+    size_t rd;
+    if (input->map != NULL)
+      {
+	  /* memory-mapped input */
+	  if (input->map_pos == input->map_size)
+	      return 0;
+	  if (input->map_size - input->map_pos < 4)
+	      return -1;
+	  ptr = input->map + input->map_pos;
+	  input->map_pos += 4;
+      }
+    else
+      {
+	  /* stdio input */
+	  rd = fread (buf, 1, 4, input->in);
+	  if (rd == 0 && feof (input->in))
+	      return 0;
+	  if (rd != 4)
+	      return -1;
+	  ptr = buf;
+      }
+    *hdsz = get_header_size (ptr, input->little_endian_cpu);
+    return 1;
+}
+
+static unsigned char *
+read_pbf_block (readosm_file * input, unsigned int sz, unsigned char **buf)
+{
+/* 
+ / attempting to read the next SZ bytes from the PBF file
+ /
+ / on a memory-mapped file a pointer straight into the mapped
+ / pages is returned and no buffer is allocated at all; 
+ / otherwise the bytes are read into a freshly allocated
+ / buffer (*buf), that the caller is expected to free
+*/
+    *buf = NULL;
+    if (sz == 0)
+	return NULL;
+    if (input->map != NULL)
+      {
+	  /* memory-mapped input: zero-copy */
+	  unsigned char *ptr;
+	  if (sz > input->map_size - input->map_pos)
+	      return NULL;
+	  ptr = input->map + input->map_pos;
+	  input->map_pos += sz;
+	  return ptr;
+      }
+
+/* stdio input */
+    *buf = malloc (sz);
+    if (*buf == NULL)
+	return NULL;
+    if (fread (*buf, 1, sz, input->in) != sz)
+	return NULL;
+    return *buf;
+}
+
+static int
+read_blob_header (readosm_file * input, unsigned int sz, const char *type,
+		  unsigned int *datasize)
+{
+/* 
+ / attempting to read a BlobHeader (SZ bytes) and to check
+ / its declared type
+ / returns 1 when the block type matches TYPE, 0 when it 
+ / doesn't (a valid block of some other type) and -1 on error
+ / on success *datasize will contain the size of the Blob
 */
     int ok_header = 0;
     int hdsz = 0;
-    size_t rd;
-    unsigned char *buf = malloc (sz);
-    unsigned char *base = buf;
-    unsigned char *start = buf;
-    unsigned char *stop = buf + sz - 1;
+    size_t len = strlen (type);
+    unsigned char *buf = NULL;
+    unsigned char *base;
+    unsigned char *start;
+    unsigned char *stop;
     readosm_variant variant;
-    if (buf == NULL)
-	goto error;
+
+    *datasize = 0;
 
 /* initializing an empty variant field */
-    init_variant (&variant, input->little_endian_cpu);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 1);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 2);
-    add_variant_hints (&variant, READOSM_VAR_INT32, 3);
+    init_variant (&variant, input->little_endian_cpu, &blob_header_fields);
 
-    rd = fread (buf, 1, sz, input->in);
-    if (rd != sz)
+    start = read_pbf_block (input, sz, &buf);
+    if (start == NULL)
 	goto error;
+    stop = start + sz - 1;
 
-/* reading the OSMHeader header */
+/* reading the BlobHeader */
     while (1)
       {
 	  /* resetting an empty variant field */
@@ -982,9 +990,9 @@ skip_osm_header (readosm_file * input, unsigned int sz)
 	      goto error;
 	  start = base;
 	  if (variant.field_id == 1 && variant.type == READOSM_LEN_BYTES
-	      && variant.length == 9)
+	      && variant.length == len)
 	    {
-		if (memcmp (variant.pointer, "OSMHeader", 9) == 0)
+		if (memcmp (variant.pointer, type, len) == 0)
 		    ok_header = 1;
 	    }
 	  if (variant.field_id == 3 && variant.type == READOSM_VAR_INT32)
@@ -992,33 +1000,137 @@ skip_osm_header (readosm_file * input, unsigned int sz)
 	  if (base > stop)
 	      break;
       }
-    free (buf);
-    buf = NULL;
-    if (!ok_header || !hdsz)
-	goto error;
-
-    buf = malloc (hdsz);
-    base = buf;
-    start = buf;
-    stop = buf + hdsz - 1;
-    rd = fread (buf, 1, hdsz, input->in);
-    if ((int) rd != hdsz)
-	goto error;
+    if (buf != NULL)
+	free (buf);
+    if (hdsz <= 0)
+	return -1;
+    *datasize = hdsz;
+    return ok_header;
 
+  error:
     if (buf != NULL)
 	free (buf);
-    finalize_variant (&variant);
+    return -1;
+}
+
+static int
+skip_pbf_block (readosm_file * input, unsigned int sz)
+{
+/* attempting to skip the next SZ bytes from the PBF file */
+    if (input->map != NULL)
+      {
+	  /* memory-mapped input */
+	  if (sz > input->map_size - input->map_pos)
+	      return 0;
+	  input->map_pos += sz;
+	  return 1;
+      }
+
+/* stdio input */
+    if (readosm_fseek (input->in, sz, SEEK_CUR) != 0)
+	return 0;
     return 1;
+}
+
+static int
+skip_osm_header (readosm_file * input, unsigned int sz)
+{
+/*
+ / expecting to retrieve a valid OSMHeader header 
+ / there is nothing really interesting here, so we'll
+ / simply discard the whole block, simply advancing
+ / the read file-pointer as appropriate
+*/
+    unsigned int hdsz;
+    unsigned char *buf = NULL;
+
+    if (read_blob_header (input, sz, "OSMHeader", &hdsz) != 1)
+	return 0;
+
+    if (read_pbf_block (input, hdsz, &buf) == NULL)
+      {
+	  if (buf != NULL)
+	      free (buf);
+	  return 0;
+      }
 
-  error:
     if (buf != NULL)
 	free (buf);
-    finalize_variant (&variant);
-    return 0;
+    return 1;
+}
+
+READOSM_PRIVATE readosm_pbf_decoder *
+alloc_pbf_decoder (void)
+{
+/* allocating an empty PBF decoder context */
+    readosm_pbf_decoder *decoder = malloc (sizeof (readosm_pbf_decoder));
+    if (decoder == NULL)
+	return NULL;
+    decoder->raw_buf = NULL;
+    decoder->raw_max = 0;
+    decoder->strm_ready = 0;
+#ifdef HAVE_LIBDEFLATE
+    decoder->inflater = NULL;
+#endif
+#ifdef HAVE_LIBZSTD
+    decoder->zstd = NULL;
+#endif
+    init_pbf_buffers (&(decoder->buffers));
+    return decoder;
+}
+
+READOSM_PRIVATE void
+destroy_pbf_decoder (readosm_pbf_decoder * decoder)
+{
+/* destroying a PBF decoder context */
+    if (decoder == NULL)
+	return;
+    if (decoder->raw_buf != NULL)
+	free (decoder->raw_buf);
+    if (decoder->strm_ready)
+	inflateEnd (&(decoder->strm));
+#ifdef HAVE_LIBDEFLATE
+    if (decoder->inflater != NULL)
+	libdeflate_free_decompressor (decoder->inflater);
+#endif
+#ifdef HAVE_LIBZSTD
+    if (decoder->zstd != NULL)
+	ZSTD_freeDCtx (decoder->zstd);
+#endif
+    finalize_pbf_buffers (&(decoder->buffers));
+    free (decoder);
+}
+
+READOSM_PRIVATE readosm_pbf_decoder *
+get_pbf_decoder (readosm_file * input)
+{
+/* returning the decoder context owned by the input handle */
+    if (input->decoder == NULL)
+	input->decoder = alloc_pbf_decoder ();
+    return input->decoder;
+}
+
+static unsigned char *
+get_inflate_buffer (readosm_pbf_decoder * decoder, unsigned int raw_sz)
+{
+/* returning an inflate buffer of (at least) RAW_SZ bytes */
+    if (raw_sz > decoder->raw_max)
+      {
+	  /* growing the buffer: the previous content is useless */
+	  if (decoder->raw_buf != NULL)
+	      free (decoder->raw_buf);
+	  decoder->raw_max = 0;
+	  decoder->raw_buf = malloc (raw_sz);
+	  if (decoder->raw_buf == NULL)
+	      return NULL;
+	  decoder->raw_max = raw_sz;
+      }
+    return decoder->raw_buf;
 }
 
 static int
-unzip_compressed_block (unsigned char *zip_ptr, unsigned int zip_sz,
+unzip_compressed_block (readosm_pbf_decoder * decoder,
+			unsigned char *zip_ptr, unsigned int zip_sz,
 			unsigned char *raw_ptr, unsigned int raw_sz)
 {
 /* 
@@ -1028,18 +1140,105 @@ unzip_compressed_block (unsigned char *zip_ptr, unsigned int zip_sz,
  /
  / both the compressed and uncompressed sizes are declared
  / for each PBF ZIPped block
+ /
+ / the zlib stream is initialized only once, and then simply
+ / reset for each subsequent block
+ /
+ / when libdeflate is available it will be used instead of zlib:
+ / the whole uncompressed size being always known in advance,
+ / a whole-buffer decompressor is definitely faster than a
+ / streaming one
 */
-    uLongf size = raw_sz;
-    int ret = uncompress (raw_ptr, &size, zip_ptr, zip_sz);
-    if (ret != Z_OK || size != raw_sz)
+#ifdef HAVE_LIBDEFLATE
+    size_t size;
+    if (decoder->inflater == NULL)
+      {
+	  decoder->inflater = libdeflate_alloc_decompressor ();
+	  if (decoder->inflater == NULL)
+	      return 0;
+      }
+    if (libdeflate_zlib_decompress
+	(decoder->inflater, zip_ptr, zip_sz, raw_ptr, raw_sz,
+	 &size) != LIBDEFLATE_SUCCESS || size != raw_sz)
+	return 0;
+    return 1;
+#else
+    int ret;
+    z_stream *strm = &(decoder->strm);
+    if (!decoder->strm_ready)
+      {
+	  strm->zalloc = Z_NULL;
+	  strm->zfree = Z_NULL;
+	  strm->opaque = Z_NULL;
+	  strm->next_in = Z_NULL;
+	  strm->avail_in = 0;
+	  if (inflateInit (strm) != Z_OK)
+	      return 0;
+	  decoder->strm_ready = 1;
+      }
+    else if (inflateReset (strm) != Z_OK)
+	return 0;
+    strm->next_in = zip_ptr;
+    strm->avail_in = zip_sz;
+    strm->next_out = raw_ptr;
+    strm->avail_out = raw_sz;
+    ret = inflate (strm, Z_FINISH);
+    if (ret != Z_STREAM_END || strm->total_out != raw_sz)
 	return 0;
     return 1;
+#endif
+}
+
+static int
+decompress_block (readosm_pbf_decoder * decoder, int compression,
+		  unsigned char *zip_ptr, unsigned int zip_sz,
+		  unsigned char *raw_ptr, unsigned int raw_sz)
+{
+/* 
+ / decompressing a compressed block 
+ / returns READOSM_OK on success, otherwise an error code
+*/
+    switch (compression)
+      {
+      case READOSM_BLOB_ZLIB:
+	  if (!unzip_compressed_block
+	      (decoder, zip_ptr, zip_sz, raw_ptr, raw_sz))
+	      return READOSM_UNZIP_ERROR;
+	  return READOSM_OK;
+#ifdef HAVE_LIBZSTD
+      case READOSM_BLOB_ZSTD:
+	  {
+	      size_t size;
+	      if (decoder->zstd == NULL)
+		{
+		    decoder->zstd = ZSTD_createDCtx ();
+		    if (decoder->zstd == NULL)
+			return READOSM_INSUFFICIENT_MEMORY;
+		}
+	      size =
+		  ZSTD_decompressDCtx (decoder->zstd, raw_ptr, raw_sz, zip_ptr,
+				       zip_sz);
+	      if (ZSTD_isError (size) || size != raw_sz)
+		  return READOSM_ZSTD_ERROR;
+	      return READOSM_OK;
+	  }
+#endif
+#ifdef HAVE_LIBLZ4
+      case READOSM_BLOB_LZ4:
+	  if (LZ4_decompress_safe
+	      ((const char *) zip_ptr, (char *) raw_ptr, zip_sz,
+	       raw_sz) != (int) raw_sz)
+	      return READOSM_LZ4_ERROR;
+	  return READOSM_OK;
+#endif
+      };
+    return READOSM_UNSUPPORTED_BLOB;
 }
 
 static int
 parse_string_table (readosm_string_table * string_table,
 		    unsigned char *start, unsigned char *stop,
-		    char little_endian_cpu)
+		    char little_endian_cpu, int in_place)
 {
 /* 
  / attempting to parse a StringTable 
@@ -1052,13 +1251,28 @@ parse_string_table (readosm_string_table * string_table,
  / Individual objects within the PBF file will never directly
  / encode string values; they'll use instead the corresponding
  / index referencing the appropriate string within the StringTable.
+ /
+ / strings are not copied: each one is NULL terminated in place
+ / by overwriting the first byte following it (i.e. the tag of the
+ / next field, already parsed at that point). The last string and
+ / the ones from a read-only PrimitiveBlock (IN_PLACE = 0) are
+ / instead copied into the StringTable side buffer.
 */
     readosm_variant variant;
     unsigned char *base = start;
+    size_t len = stop - start + 1;
+    readosm_string *pending = NULL;
+
+/* 
+ / each string requires at least two bytes (tag and length) so
+ / the overall StringTable size is an upper bound for both the
+ / strings count and the buffer size (including NULL terminators)
+*/
+    if (!grow_string_table (string_table, (int) (len / 2), len))
+	return 0;
 
 /* initializing an empty variant field */
-    init_variant (&variant, little_endian_cpu);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 1);
+    init_variant (&variant, little_endian_cpu, &string_table_fields);
 
 /* reading the StringTable */
     while (1)
@@ -1070,20 +1284,101 @@ parse_string_table (readosm_string_table * string_table,
 	  if (base == NULL && variant.valid == 0)
 	      goto error;
 	  start = base;
+	  if (pending != NULL)
+	    {
+		/* the previous string can now be safely terminated */
+		*(pending->string + pending->length) = '\0';
+		pending = NULL;
+	    }
 	  if (variant.field_id == 1 && variant.type == READOSM_LEN_BYTES)
-	      append_string_to_table (string_table, &variant);
+	    {
+		readosm_string *string =
+		    append_string_to_table (string_table, &variant);
+		if (in_place)
+		    pending = string;
+		else
+		    copy_string_to_buffer (string_table, string);
+	    }
 	  if (base > stop)
 	      break;
       }
+    if (pending != NULL)
+	copy_string_to_buffer (string_table, pending);
 
-    finalize_variant (&variant);
     return 1;
 
   error:
-    finalize_variant (&variant);
     return 0;
 }
 
+static void
+format_timestamp (struct pbf_params *params, char **timestamp, long long xtime)
+{
+/* formatting a PBF Timestamp as an ISO-8601 string (into the block Arena) */
+    char buf[READOSM_TIMESTAMP_SIZE];
+    if (!format_iso8601 (xtime, buf))
+	return;
+    *timestamp =
+	arena_alloc (&(params->buffers->arena), READOSM_TIMESTAMP_SIZE);
+    if (*timestamp != NULL)
+	memcpy (*timestamp, buf, READOSM_TIMESTAMP_SIZE);
+}
+
+static long long
+pbf_timestamp (struct pbf_params *params, long long value)
+{
+/* rescaling a PBF Timestamp accordingly to the block date_granularity */
+    if (params->date_granularity == 1000)
+	return value;
+    return (value * params->date_granularity) / 1000;
+}
+
+static void
+pbf_coordinates (struct pbf_params *params, readosm_export_node * nd,
+		 long long lat, long long lon)
+{
+/* 
+ / rescaling PBF coordinates accordingly to the block granularity
+ / and offsets: fixed-point coordinates are expressed in units of
+ / 100 nanodegrees, i.e. exactly the default PBF granularity
+*/
+    if (params->granularity == 100 && params->lat_offset == 0
+	&& params->lon_offset == 0)
+      {
+	  nd->fixed_latitude = (int) lat;
+	  nd->fixed_longitude = (int) lon;
+	  nd->latitude = lat / 10000000.0;
+	  nd->longitude = lon / 10000000.0;
+      }
+    else
+      {
+	  lat = params->lat_offset + (params->granularity * lat);
+	  lon = params->lon_offset + (params->granularity * lon);
+	  nd->fixed_latitude = (int) ((lat < 0 ? lat - 50 : lat + 50) / 100);
+	  nd->fixed_longitude = (int) ((lon < 0 ? lon - 50 : lon + 50) / 100);
+	  nd->latitude = lat / 1000000000.0;
+	  nd->longitude = lon / 1000000000.0;
+      }
+}
+
+static void
+delta_decode_int32 (readosm_int32_packed * packed, int from)
+{
+/* DELTA decoding all int32 values appended starting at FROM */
+    int i;
+    for (i = (from > 0) ? from : 1; i < packed->count; i++)
+	packed->values[i] += packed->values[i - 1];
+}
+
+static void
+delta_decode_int64 (readosm_int64_packed * packed, int from)
+{
+/* DELTA decoding all int64 values appended starting at FROM */
+    int i;
+    for (i = (from > 0) ? from : 1; i < packed->count; i++)
+	packed->values[i] += packed->values[i - 1];
+}
+
 static int
 parse_pbf_node_infos (readosm_packed_infos * packed_infos,
 		      unsigned char *start, unsigned char *stop,
@@ -1106,27 +1401,9 @@ parse_pbf_node_infos (readosm_packed_infos * packed_infos,
 */
     readosm_variant variant;
     unsigned char *base = start;
-    readosm_uint32_packed packed_u32;
-    readosm_uint32 *pu32;
-    readosm_int32_packed packed_32;
-    readosm_int32 *p32;
-    readosm_int64_packed packed_64;
-    readosm_int64 *p64;
-    int count;
-
-/* initializing empty packed objects */
-    init_uint32_packed (&packed_u32);
-    init_int32_packed (&packed_32);
-    init_int64_packed (&packed_64);
 
 /* initializing an empty variant field */
-    init_variant (&variant, little_endian_cpu);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 1);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 2);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 3);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 4);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 5);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 6);
+    init_variant (&variant, little_endian_cpu, &dense_infos_fields);
 
 /* reading the DenseInfo block */
     while (1)
@@ -1141,204 +1418,193 @@ parse_pbf_node_infos (readosm_packed_infos * packed_infos,
 	  if (variant.field_id == 1 && variant.type == READOSM_LEN_BYTES)
 	    {
 		/* versions: *not* delta encoded */
-		if (!parse_uint32_packed
-		    (&packed_u32, variant.pointer,
-		     variant.pointer + variant.length - 1,
-		     variant.little_endian_cpu))
+		if (!parse_int32_packed
+		    (&(packed_infos->versions), variant.pointer,
+		     variant.pointer + variant.length - 1))
 		    goto error;
-		count = 0;
-		pu32 = packed_u32.first;
-		while (pu32)
-		  {
-		      count++;
-		      pu32 = pu32->next;
-		  }
-		packed_infos->ver_count = count;
-		if (packed_infos->versions != NULL)
-		  {
-		      free (packed_infos->versions);
-		      packed_infos->versions = NULL;
-		  }
-		if (count > 0)
-		  {
-		      packed_infos->versions = malloc (sizeof (int) * count);
-		      count = 0;
-		      pu32 = packed_u32.first;
-		      while (pu32)
-			{
-			    *(packed_infos->versions + count) = pu32->value;
-			    count++;
-			    pu32 = pu32->next;
-			}
-		  }
-		reset_uint32_packed (&packed_u32);
 	    }
 	  if (variant.field_id == 2 && variant.type == READOSM_LEN_BYTES)
 	    {
 		/* timestamps: delta encoded */
-		int delta = 0;
-		if (!parse_sint32_packed
-		    (&packed_32, variant.pointer,
-		     variant.pointer + variant.length - 1,
-		     variant.little_endian_cpu))
+		int from = packed_infos->timestamps.count;
+		if (!parse_sint64_packed
+		    (&(packed_infos->timestamps), variant.pointer,
+		     variant.pointer + variant.length - 1))
 		    goto error;
-		count = 0;
-		p32 = packed_32.first;
-		while (p32)
-		  {
-		      count++;
-		      p32 = p32->next;
-		  }
-		packed_infos->tim_count = count;
-		if (packed_infos->timestamps != NULL)
-		  {
-		      free (packed_infos->timestamps);
-		      packed_infos->timestamps = NULL;
-		  }
-		if (count > 0)
-		  {
-		      packed_infos->timestamps = malloc (sizeof (int) * count);
-		      count = 0;
-		      p32 = packed_32.first;
-		      while (p32)
-			{
-			    delta += p32->value;
-			    *(packed_infos->timestamps + count) = delta;
-			    count++;
-			    p32 = p32->next;
-			}
-		  }
-		reset_int32_packed (&packed_32);
+		delta_decode_int64 (&(packed_infos->timestamps), from);
 	    }
 	  if (variant.field_id == 3 && variant.type == READOSM_LEN_BYTES)
 	    {
 		/* changesets: delta encoded */
-		long long delta = 0;
+		int from = packed_infos->changesets.count;
 		if (!parse_sint64_packed
-		    (&packed_64, variant.pointer,
-		     variant.pointer + variant.length - 1,
-		     variant.little_endian_cpu))
+		    (&(packed_infos->changesets), variant.pointer,
+		     variant.pointer + variant.length - 1))
 		    goto error;
-		count = 0;
-		p64 = packed_64.first;
-		while (p64)
-		  {
-		      count++;
-		      p64 = p64->next;
-		  }
-		packed_infos->cng_count = count;
-		if (packed_infos->changesets != NULL)
-		  {
-		      free (packed_infos->changesets);
-		      packed_infos->changesets = NULL;
-		  }
-		if (count > 0)
-		  {
-		      packed_infos->changesets =
-			  malloc (sizeof (long long) * count);
-		      count = 0;
-		      p64 = packed_64.first;
-		      while (p64)
-			{
-			    delta += p64->value;
-			    *(packed_infos->changesets + count) = delta;
-			    count++;
-			    p64 = p64->next;
-			}
-		  }
-		reset_int64_packed (&packed_64);
+		delta_decode_int64 (&(packed_infos->changesets), from);
 	    }
 	  if (variant.field_id == 4 && variant.type == READOSM_LEN_BYTES)
 	    {
 		/* uids: delta encoded */
-		int delta = 0;
+		int from = packed_infos->uids.count;
 		if (!parse_sint32_packed
-		    (&packed_32, variant.pointer,
-		     variant.pointer + variant.length - 1,
-		     variant.little_endian_cpu))
+		    (&(packed_infos->uids), variant.pointer,
+		     variant.pointer + variant.length - 1))
 		    goto error;
-		count = 0;
-		p32 = packed_32.first;
-		while (p32)
-		  {
-		      count++;
-		      p32 = p32->next;
-		  }
-		packed_infos->uid_count = count;
-		if (packed_infos->uids != NULL)
-		  {
-		      free (packed_infos->uids);
-		      packed_infos->uids = NULL;
-		  }
-		if (count > 0)
-		  {
-		      packed_infos->uids = malloc (sizeof (int) * count);
-		      count = 0;
-		      p32 = packed_32.first;
-		      while (p32)
-			{
-			    delta += p32->value;
-			    *(packed_infos->uids + count) = delta;
-			    count++;
-			    p32 = p32->next;
-			}
-		  }
-		reset_int32_packed (&packed_32);
+		delta_decode_int32 (&(packed_infos->uids), from);
 	    }
 	  if (variant.field_id == 5 && variant.type == READOSM_LEN_BYTES)
 	    {
 		/* user-names: delta encoded (index to StringTable) */
-		int delta = 0;
+		int from = packed_infos->users.count;
 		if (!parse_sint32_packed
-		    (&packed_32, variant.pointer,
-		     variant.pointer + variant.length - 1,
-		     variant.little_endian_cpu))
+		    (&(packed_infos->users), variant.pointer,
+		     variant.pointer + variant.length - 1))
 		    goto error;
-		count = 0;
-		p32 = packed_32.first;
-		while (p32)
-		  {
-		      count++;
-		      p32 = p32->next;
-		  }
-		packed_infos->usr_count = count;
-		if (packed_infos->users != NULL)
-		  {
-		      free (packed_infos->users);
-		      packed_infos->users = NULL;
-		  }
-		if (count > 0)
-		  {
-		      packed_infos->users = malloc (sizeof (int) * count);
-		      count = 0;
-		      p32 = packed_32.first;
-		      while (p32)
-			{
-			    delta += p32->value;
-			    *(packed_infos->users + count) = delta;
-			    count++;
-			    p32 = p32->next;
-			}
-		  }
-		reset_int32_packed (&packed_32);
+		delta_decode_int32 (&(packed_infos->users), from);
 	    }
 	  if (base > stop)
 	      break;
       }
-    finalize_uint32_packed (&packed_u32);
-    finalize_int32_packed (&packed_32);
-    finalize_int64_packed (&packed_64);
-    finalize_variant (&variant);
     return 1;
 
   error:
-    finalize_variant (&variant);
-    finalize_uint32_packed (&packed_u32);
-    finalize_int32_packed (&packed_32);
-    finalize_int64_packed (&packed_64);
     return 0;
 }
 
+static void
+pbf_fixed_coordinates (struct pbf_params *params,
+		       readosm_int64_packed * packed, long long offset,
+		       readosm_int32_packed * fixed)
+{
+/* 
+ / DELTA decoding a whole array of PBF coordinates, rescaling them
+ / into fixed-point values exactly as pbf_coordinates() does
+*/
+    int i;
+    long long value = 0;
+    const long long *in = packed->values;
+    int *out = fixed->values;
+    if (params->granularity == 100 && offset == 0)
+      {
+	  /* default granularity: simply narrowing */
+	  for (i = 0; i < packed->count; i++)
+	    {
+		value += in[i];
+		out[i] = (int) value;
+	    }
+      }
+    else
+      {
+	  for (i = 0; i < packed->count; i++)
+	    {
+		long long coord;
+		value += in[i];
+		coord = offset + (params->granularity * value);
+		out[i] = (int) ((coord < 0 ? coord - 50 : coord + 50) / 100);
+	    }
+      }
+    fixed->count = packed->count;
+}
+
+static int
+parse_pbf_node_columns (readosm_string_table * strings,
+			struct pbf_params *params)
+{
+/* 
+ / delivering a whole DenseNodes group in columnar form
+ /
+ / IDs are DELTA decoded in place, and coordinates are rescaled
+ / into parallel int arrays: no individual Node is reassembled
+ / at all, and Tags are exposed as a single array plus COUNT + 1
+ / offsets (the very same layout of an Arrow list column)
+*/
+    readosm_uint32_packed *packed_keys = &(params->buffers->keys);
+    readosm_int64_packed *packed_ids = &(params->buffers->ids);
+    readosm_int32_packed *fixed_lats = &(params->buffers->fixed_lats);
+    readosm_int32_packed *fixed_lons = &(params->buffers->fixed_lons);
+    readosm_int32_packed *tag_offsets = &(params->buffers->tag_offsets);
+    readosm_export_batch *batch = &(params->buffers->batch);
+    readosm_export_node_columns columns;
+    int count = packed_ids->count;
+    int i;
+    int ret;
+    int i_keys = 0;
+    int n_tags = 0;
+    void *items;
+
+    if (count == 0 || params->stop)
+	return 1;
+
+/* allocating the columns */
+    fixed_lats->count = 0;
+    fixed_lons->count = 0;
+    tag_offsets->count = 0;
+    if (!grow_int32_packed (fixed_lats, count))
+	return 0;
+    if (!grow_int32_packed (fixed_lons, count))
+	return 0;
+    if (!grow_int32_packed (tag_offsets, count + 1))
+	return 0;
+    items = grow_batch_array (batch->tags, &(batch->max_tags),
+			      (packed_keys->count / 2) + 1,
+			      sizeof (readosm_export_tag));
+    if (items == NULL)
+	return 0;
+    batch->tags = items;
+
+/* decoding IDs and coordinates */
+    delta_decode_int64 (packed_ids, 0);
+    pbf_fixed_coordinates (params, &(params->buffers->lats),
+			   params->lat_offset, fixed_lats);
+    pbf_fixed_coordinates (params, &(params->buffers->lons),
+			   params->lon_offset, fixed_lons);
+
+/* decoding packed-keys into Tags and offsets */
+    for (i = 0; i < count; i++)
+      {
+	  char *key = NULL;
+	  tag_offsets->values[i] = n_tags;
+	  for (; i_keys < packed_keys->count; i_keys++)
+	    {
+		int is = packed_keys->values[i_keys];
+		if (is == 0)
+		  {
+		      /* next Node */
+		      i_keys++;
+		      break;
+		  }
+		if (key == NULL)
+		    key = strings->strings[is].string;
+		else
+		  {
+		      readosm_export_tag *p_tag = batch->tags + n_tags;
+		      p_tag->key = key;
+		      p_tag->value = strings->strings[is].string;
+		      n_tags++;
+		      key = NULL;
+		  }
+	    }
+      }
+    tag_offsets->values[count] = n_tags;
+    tag_offsets->count = count + 1;
+
+/* READONLY-COLUMNS simply are the same as export COLUMNS */
+    columns.count = count;
+    columns.ids = packed_ids->values;
+    columns.fixed_latitudes = fixed_lats->values;
+    columns.fixed_longitudes = fixed_lons->values;
+    columns.tag_offsets = tag_offsets->values;
+    columns.tags = (n_tags > 0) ? batch->tags : NULL;
+    ret =
+	(*params->node_columns_callback) (params->user_data,
+					  (const readosm_node_columns *)
+					  &columns);
+    if (ret != READOSM_OK)
+	params->stop = 1;
+    return 1;
+}
+
 static int
 parse_pbf_nodes (readosm_string_table * strings,
 		 unsigned char *start, unsigned char *stop,
@@ -1366,30 +1632,26 @@ parse_pbf_nodes (readosm_string_table * strings,
 */
     readosm_variant variant;
     unsigned char *base = start;
-    readosm_uint32_packed packed_keys;
-    readosm_int64_packed packed_ids;
-    readosm_int64_packed packed_lats;
-    readosm_int64_packed packed_lons;
-    readosm_packed_infos packed_infos;
-    readosm_internal_node *nodes = NULL;
+    readosm_uint32_packed *packed_keys = &(params->buffers->keys);
+    readosm_int64_packed *packed_ids = &(params->buffers->ids);
+    readosm_int64_packed *packed_lats = &(params->buffers->lats);
+    readosm_int64_packed *packed_lons = &(params->buffers->lons);
+    readosm_packed_infos *packed_infos = &(params->buffers->infos);
+    readosm_export_batch *batch = &(params->buffers->batch);
+    void *items;
     int nd_count = 0;
     int valid = 0;
     int fromPackedInfos = 0;
 
-/* initializing empty packed objects */
-    init_uint32_packed (&packed_keys);
-    init_int64_packed (&packed_ids);
-    init_int64_packed (&packed_lats);
-    init_int64_packed (&packed_lons);
-    init_packed_infos (&packed_infos);
+/* resetting the (reusable) packed objects */
+    packed_keys->count = 0;
+    packed_ids->count = 0;
+    packed_lats->count = 0;
+    packed_lons->count = 0;
+    reset_packed_infos (packed_infos);
 
 /* initializing an empty variant field */
-    init_variant (&variant, little_endian_cpu);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 1);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 5);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 8);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 9);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 10);
+    init_variant (&variant, little_endian_cpu, &dense_nodes_fields);
 
 /* reading the Node */
     while (1)
@@ -1405,16 +1667,16 @@ parse_pbf_nodes (readosm_string_table * strings,
 	    {
 		/* NODE IDs */
 		if (!parse_sint64_packed
-		    (&packed_ids, variant.pointer,
-		     variant.pointer + variant.length - 1,
-		     variant.little_endian_cpu))
+		    (packed_ids, variant.pointer,
+		     variant.pointer + variant.length - 1))
 		    goto error;
-		array_from_int64_packed (&packed_ids);
 	    }
-	  if (variant.field_id == 5 && variant.type == READOSM_LEN_BYTES)
+	  if (variant.field_id == 5 && variant.type == READOSM_LEN_BYTES
+	      && !params->skip_metadata
+	      && params->node_columns_callback == NULL)
 	    {
-		/* DenseInfos */
-		if (!parse_pbf_node_infos (&packed_infos,
+		/* DenseInfos (never required by columns) */
+		if (!parse_pbf_node_infos (packed_infos,
 					   variant.pointer,
 					   variant.pointer + variant.length - 1,
 					   variant.little_endian_cpu))
@@ -1424,48 +1686,42 @@ parse_pbf_nodes (readosm_string_table * strings,
 	    {
 		/* latitudes */
 		if (!parse_sint64_packed
-		    (&packed_lats, variant.pointer,
-		     variant.pointer + variant.length - 1,
-		     variant.little_endian_cpu))
+		    (packed_lats, variant.pointer,
+		     variant.pointer + variant.length - 1))
 		    goto error;
-		array_from_int64_packed (&packed_lats);
 	    }
 	  if (variant.field_id == 9 && variant.type == READOSM_LEN_BYTES)
 	    {
 		/* longitudes */
 		if (!parse_sint64_packed
-		    (&packed_lons, variant.pointer,
-		     variant.pointer + variant.length - 1,
-		     variant.little_endian_cpu))
+		    (packed_lons, variant.pointer,
+		     variant.pointer + variant.length - 1))
 		    goto error;
-		array_from_int64_packed (&packed_lons);
 	    }
 	  if (variant.field_id == 10 && variant.type == READOSM_LEN_BYTES)
 	    {
 		/* packes-keys */
 		if (!parse_uint32_packed
-		    (&packed_keys, variant.pointer,
-		     variant.pointer + variant.length - 1,
-		     variant.little_endian_cpu))
+		    (packed_keys, variant.pointer,
+		     variant.pointer + variant.length - 1))
 		    goto error;
-		array_from_uint32_packed (&packed_keys);
 	    }
 	  if (base > stop)
 	      break;
       }
-    if (packed_ids.count == packed_lats.count
-	&& packed_ids.count == packed_lons.count)
+    if (packed_ids->count == packed_lats->count
+	&& packed_ids->count == packed_lons->count)
       {
 	  /* not using PackedInfos */
 	  valid = 1;
       }
-    if (packed_ids.count == packed_lats.count
-	&& packed_ids.count == packed_lons.count
-	&& packed_ids.count == packed_infos.ver_count
-	&& packed_ids.count == packed_infos.tim_count
-	&& packed_ids.count == packed_infos.cng_count
-	&& packed_ids.count == packed_infos.uid_count
-	&& packed_ids.count == packed_infos.usr_count)
+    if (packed_ids->count == packed_lats->count
+	&& packed_ids->count == packed_lons->count
+	&& packed_ids->count == packed_infos->versions.count
+	&& packed_ids->count == packed_infos->timestamps.count
+	&& packed_ids->count == packed_infos->changesets.count
+	&& packed_ids->count == packed_infos->uids.count
+	&& packed_ids->count == packed_infos->users.count)
       {
 	  /* from PackedInfos */
 	  valid = 1;
@@ -1473,14 +1729,28 @@ parse_pbf_nodes (readosm_string_table * strings,
       }
     if (!valid)
 	goto error;
-    else
+    if (params->node_columns_callback != NULL)
+	return parse_pbf_node_columns (strings, params);
+
+/* 
+ / all right, we now have the same item count anywhere
+ / we can now go further away attempting to reassemble
+ / individual Nodes: a Node requires at least two packed-keys
+ / for each Tag, so the shared Tags array can never overflow
+*/
+    items = grow_batch_array (batch->nodes, &(batch->max_nodes), MAX_NODES,
+			      sizeof (readosm_export_node));
+    if (items == NULL)
+	goto error;
+    batch->nodes = items;
+    items = grow_batch_array (batch->tags, &(batch->max_tags),
+			      (packed_keys->count / 2) + 1,
+			      sizeof (readosm_export_tag));
+    if (items == NULL)
+	goto error;
+    batch->tags = items;
       {
-	  /*
-	     / all right, we now have the same item count anywhere
-	     / we can now go further away attempting to reassemble
-	     / individual Nodes 
-	   */
-	  readosm_internal_node *nd;
+	  readosm_export_node *nd;
 	  int i;
 	  int i_keys = 0;
 	  long long delta_id = 0;
@@ -1488,82 +1758,62 @@ parse_pbf_nodes (readosm_string_table * strings,
 	  long long delta_lon = 0;
 	  int max_nodes;
 	  int base = 0;
-	  nd_count = packed_ids.count;
+	  nd_count = packed_ids->count;
 	  while (base < nd_count)
 	    {
 		/* processing about 1024 nodes at each time */
+		readosm_export_tag *p_tag = batch->tags;
 		max_nodes = MAX_NODES;
 		if ((nd_count - base) < MAX_NODES)
 		    max_nodes = nd_count - base;
-		nodes = malloc (sizeof (readosm_internal_node) * max_nodes);
-		for (i = 0; i < max_nodes; i++)
-		  {
-		      /* initializing an array of empty internal Nodes */
-		      nd = nodes + i;
-		      init_internal_node (nd);
-		  }
 		for (i = 0; i < max_nodes; i++)
 		  {
-		      /* reassembling internal Nodes */
-		      const char *key = NULL;
-		      const char *value = NULL;
-		      time_t xtime;
-		      struct tm *times;
+		      /* reassembling compact Nodes */
+		      char *key = NULL;
+		      long long xtime;
 		      int s_id;
-		      nd = nodes + i;
-		      delta_id += *(packed_ids.values + base + i);
-		      delta_lat += *(packed_lats.values + base + i);
-		      delta_lon += *(packed_lons.values + base + i);
+		      nd = batch->nodes + i;
+		      delta_id += packed_ids->values[base + i];
+		      delta_lat += packed_lats->values[base + i];
+		      delta_lon += packed_lons->values[base + i];
 		      nd->id = delta_id;
-		      /* latitudes and longitudes require to be rescaled as DOUBLEs */
-		      nd->latitude = delta_lat / 10000000.0;
-		      nd->longitude = delta_lon / 10000000.0;
+		      pbf_coordinates (params, nd, delta_lat, delta_lon);
+		      nd->version = READOSM_UNDEFINED;
+		      nd->changeset = READOSM_UNDEFINED;
+		      nd->user = NULL;
+		      nd->uid = READOSM_UNDEFINED;
+		      nd->timestamp = NULL;
+		      nd->timestamp_epoch = READOSM_UNDEFINED;
 		      if (fromPackedInfos)
 			{
-			    nd->version = *(packed_infos.versions + base + i);
-			    xtime = *(packed_infos.timestamps + base + i);
-			    times = gmtime (&xtime);
-			    if (times)
-			      {
-				  /* formatting Timestamps */
-				  char buf[64];
-				  int len;
-				  sprintf (buf,
-					   "%04d-%02d-%02dT%02d:%02d:%02dZ",
-					   times->tm_year + 1900,
-					   times->tm_mon + 1, times->tm_mday,
-					   times->tm_hour, times->tm_min,
-					   times->tm_sec);
-				  if (nd->timestamp)
-				      free (nd->timestamp);
-				  len = strlen (buf);
-				  nd->timestamp = malloc (len + 1);
-				  strcpy (nd->timestamp, buf);
-			      }
+			    nd->version = packed_infos->versions.values[base + i];
+			    xtime =
+				pbf_timestamp (params,
+					       packed_infos->timestamps.values
+					       [base + i]);
+			    nd->timestamp_epoch = xtime;
+			    if (!params->lazy_timestamps)
+				format_timestamp (params, &(nd->timestamp), xtime);
 			    nd->changeset =
-				*(packed_infos.changesets + base + i);
-			    if (*(packed_infos.uids + base + i) >= 0)
-				nd->uid = *(packed_infos.uids + base + i);
-			    s_id = *(packed_infos.users + base + i);
+				packed_infos->changesets.values[base + i];
+			    if (packed_infos->uids.values[base + i] >= 0)
+				nd->uid = packed_infos->uids.values[base + i];
+			    s_id = packed_infos->users.values[base + i];
 			    if (s_id > 0)
 			      {
 				  /* retrieving user-names as strings (by index) */
 				  readosm_string *s_ptr =
-				      *(strings->strings + s_id);
-				  int len = strlen (s_ptr->string);
-				  if (nd->user != NULL)
-				      free (nd->user);
-				  if (len > 0)
-				    {
-					nd->user = malloc (len + 1);
-					strcpy (nd->user, s_ptr->string);
-				    }
+				      (strings->strings + s_id);
+				  if (s_ptr->length > 0)
+				      nd->user = s_ptr->string;
 			      }
 			}
-		      for (; i_keys < packed_keys.count; i_keys++)
+		      nd->tag_count = 0;
+		      nd->tags = p_tag;
+		      for (; i_keys < packed_keys->count; i_keys++)
 			{
 			    /* decoding packed-keys */
-			    int is = *(packed_keys.values + i_keys);
+			    int is = packed_keys->values[i_keys];
 			    if (is == 0)
 			      {
 				  /* next Node */
@@ -1571,36 +1821,46 @@ parse_pbf_nodes (readosm_string_table * strings,
 				  break;
 			      }
 			    if (key == NULL)
-			      {
-				  readosm_string *s_ptr =
-				      *(strings->strings + is);
-				  key = s_ptr->string;
-			      }
+				key = strings->strings[is].string;
 			    else
 			      {
-				  readosm_string *s_ptr =
-				      *(strings->strings + is);
-				  value = s_ptr->string;
-				  append_tag_to_node (nd, key, value);
+				  /* appending a Tag to the shared array */
+				  p_tag->key = key;
+				  p_tag->value = strings->strings[is].string;
+				  p_tag++;
+				  nd->tag_count += 1;
 				  key = NULL;
-				  value = NULL;
 			      }
 			}
+		      if (nd->tag_count == 0)
+			  nd->tags = NULL;
 		  }
 		base += max_nodes;
 
-		/* processing each Node in the block */
-		if (params->node_callback != NULL && params->stop == 0)
+		/* processing the whole batch, or each Node in the batch */
+		if (params->node_batch_callback != NULL && params->stop == 0)
+		  {
+		      /* READONLY-NODE simply is the same as export NODE */
+		      const readosm_node *readonly_nodes =
+			  (const readosm_node *) (batch->nodes);
+		      int ret =
+			  (*params->node_batch_callback) (params->user_data,
+							  readonly_nodes,
+							  max_nodes);
+		      if (ret != READOSM_OK)
+			  params->stop = 1;
+		  }
+		else if (params->node_callback != NULL && params->stop == 0)
 		  {
 		      int ret;
-		      readosm_internal_node *nd;
-		      int i;
 		      for (i = 0; i < max_nodes; i++)
 			{
-			    nd = nodes + i;
+			    /* READONLY-NODE simply is the same as export NODE */
+			    const readosm_node *readonly_node =
+				(const readosm_node *) (batch->nodes + i);
 			    ret =
-				call_node_callback (params->node_callback,
-						    params->user_data, nd);
+				(*params->node_callback) (params->user_data,
+							  readonly_node);
 			    if (ret != READOSM_OK)
 			      {
 				  params->stop = 1;
@@ -1608,69 +1868,26 @@ parse_pbf_nodes (readosm_string_table * strings,
 			      }
 			}
 		  }
-
-		/* memory cleanup: destroying Nodes */
-		if (nodes != NULL)
-		  {
-		      readosm_internal_node *nd;
-		      int i;
-		      for (i = 0; i < max_nodes; i++)
-			{
-			    nd = nodes + i;
-			    destroy_internal_node (nd);
-			}
-		      free (nodes);
-		  }
 	    }
       }
 
-/* memory cleanup */
-    finalize_uint32_packed (&packed_keys);
-    finalize_int64_packed (&packed_ids);
-    finalize_int64_packed (&packed_lats);
-    finalize_int64_packed (&packed_lons);
-    finalize_packed_infos (&packed_infos);
-    finalize_variant (&variant);
     return 1;
 
   error:
-    finalize_uint32_packed (&packed_keys);
-    finalize_int64_packed (&packed_ids);
-    finalize_int64_packed (&packed_lats);
-    finalize_int64_packed (&packed_lons);
-    finalize_packed_infos (&packed_infos);
-    finalize_variant (&variant);
-    if (nodes != NULL)
-      {
-	  readosm_internal_node *nd;
-	  int i;
-	  for (i = 0; i < nd_count; i++)
-	    {
-		nd = nodes + i;
-		destroy_internal_node (nd);
-	    }
-	  free (nodes);
-      }
     return 0;
 }
 
 static int
-parse_pbf_way_info (readosm_internal_way * way, readosm_string_table * strings,
+parse_pbf_way_info (readosm_export_way * way, readosm_string_table * strings,
 		    unsigned char *start, unsigned char *stop,
-		    char little_endian_cpu)
+		    char little_endian_cpu, struct pbf_params *params)
 {
 /* attempting to parse a valid PBF Way-Info */
     readosm_variant variant;
     unsigned char *base = start;
 
 /* initializing an empty variant field */
-    init_variant (&variant, little_endian_cpu);
-    add_variant_hints (&variant, READOSM_VAR_INT32, 1);
-    add_variant_hints (&variant, READOSM_VAR_INT32, 2);
-    add_variant_hints (&variant, READOSM_VAR_INT64, 3);
-    add_variant_hints (&variant, READOSM_VAR_INT32, 4);
-    add_variant_hints (&variant, READOSM_VAR_INT32, 5);
-    add_variant_hints (&variant, READOSM_VAR_INT32, 6);
+    init_variant (&variant, little_endian_cpu, &info_fields);
 
 /* reading the WayInfo */
     while (1)
@@ -1687,25 +1904,14 @@ parse_pbf_way_info (readosm_internal_way * way, readosm_string_table * strings,
 		/* version */
 		way->version = variant.value.int32_value;
 	    }
-	  if (variant.field_id == 2 && variant.type == READOSM_VAR_INT32)
+	  if (variant.field_id == 2 && variant.type == READOSM_VAR_INT64)
 	    {
 		/* timestamp */
-		const time_t xtime = variant.value.int32_value;
-		struct tm *times = gmtime (&xtime);
-		if (times)
-		  {
-		      char buf[64];
-		      int len;
-		      sprintf (buf, "%04d-%02d-%02dT%02d:%02d:%02dZ",
-			       times->tm_year + 1900, times->tm_mon + 1,
-			       times->tm_mday, times->tm_hour, times->tm_min,
-			       times->tm_sec);
-		      if (way->timestamp)
-			  free (way->timestamp);
-		      len = strlen (buf);
-		      way->timestamp = malloc (len + 1);
-		      strcpy (way->timestamp, buf);
-		  }
+		const long long xtime =
+		    pbf_timestamp (params, variant.value.int64_value);
+		way->timestamp_epoch = xtime;
+		if (!params->lazy_timestamps)
+		    format_timestamp (params, &(way->timestamp), xtime);
 	    }
 	  if (variant.field_id == 3 && variant.type == READOSM_VAR_INT64)
 	    {
@@ -1721,26 +1927,17 @@ parse_pbf_way_info (readosm_internal_way * way, readosm_string_table * strings,
 	    {
 		/* user-name: index to StringTable entry */
 		int userid;
-		if (way->user)
-		    free (way->user);
 		way->user = NULL;
 		userid = variant.value.int32_value;
 		if (userid > 0 && userid < strings->count)
-		  {
-		      readosm_string *string = *(strings->strings + userid);
-		      int len = strlen (string->string);
-		      way->user = malloc (len + 1);
-		      strcpy (way->user, string->string);
-		  }
+		    way->user = strings->strings[userid].string;
 	    }
 	  if (base > stop)
 	      break;
       }
-    finalize_variant (&variant);
     return 1;
 
   error:
-    finalize_variant (&variant);
     return 0;
 }
 
@@ -1749,26 +1946,49 @@ parse_pbf_way (readosm_string_table * strings,
 	       unsigned char *start, unsigned char *stop,
 	       char little_endian_cpu, struct pbf_params *params)
 {
-/* attempting to parse a valid PBF Way */
+/* 
+ / attempting to parse a valid PBF Way
+ /
+ / the export WAY is directly appended to the batch: Node refs
+ / are delta decoded in place (a single prefix-sum pass) and the
+ / refs packed object itself will then be handed to the callback
+*/
     readosm_variant variant;
     unsigned char *base = start;
-    readosm_uint32_packed packed_keys;
-    readosm_uint32_packed packed_values;
-    readosm_int64_packed packed_refs;
-    readosm_internal_way *way = alloc_internal_way ();
-
-/* initializing empty packed objects */
-    init_uint32_packed (&packed_keys);
-    init_uint32_packed (&packed_values);
-    init_int64_packed (&packed_refs);
+    readosm_uint32_packed *packed_keys = &(params->buffers->keys);
+    readosm_uint32_packed *packed_values = &(params->buffers->values);
+    readosm_int64_packed *packed_refs = &(params->buffers->refs);
+    readosm_export_batch *batch = &(params->buffers->batch);
+    readosm_export_way *way;
+    int first_ref = packed_refs->count;
+    void *items;
+
+/* resetting the (reusable) packed objects */
+    packed_keys->count = 0;
+    packed_values->count = 0;
+
+/* appending an empty export WAY object */
+    items = grow_batch_array (batch->ways, &(batch->max_ways),
+			      batch->way_count + 1,
+			      sizeof (readosm_export_way));
+    if (items == NULL)
+	goto error;
+    batch->ways = items;
+    way = batch->ways + batch->way_count;
+    way->id = 0;
+    way->version = 0;
+    way->changeset = 0;
+    way->user = NULL;
+    way->uid = 0;
+    way->timestamp = NULL;
+    way->timestamp_epoch = READOSM_UNDEFINED;
+    way->node_ref_count = 0;
+    way->node_refs = NULL;
+    way->tag_count = 0;
+    way->tags = NULL;
 
 /* initializing an empty variant field */
-    init_variant (&variant, little_endian_cpu);
-    add_variant_hints (&variant, READOSM_VAR_INT64, 1);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 2);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 3);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 4);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 8);
+    init_variant (&variant, little_endian_cpu, &way_fields);
 
 /* reading the Way */
     while (1)
@@ -1789,113 +2009,88 @@ parse_pbf_way (readosm_string_table * strings,
 	    {
 		/* KEYs are encoded as an array of StringTable index */
 		if (!parse_uint32_packed
-		    (&packed_keys, variant.pointer,
-		     variant.pointer + variant.length - 1,
-		     variant.little_endian_cpu))
+		    (packed_keys, variant.pointer,
+		     variant.pointer + variant.length - 1))
 		    goto error;
-		array_from_uint32_packed (&packed_keys);
 	    }
 	  if (variant.field_id == 3 && variant.type == READOSM_LEN_BYTES)
 	    {
 		/* VALUEs are encoded as an array of StringTable index  */
 		if (!parse_uint32_packed
-		    (&packed_values, variant.pointer,
-		     variant.pointer + variant.length - 1,
-		     variant.little_endian_cpu))
+		    (packed_values, variant.pointer,
+		     variant.pointer + variant.length - 1))
 		    goto error;
-		array_from_uint32_packed (&packed_values);
 	    }
-	  if (variant.field_id == 4 && variant.type == READOSM_LEN_BYTES)
+	  if (variant.field_id == 4 && variant.type == READOSM_LEN_BYTES
+	      && !params->skip_metadata)
 	    {
 		/* WAY-INFO block */
 		if (!parse_pbf_way_info
 		    (way, strings, variant.pointer,
 		     variant.pointer + variant.length - 1,
-		     variant.little_endian_cpu))
+		     variant.little_endian_cpu, params))
 		    goto error;
 	    }
 	  if (variant.field_id == 8 && variant.type == READOSM_LEN_BYTES)
 	    {
-		/* NODE-REFs */
-		long long delta = 0;
-		readosm_int64 *value;
-		/* KEYs are encoded as an array of StringTable index */
+		/* 
+		 / NODE-REFs: encoded as an array of DELTAs
+		 / (the first ref of this Way is an absolute value)
+		 */
+		int from = packed_refs->count;
 		if (!parse_sint64_packed
-		    (&packed_refs, variant.pointer,
-		     variant.pointer + variant.length - 1,
-		     variant.little_endian_cpu))
+		    (packed_refs, variant.pointer,
+		     variant.pointer + variant.length - 1))
 		    goto error;
-		value = packed_refs.first;
-		while (value != NULL)
-		  {
-		      /* appending Node references to Way */
-		      delta += value->value;
-		      append_reference_to_way (way, delta);
-		      value = value->next;
-		  }
+		delta_decode_int64 (packed_refs,
+				    (from == first_ref) ? from + 1 : from);
 	    }
 	  if (base > stop)
 	      break;
       }
 
-/* reassembling a WAY object */
-    if (packed_keys.count == packed_values.count)
+/* appending the WAY-TAGs */
+    if (packed_keys->count != packed_values->count)
+	goto error;
+    if (packed_keys->count > 0)
       {
 	  int i;
-	  for (i = 0; i < packed_keys.count; i++)
+	  items = grow_batch_array (batch->tags, &(batch->max_tags),
+				    batch->tag_count + packed_keys->count,
+				    sizeof (readosm_export_tag));
+	  if (items == NULL)
+	      goto error;
+	  batch->tags = items;
+	  for (i = 0; i < packed_keys->count; i++)
 	    {
-		int i_key = *(packed_keys.values + i);
-		int i_val = *(packed_values.values + i);
-		readosm_string *s_key = *(strings->strings + i_key);
-		readosm_string *s_value = *(strings->strings + i_val);
-		append_tag_to_way (way, s_key->string, s_value->string);
+		readosm_export_tag *p_tag = batch->tags + batch->tag_count + i;
+		p_tag->key = strings->strings[packed_keys->values[i]].string;
+		p_tag->value =
+		    strings->strings[packed_values->values[i]].string;
 	    }
+	  way->tag_count = packed_keys->count;
+	  batch->tag_count += packed_keys->count;
       }
-    else
-	goto error;
-
-    finalize_uint32_packed (&packed_keys);
-    finalize_uint32_packed (&packed_values);
-    finalize_int64_packed (&packed_refs);
-    finalize_variant (&variant);
-
-/* processing the WAY */
-    if (params->way_callback != NULL && params->stop == 0)
-      {
-	  int ret =
-	      call_way_callback (params->way_callback, params->user_data, way);
-	  if (ret != READOSM_OK)
-	      params->stop = 1;
-      }
-    destroy_internal_way (way);
+    way->node_ref_count = packed_refs->count - first_ref;
+    batch->way_count += 1;
     return 1;
 
   error:
-    finalize_uint32_packed (&packed_keys);
-    finalize_uint32_packed (&packed_values);
-    finalize_int64_packed (&packed_refs);
-    finalize_variant (&variant);
-    destroy_internal_way (way);
     return 0;
 }
 
 static int
-parse_pbf_relation_info (readosm_internal_relation * relation,
+parse_pbf_relation_info (readosm_export_relation * relation,
 			 readosm_string_table * strings, unsigned char *start,
-			 unsigned char *stop, char little_endian_cpu)
+			 unsigned char *stop, char little_endian_cpu,
+			 struct pbf_params *params)
 {
 /* attempting to parse a valid PBF RelationInfo */
     readosm_variant variant;
     unsigned char *base = start;
 
 /* initializing an empty variant field */
-    init_variant (&variant, little_endian_cpu);
-    add_variant_hints (&variant, READOSM_VAR_INT32, 1);
-    add_variant_hints (&variant, READOSM_VAR_INT32, 2);
-    add_variant_hints (&variant, READOSM_VAR_INT64, 3);
-    add_variant_hints (&variant, READOSM_VAR_INT32, 4);
-    add_variant_hints (&variant, READOSM_VAR_INT32, 5);
-    add_variant_hints (&variant, READOSM_VAR_INT32, 6);
+    init_variant (&variant, little_endian_cpu, &info_fields);
 
 /* reading the RelationInfo */
     while (1)
@@ -1912,25 +2107,14 @@ parse_pbf_relation_info (readosm_internal_relation * relation,
 		/* version */
 		relation->version = variant.value.int32_value;
 	    }
-	  if (variant.field_id == 2 && variant.type == READOSM_VAR_INT32)
+	  if (variant.field_id == 2 && variant.type == READOSM_VAR_INT64)
 	    {
 		/* timestamp */
-		const time_t xtime = variant.value.int32_value;
-		struct tm *times = gmtime (&xtime);
-		if (times)
-		  {
-		      char buf[64];
-		      int len;
-		      sprintf (buf, "%04d-%02d-%02dT%02d:%02d:%02dZ",
-			       times->tm_year + 1900, times->tm_mon + 1,
-			       times->tm_mday, times->tm_hour, times->tm_min,
-			       times->tm_sec);
-		      if (relation->timestamp)
-			  free (relation->timestamp);
-		      len = strlen (buf);
-		      relation->timestamp = malloc (len + 1);
-		      strcpy (relation->timestamp, buf);
-		  }
+		const long long xtime =
+		    pbf_timestamp (params, variant.value.int64_value);
+		relation->timestamp_epoch = xtime;
+		if (!params->lazy_timestamps)
+		    format_timestamp (params, &(relation->timestamp), xtime);
 	    }
 	  if (variant.field_id == 3 && variant.type == READOSM_VAR_INT64)
 	    {
@@ -1946,26 +2130,17 @@ parse_pbf_relation_info (readosm_internal_relation * relation,
 	    {
 		/* user-name: index to StringTable entry */
 		int userid;
-		if (relation->user)
-		    free (relation->user);
 		relation->user = NULL;
 		userid = variant.value.int32_value;
 		if (userid > 0 && userid < strings->count)
-		  {
-		      readosm_string *string = *(strings->strings + userid);
-		      int len = strlen (string->string);
-		      relation->user = malloc (len + 1);
-		      strcpy (relation->user, string->string);
-		  }
+		    relation->user = strings->strings[userid].string;
 	    }
 	  if (base > stop)
 	      break;
       }
-    finalize_variant (&variant);
     return 1;
 
   error:
-    finalize_variant (&variant);
     return 0;
 }
 
@@ -1974,32 +2149,50 @@ parse_pbf_relation (readosm_string_table * strings,
 		    unsigned char *start, unsigned char *stop,
 		    char little_endian_cpu, struct pbf_params *params)
 {
-/* attempting to parse a valid PBF Relation */
+/* 
+ / attempting to parse a valid PBF Relation
+ / the export RELATION is directly appended to the batch
+*/
     readosm_variant variant;
     unsigned char *base = start;
-    readosm_uint32_packed packed_keys;
-    readosm_uint32_packed packed_values;
-    readosm_uint32_packed packed_roles;
-    readosm_uint32_packed packed_types;
-    readosm_int64_packed packed_refs;
-    readosm_internal_relation *relation = alloc_internal_relation ();
-
-/* initializing empty packed objects */
-    init_uint32_packed (&packed_keys);
-    init_uint32_packed (&packed_values);
-    init_uint32_packed (&packed_roles);
-    init_uint32_packed (&packed_types);
-    init_int64_packed (&packed_refs);
+    readosm_uint32_packed *packed_keys = &(params->buffers->keys);
+    readosm_uint32_packed *packed_values = &(params->buffers->values);
+    readosm_uint32_packed *packed_roles = &(params->buffers->roles);
+    readosm_uint32_packed *packed_types = &(params->buffers->types);
+    readosm_int64_packed *packed_refs = &(params->buffers->refs);
+    readosm_export_batch *batch = &(params->buffers->batch);
+    readosm_export_relation *relation;
+    void *items;
+
+/* resetting the (reusable) packed objects */
+    packed_keys->count = 0;
+    packed_values->count = 0;
+    packed_roles->count = 0;
+    packed_types->count = 0;
+    packed_refs->count = 0;
+
+/* appending an empty export RELATION object */
+    items = grow_batch_array (batch->relations, &(batch->max_relations),
+			      batch->relation_count + 1,
+			      sizeof (readosm_export_relation));
+    if (items == NULL)
+	goto error;
+    batch->relations = items;
+    relation = batch->relations + batch->relation_count;
+    relation->id = 0;
+    relation->version = 0;
+    relation->changeset = 0;
+    relation->user = NULL;
+    relation->uid = 0;
+    relation->timestamp = NULL;
+    relation->timestamp_epoch = READOSM_UNDEFINED;
+    relation->member_count = 0;
+    relation->members = NULL;
+    relation->tag_count = 0;
+    relation->tags = NULL;
 
 /* initializing an empty variant field */
-    init_variant (&variant, little_endian_cpu);
-    add_variant_hints (&variant, READOSM_VAR_INT64, 1);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 2);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 3);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 4);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 8);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 9);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 10);
+    init_variant (&variant, little_endian_cpu, &relation_fields);
 
 /* reading the Relation */
     while (1)
@@ -2020,133 +2213,223 @@ parse_pbf_relation (readosm_string_table * strings,
 	    {
 		/* KEYs are encoded as an array of StringTable index */
 		if (!parse_uint32_packed
-		    (&packed_keys, variant.pointer,
-		     variant.pointer + variant.length - 1,
-		     variant.little_endian_cpu))
+		    (packed_keys, variant.pointer,
+		     variant.pointer + variant.length - 1))
 		    goto error;
-		array_from_uint32_packed (&packed_keys);
 	    }
 	  if (variant.field_id == 3 && variant.type == READOSM_LEN_BYTES)
 	    {
 		/* VALUEs are encoded as an array of StringTable index */
 		if (!parse_uint32_packed
-		    (&packed_values, variant.pointer,
-		     variant.pointer + variant.length - 1,
-		     variant.little_endian_cpu))
+		    (packed_values, variant.pointer,
+		     variant.pointer + variant.length - 1))
 		    goto error;
-		array_from_uint32_packed (&packed_values);
 	    }
-	  if (variant.field_id == 4 && variant.type == READOSM_LEN_BYTES)
+	  if (variant.field_id == 4 && variant.type == READOSM_LEN_BYTES
+	      && !params->skip_metadata)
 	    {
 		/* RELATION-INFO block */
 		if (!parse_pbf_relation_info
 		    (relation, strings, variant.pointer,
 		     variant.pointer + variant.length - 1,
-		     variant.little_endian_cpu))
+		     variant.little_endian_cpu, params))
 		    goto error;
 	    }
 	  if (variant.field_id == 8 && variant.type == READOSM_LEN_BYTES)
 	    {
 		/* MEMBER-ROLEs are encoded as an array of StringTable index */
 		if (!parse_uint32_packed
-		    (&packed_roles, variant.pointer,
-		     variant.pointer + variant.length - 1,
-		     variant.little_endian_cpu))
+		    (packed_roles, variant.pointer,
+		     variant.pointer + variant.length - 1))
 		    goto error;
-		array_from_uint32_packed (&packed_roles);
 	    }
 	  if (variant.field_id == 9 && variant.type == READOSM_LEN_BYTES)
 	    {
 		/* MEMBER-REFs are encoded as an array */
 		if (!parse_sint64_packed
-		    (&packed_refs, variant.pointer,
-		     variant.pointer + variant.length - 1,
-		     variant.little_endian_cpu))
+		    (packed_refs, variant.pointer,
+		     variant.pointer + variant.length - 1))
 		    goto error;
-		array_from_int64_packed (&packed_refs);
 	    }
 	  if (variant.field_id == 10 && variant.type == READOSM_LEN_BYTES)
 	    {
 		/* MEMBER-TYPEs are encoded as an array */
 		if (!parse_uint32_packed
-		    (&packed_types, variant.pointer,
-		     variant.pointer + variant.length - 1,
-		     variant.little_endian_cpu))
+		    (packed_types, variant.pointer,
+		     variant.pointer + variant.length - 1))
 		    goto error;
-		array_from_uint32_packed (&packed_types);
 	    }
 	  if (base > stop)
 	      break;
       }
 
-/* reassembling a RELATION object */
-    if (packed_keys.count == packed_values.count)
+/* appending the RELATION-TAGs */
+    if (packed_keys->count != packed_values->count)
+	goto error;
+    if (packed_keys->count > 0)
       {
 	  int i;
-	  for (i = 0; i < packed_keys.count; i++)
+	  items = grow_batch_array (batch->tags, &(batch->max_tags),
+				    batch->tag_count + packed_keys->count,
+				    sizeof (readosm_export_tag));
+	  if (items == NULL)
+	      goto error;
+	  batch->tags = items;
+	  for (i = 0; i < packed_keys->count; i++)
 	    {
-		int i_key = *(packed_keys.values + i);
-		int i_val = *(packed_values.values + i);
-		readosm_string *s_key = *(strings->strings + i_key);
-		readosm_string *s_value = *(strings->strings + i_val);
-		append_tag_to_relation (relation, s_key->string,
-					s_value->string);
+		readosm_export_tag *p_tag = batch->tags + batch->tag_count + i;
+		p_tag->key = strings->strings[packed_keys->values[i]].string;
+		p_tag->value =
+		    strings->strings[packed_values->values[i]].string;
 	    }
+	  relation->tag_count = packed_keys->count;
+	  batch->tag_count += packed_keys->count;
       }
-    else
+
+/* appending the RELATION-MEMBERs */
+    if (packed_roles->count != packed_refs->count
+	|| packed_roles->count != packed_types->count)
 	goto error;
-    if (packed_roles.count == packed_refs.count
-	&& packed_roles.count == packed_types.count)
+    if (packed_roles->count > 0)
       {
 	  int i;
 	  long long delta = 0;
-	  for (i = 0; i < packed_roles.count; i++)
+	  items = grow_batch_array (batch->members, &(batch->max_members),
+				    batch->member_count + packed_roles->count,
+				    sizeof (readosm_export_member));
+	  if (items == NULL)
+	      goto error;
+	  batch->members = items;
+	  for (i = 0; i < packed_roles->count; i++)
 	    {
-		int xtype = READOSM_UNDEFINED;
-		int i_role = *(packed_roles.values + i);
-		readosm_string *s_role = *(strings->strings + i_role);
-		int type = *(packed_types.values + i);
-		delta += *(packed_refs.values + i);
+		readosm_export_member *p_member =
+		    batch->members + batch->member_count + i;
+		int type = packed_types->values[i];
+		delta += packed_refs->values[i];
+		p_member->member_type = READOSM_UNDEFINED;
 		if (type == 0)
-		    xtype = READOSM_MEMBER_NODE;
+		    p_member->member_type = READOSM_MEMBER_NODE;
 		else if (type == 1)
-		    xtype = READOSM_MEMBER_WAY;
+		    p_member->member_type = READOSM_MEMBER_WAY;
 		else if (type == 2)
-		    xtype = READOSM_MEMBER_RELATION;
-		append_member_to_relation (relation, xtype, delta,
-					   s_role->string);
+		    p_member->member_type = READOSM_MEMBER_RELATION;
+		p_member->id = delta;
+		p_member->role =
+		    strings->strings[packed_roles->values[i]].string;
 	    }
+	  relation->member_count = packed_roles->count;
+	  batch->member_count += packed_roles->count;
       }
-    else
-	goto error;
+    batch->relation_count += 1;
+    return 1;
+
+  error:
+    return 0;
+}
 
-    finalize_uint32_packed (&packed_keys);
-    finalize_uint32_packed (&packed_values);
-    finalize_uint32_packed (&packed_roles);
-    finalize_uint32_packed (&packed_types);
-    finalize_int64_packed (&packed_refs);
-    finalize_variant (&variant);
+static void
+flush_export_batch (struct pbf_params *params)
+{
+/* 
+ / delivering all pending Ways and Relations
+ /
+ / the batch arrays could have been relocated while growing, so
+ / all pointers are only set now: objects are strictly contiguous,
+ / each one simply follows the previous one
+*/
+    int i;
+    int ret;
+    int i_ref = 0;
+    int i_mbr = 0;
+    int i_tag = 0;
+    readosm_export_batch *batch = &(params->buffers->batch);
+    long long *refs = params->buffers->refs.values;
+
+    for (i = 0; i < batch->way_count; i++)
+      {
+	  readosm_export_way *way = batch->ways + i;
+	  if (way->node_ref_count > 0)
+	      way->node_refs = refs + i_ref;
+	  if (way->tag_count > 0)
+	      way->tags = batch->tags + i_tag;
+	  i_ref += way->node_ref_count;
+	  i_tag += way->tag_count;
+      }
+    for (i = 0; i < batch->relation_count; i++)
+      {
+	  readosm_export_relation *relation = batch->relations + i;
+	  if (relation->member_count > 0)
+	      relation->members = batch->members + i_mbr;
+	  if (relation->tag_count > 0)
+	      relation->tags = batch->tags + i_tag;
+	  i_mbr += relation->member_count;
+	  i_tag += relation->tag_count;
+      }
 
-/* processing the RELATION */
-    if (params->relation_callback != NULL && params->stop == 0)
+/* 
+ / please note: READONLY-WAY and READONLY-RELATION simply are
+ / the same as export WAY and RELATION
+*/
+    if (batch->way_count > 0 && params->stop == 0)
       {
-	  int ret = call_relation_callback (params->relation_callback,
-					    params->user_data, relation);
-	  if (ret != READOSM_OK)
-	      params->stop = 1;
+	  const readosm_way *readonly_ways =
+	      (const readosm_way *) (batch->ways);
+	  if (params->way_batch_callback != NULL)
+	    {
+		ret =
+		    (*params->way_batch_callback) (params->user_data,
+						   readonly_ways,
+						   batch->way_count);
+		if (ret != READOSM_OK)
+		    params->stop = 1;
+	    }
+	  else if (params->way_callback != NULL)
+	    {
+		for (i = 0; i < batch->way_count; i++)
+		  {
+		      ret =
+			  (*params->way_callback) (params->user_data,
+						   readonly_ways + i);
+		      if (ret != READOSM_OK)
+			{
+			    params->stop = 1;
+			    break;
+			}
+		  }
+	    }
+      }
+    if (batch->relation_count > 0 && params->stop == 0)
+      {
+	  const readosm_relation *readonly_relations =
+	      (const readosm_relation *) (batch->relations);
+	  if (params->relation_batch_callback != NULL)
+	    {
+		ret =
+		    (*params->relation_batch_callback) (params->user_data,
+							readonly_relations,
+							batch->relation_count);
+		if (ret != READOSM_OK)
+		    params->stop = 1;
+	    }
+	  else if (params->relation_callback != NULL)
+	    {
+		for (i = 0; i < batch->relation_count; i++)
+		  {
+		      ret =
+			  (*params->relation_callback) (params->user_data,
+							readonly_relations +
+							i);
+		      if (ret != READOSM_OK)
+			{
+			    params->stop = 1;
+			    break;
+			}
+		  }
+	    }
       }
-    destroy_internal_relation (relation);
-    return 1;
 
-  error:
-    finalize_uint32_packed (&packed_keys);
-    finalize_uint32_packed (&packed_values);
-    finalize_uint32_packed (&packed_roles);
-    finalize_uint32_packed (&packed_types);
-    finalize_int64_packed (&packed_refs);
-    finalize_variant (&variant);
-    destroy_internal_relation (relation);
-    return 0;
+    reset_export_batch (batch);
+    params->buffers->refs.count = 0;
 }
 
 static int
@@ -2161,17 +2444,17 @@ parse_primitive_group (readosm_string_table * strings,
  / - NODEs
  / - WAYs
  / - RELATIONs
+ /
+ / Ways and Relations are collected into the export batch, which
+ / is flushed after each object when a per-object callback is set,
+ / and just once at the end of the group when a batch callback is
 */
     readosm_variant variant;
     unsigned char *base = start;
+    readosm_export_batch *batch = &(params->buffers->batch);
 
 /* initializing an empty variant field */
-    init_variant (&variant, little_endian_cpu);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 1);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 2);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 3);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 4);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 5);
+    init_variant (&variant, little_endian_cpu, &primitive_group_fields);
 
 /* reading the Primitive Group */
     while (1)
@@ -2183,11 +2466,17 @@ parse_primitive_group (readosm_string_table * strings,
 	  if (base == NULL && variant.valid == 0)
 	      goto error;
 	  start = base;
+	  if (variant.field_id == 1 && variant.type == READOSM_LEN_BYTES)
+	      params->types |= READOSM_BLOCK_NODES;
 	  if (variant.field_id == 2 && variant.type == READOSM_LEN_BYTES)
 	    {
 		/* DenseNodes */
-		if (params->node_callback == NULL)
+		params->types |= READOSM_BLOCK_NODES;
+		if (params->node_callback == NULL
+		    && params->node_batch_callback == NULL
+		    && params->node_columns_callback == NULL)
 		    goto skip;	/* skipping: no node-callback */
+		flush_export_batch (params);
 		if (!parse_pbf_nodes
 		    (strings, variant.pointer,
 		     variant.pointer + variant.length - 1,
@@ -2197,134 +2486,278 @@ parse_primitive_group (readosm_string_table * strings,
 	  if (variant.field_id == 3 && variant.type == READOSM_LEN_BYTES)
 	    {
 		/* Way */
-		if (params->way_callback == NULL)
+		params->types |= READOSM_BLOCK_WAYS;
+		if (params->way_callback == NULL
+		    && params->way_batch_callback == NULL)
 		    goto skip;	/* skipping: no way-callback */
+		if (batch->relation_count > 0)
+		    flush_export_batch (params);
 		if (!parse_pbf_way
 		    (strings, variant.pointer,
 		     variant.pointer + variant.length - 1,
 		     variant.little_endian_cpu, params))
 		    goto error;
+		if (params->way_batch_callback == NULL)
+		    flush_export_batch (params);
 	    }
 	  if (variant.field_id == 4 && variant.type == READOSM_LEN_BYTES)
 	    {
 		/* Relation */
-		if (params->relation_callback == NULL)
+		params->types |= READOSM_BLOCK_RELATIONS;
+		if (params->relation_callback == NULL
+		    && params->relation_batch_callback == NULL)
 		    goto skip;	/* skipping: no relation-callback */
+		if (batch->way_count > 0)
+		    flush_export_batch (params);
 		if (!parse_pbf_relation
 		    (strings, variant.pointer,
 		     variant.pointer + variant.length - 1,
 		     variant.little_endian_cpu, params))
 		    goto error;
+		if (params->relation_batch_callback == NULL)
+		    flush_export_batch (params);
 	    }
 	skip:
 	  if (base > stop)
 	      break;
       }
-    finalize_variant (&variant);
+    flush_export_batch (params);
     return 1;
 
   error:
-    finalize_variant (&variant);
     return 0;
 }
 
-static int
-parse_osm_data (readosm_file * input, unsigned int sz,
-		struct pbf_params *params)
+READOSM_PRIVATE int
+read_osm_header (readosm_file * input)
 {
-/* expecting to retrieve a valid OSMData header */
-    int ok_header = 0;
-    int hdsz = 0;
-    size_t rd;
-    unsigned char *buf = malloc (sz);
-    unsigned char *base = buf;
-    unsigned char *start = buf;
-    unsigned char *stop = buf + sz - 1;
-    unsigned char *zip_ptr = NULL;
-    int zip_sz = 0;
-    unsigned char *raw_ptr = NULL;
-    int raw_sz = 0;
-    readosm_variant variant;
-    readosm_string_table string_table;
-    if (buf == NULL)
-	goto error;
+/* attempting to read (and skip) the leading OSMHeader block */
+    unsigned int hdsz;
+    if (read_header_size (input, &hdsz) != 1)
+	return 0;
+    return skip_osm_header (input, hdsz);
+}
 
-/* initializing an empty string list */
-    init_string_table (&string_table);
+READOSM_PRIVATE void
+release_osm_blob (readosm_pbf_blob * blob)
+{
+/* releasing a raw OSMData Blob */
+    if (blob->buf != NULL)
+	free (blob->buf);
+    blob->buf = NULL;
+    blob->ptr = NULL;
+    blob->size = 0;
+}
 
-/* initializing an empty variant field */
-    init_variant (&variant, input->little_endian_cpu);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 1);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 2);
-    add_variant_hints (&variant, READOSM_VAR_INT32, 3);
+READOSM_PRIVATE int
+read_osm_blob (readosm_file * input, readosm_pbf_blob * blob)
+{
+/* 
+ / attempting to read the next OSMData Blob (still compressed)
+ / returns 1 on success, 0 on a clean EOF and -1 on error
+*/
+    int ret;
+    unsigned int sz;
+    unsigned int hdsz;
 
-    rd = fread (buf, 1, sz, input->in);
-    if (rd != sz)
-	goto error;
+    blob->buf = NULL;
+    blob->ptr = NULL;
+    blob->size = 0;
+
+/* reading BlobHeader size: OSMData */
+    ret = read_header_size (input, &sz);
+    if (ret <= 0)
+	return ret;
 
 /* reading the OSMData header */
-    while (1)
-      {
-	  /* resetting an empty variant field */
-	  reset_variant (&variant);
+    if (read_blob_header (input, sz, "OSMData", &hdsz) != 1)
+	return -1;
 
-	  base = parse_field (start, stop, &variant);
-	  if (base == NULL && variant.valid == 0)
-	      goto error;
-	  start = base;
-	  if (variant.field_id == 1 && variant.type == READOSM_LEN_BYTES
-	      && variant.length == 7)
-	    {
-		if (memcmp (variant.pointer, "OSMData", 7) == 0)
-		    ok_header = 1;
-	    }
-	  if (variant.field_id == 3 && variant.type == READOSM_VAR_INT32)
-	      hdsz = variant.value.int32_value;
-	  if (base > stop)
-	      break;
+/* reading the Blob itself */
+    blob->ptr = read_pbf_block (input, hdsz, &(blob->buf));
+    if (blob->ptr == NULL)
+      {
+	  release_osm_blob (blob);
+	  return -1;
       }
-    free (buf);
-    buf = NULL;
-    if (!ok_header || !hdsz)
-	goto error;
+    blob->size = hdsz;
+    return 1;
+}
 
-    buf = malloc (hdsz);
-    base = buf;
-    start = buf;
-    stop = buf + hdsz - 1;
-    rd = fread (buf, 1, hdsz, input->in);
-    if ((int) rd != hdsz)
-	goto error;
+READOSM_PRIVATE long long
+tell_osm_file (readosm_file * input)
+{
+/* returning the current read position */
+    if (input->map != NULL)
+	return input->map_pos;
+    return readosm_ftell (input->in);
+}
 
-/* uncompressing the OSMData zipped */
-    finalize_variant (&variant);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 1);
-    add_variant_hints (&variant, READOSM_VAR_INT32, 2);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 3);
-    while (1)
+READOSM_PRIVATE int
+seek_osm_file (readosm_file * input, long long offset)
+{
+/* moving the read position to OFFSET */
+    if (input->map != NULL)
       {
-	  /* resetting an empty variant field */
-	  reset_variant (&variant);
+	  if (offset < 0 || (unsigned long long) offset > input->map_size)
+	      return 0;
+	  input->map_pos = offset;
+	  return 1;
+      }
+    if (readosm_fseek (input->in, offset, SEEK_SET) != 0)
+	return 0;
+    return 1;
+}
 
-	  base = parse_field (start, stop, &variant);
-	  if (base == NULL && variant.valid == 0)
-	      goto error;
-	  start = base;
-	  if (variant.field_id == 1 && variant.type == READOSM_LEN_BYTES)
-	    {
-		/* found an uncompressed block */
+READOSM_PRIVATE int
+build_block_index (readosm_file * input)
+{
+/* 
+ / building the index of all OSMData blocks
+ /
+ / only the BlobHeaders are actually read: any Blob is simply
+ / skipped (no decompression at all), so to be really fast
+ / the current read position will be restored on completion
+*/
+    int ret = READOSM_OK;
+    int max = 0;
+    unsigned int sz;
+    unsigned int hdsz;
+    long long offset;
+    long long file_size;
+    long long current = tell_osm_file (input);
+    readosm_export_block *blocks = NULL;
+    readosm_export_block *blk;
+
+    if (input->blocks != NULL)
+	return READOSM_OK;	/* already built */
+    if (current < 0)
+	return READOSM_READ_ERROR;
+
+/* retrieving the file size */
+    if (input->map != NULL)
+	file_size = input->map_size;
+    else
+      {
+	  if (readosm_fseek (input->in, 0, SEEK_END) != 0)
+	      return READOSM_READ_ERROR;
+	  file_size = readosm_ftell (input->in);
+      }
+    if (!seek_osm_file (input, 0))
+	return READOSM_READ_ERROR;
+
+    input->block_count = 0;
+    while (1)
+      {
+	  offset = tell_osm_file (input);
+	  ret = read_header_size (input, &sz);
+	  if (ret == 0)
+	    {
+		ret = READOSM_OK;
+		break;		/* EOF */
+	    }
+	  if (ret < 0)
+	      goto error;
+	  ret = read_blob_header (input, sz, "OSMData", &hdsz);
+	  if (ret < 0)
+	      goto error;
+	  if (offset + 4 + sz + hdsz > file_size)
+	      goto error;	/* truncated Blob */
+	  if (!skip_pbf_block (input, hdsz))
+	      goto error;
+	  if (ret == 0)
+	      continue;		/* not an OSMData block */
+	  if (input->block_count == max)
+	    {
+		max = (max == 0) ? 1024 : max * 2;
+		blk = realloc (blocks, sizeof (readosm_export_block) * max);
+		if (blk == NULL)
+		  {
+		      ret = READOSM_INSUFFICIENT_MEMORY;
+		      goto stop;
+		  }
+		blocks = blk;
+	    }
+	  blk = blocks + input->block_count;
+	  blk->file_offset = offset;
+	  blk->header_size = sz;
+	  blk->datasize = hdsz;
+	  blk->object_types = 0;
+	  blk->min_id = 0;
+	  blk->max_id = 0;
+	  input->block_count += 1;
+      }
+    input->blocks = blocks;
+    seek_osm_file (input, current);
+    return READOSM_OK;
+
+  error:
+    ret = READOSM_INVALID_PBF_HEADER;
+  stop:
+    if (blocks != NULL)
+	free (blocks);
+    input->block_count = 0;
+    seek_osm_file (input, current);
+    return ret;
+}
+
+static int
+decode_osm_blob (readosm_pbf_decoder * decoder, readosm_pbf_blob * blob,
+		 char little_endian_cpu, unsigned char **raw,
+		 unsigned int *raw_size)
+{
+/* 
+ / attempting to decode a Blob (decompressing it if required)
+ / on success *raw will point to the uncompressed block, 
+ / i.e. either to the decoder buffer, or directly to the Blob
+ / itself for uncompressed blocks
+*/
+    unsigned char *base;
+    unsigned char *start = blob->ptr;
+    unsigned char *stop = blob->ptr + blob->size - 1;
+    unsigned char *zip_ptr = NULL;
+    int zip_sz = 0;
+    int compression = 0;
+    unsigned char *raw_ptr = NULL;
+    int raw_sz = 0;
+    int ret = READOSM_INVALID_PBF_HEADER;
+    readosm_variant variant;
+
+    *raw = NULL;
+    *raw_size = 0;
+
+/* uncompressing the Blob */
+    init_variant (&variant, little_endian_cpu, &blob_fields);
+    while (1)
+      {
+	  /* resetting an empty variant field */
+	  reset_variant (&variant);
+
+	  base = parse_field (start, stop, &variant);
+	  if (base == NULL && variant.valid == 0)
+	      goto error;
+	  start = base;
+	  if (variant.field_id == 1 && variant.type == READOSM_LEN_BYTES)
+	    {
+		/* 
+		 / found an uncompressed block: no copy is required,
+		 / the Blob buffer (or the mapped pages) will be
+		 / directly parsed
+		 */
 		raw_sz = variant.length;
-		raw_ptr = malloc (raw_sz);
-		memcpy (raw_ptr, variant.pointer, raw_sz);
+		raw_ptr = variant.pointer;
 	    }
 	  if (variant.field_id == 2 && variant.type == READOSM_VAR_INT32)
 	    {
 		/* expected size of unZipped block */
 		raw_sz = variant.value.int32_value;
 	    }
-	  if (variant.field_id == 3 && variant.type == READOSM_LEN_BYTES)
+	  if (variant.field_id >= READOSM_BLOB_ZLIB
+	      && variant.field_id <= READOSM_BLOB_ZSTD
+	      && variant.type == READOSM_LEN_BYTES)
 	    {
-		/* found a ZIP-compressed block */
+		/* found a compressed block [ZLIB, LZMA, BZIP2, LZ4 or ZSTD] */
+		compression = variant.field_id;
 		zip_ptr = variant.pointer;
 		zip_sz = variant.length;
 	    }
@@ -2333,27 +2766,79 @@ parse_osm_data (readosm_file * input, unsigned int sz,
       }
     if (zip_ptr != NULL && zip_sz != 0 && raw_sz != 0)
       {
-	  /* unZipping a compressed block */
-	  raw_ptr = malloc (raw_sz);
-	  if (!unzip_compressed_block (zip_ptr, zip_sz, raw_ptr, raw_sz))
+	  /* decompressing a compressed block (into the reusable buffer) */
+	  if (raw_sz < 0)
 	      goto error;
+	  raw_ptr = get_inflate_buffer (decoder, raw_sz);
+	  if (raw_ptr == NULL)
+	    {
+		ret = READOSM_INSUFFICIENT_MEMORY;
+		goto error;
+	    }
+	  ret =
+	      decompress_block (decoder, compression, zip_ptr, zip_sz,
+				raw_ptr, raw_sz);
+	  if (ret != READOSM_OK)
+	      goto error;
+	  ret = READOSM_INVALID_PBF_HEADER;
       }
-    free (buf);
-    buf = NULL;
-    if (raw_ptr == NULL || raw_sz == 0)
+    if (raw_ptr == NULL || raw_sz <= 0)
 	goto error;
 
-/* parsing the PrimitiveBlock */
-    base = raw_ptr;
+    *raw = raw_ptr;
+    *raw_size = raw_sz;
+    return READOSM_OK;
+
+  error:
+    return ret;
+}
+
+READOSM_PRIVATE int
+parse_osm_blob (readosm_pbf_decoder * decoder, readosm_pbf_blob * blob,
+		char little_endian_cpu, struct pbf_params *params)
+{
+/* attempting to decode an OSMData Blob and to parse its PrimitiveBlock */
+    unsigned char *base;
+    unsigned char *start;
+    unsigned char *stop;
+    unsigned char *raw_ptr;
+    unsigned int raw_sz;
+    int ret;
+    int in_place;
+    readosm_variant variant;
+    readosm_string_table *string_table = &(decoder->buffers.strings);
+
+    params->types = 0;
+    params->buffers = &(decoder->buffers);
+    ret = decode_osm_blob (decoder, blob, little_endian_cpu, &raw_ptr,
+			   &raw_sz);
+    if (ret != READOSM_OK)
+	return ret;
+    ret = READOSM_INVALID_PBF_HEADER;
+
+/*
+ / strings can be NULL terminated in place only within the
+ / (private) inflate buffer; uncompressed blocks may well be
+ / memory-mapped read-only
+*/
+    in_place = (raw_ptr == decoder->raw_buf);
+
+/* resetting the (reusable) StringTable, batch and block defaults */
+    reset_string_table (string_table);
+    reset_export_batch (&(decoder->buffers.batch));
+    decoder->buffers.refs.count = 0;
+    params->granularity = 100;
+    params->lat_offset = 0;
+    params->lon_offset = 0;
+    params->date_granularity = 1000;
+    init_variant (&variant, little_endian_cpu, &primitive_block_fields);
+
+/* 
+ / parsing the PrimitiveBlock: a first pass is required, because
+ / granularity and offsets are usually encoded after the groups
+*/
     start = raw_ptr;
     stop = raw_ptr + raw_sz - 1;
-    finalize_variant (&variant);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 1);
-    add_variant_hints (&variant, READOSM_LEN_BYTES, 2);
-    add_variant_hints (&variant, READOSM_VAR_INT32, 17);
-    add_variant_hints (&variant, READOSM_VAR_INT32, 18);
-    add_variant_hints (&variant, READOSM_VAR_INT64, 19);
-    add_variant_hints (&variant, READOSM_VAR_INT64, 20);
     while (1)
       {
 	  /* resetting an empty variant field */
@@ -2367,95 +2852,661 @@ parse_osm_data (readosm_file * input, unsigned int sz,
 	    {
 		/* the StringTable */
 		if (!parse_string_table
-		    (&string_table, variant.pointer,
+		    (string_table, variant.pointer,
 		     variant.pointer + variant.length - 1,
-		     variant.little_endian_cpu))
+		     variant.little_endian_cpu, in_place))
 		    goto error;
-		array_from_string_table (&string_table);
 	    }
+	  if (variant.field_id == 17 && variant.type == READOSM_VAR_INT32)
+	      params->granularity = variant.value.int32_value;
+	  if (variant.field_id == 18 && variant.type == READOSM_VAR_INT32)
+	      params->date_granularity = variant.value.int32_value;
+	  if (variant.field_id == 19 && variant.type == READOSM_VAR_INT64)
+	      params->lat_offset = variant.value.int64_value;
+	  if (variant.field_id == 20 && variant.type == READOSM_VAR_INT64)
+	      params->lon_offset = variant.value.int64_value;
+	  if (base > stop)
+	      break;
+      }
+    if (params->granularity <= 0 || params->date_granularity <= 0)
+	goto error;
+
+/* second pass: parsing the PrimitiveGroups */
+    start = raw_ptr;
+    while (1)
+      {
+	  /* resetting an empty variant field */
+	  reset_variant (&variant);
+
+	  base = parse_field (start, stop, &variant);
+	  if (base == NULL && variant.valid == 0)
+	      goto error;
+	  start = base;
 	  if (variant.field_id == 2 && variant.type == READOSM_LEN_BYTES)
 	    {
 		/* the PrimitiveGroup to be parsed */
 		if (!parse_primitive_group
-		    (&string_table, variant.pointer,
+		    (string_table, variant.pointer,
 		     variant.pointer + variant.length - 1,
 		     variant.little_endian_cpu, params))
 		    goto error;
 	    }
-	  if (variant.field_id == 17 && variant.type == READOSM_VAR_INT32)
+	  if (base > stop)
+	      break;
+      }
+
+/* all callbacks have returned: releasing the block Arena at once */
+    reset_arena (&(decoder->buffers.arena));
+    return READOSM_OK;
+
+  error:
+    reset_arena (&(decoder->buffers.arena));
+    return ret;
+}
+
+static char *
+dup_pbf_string (readosm_variant * variant)
+{
+/* copying a PBF string into a NULL terminated string */
+    char *str = malloc (variant->length + 1);
+    if (str == NULL)
+	return NULL;
+    memcpy (str, variant->pointer, variant->length);
+    *(str + variant->length) = '\0';
+    return str;
+}
+
+static int
+append_header_feature (char ***features, int *count,
+		       readosm_variant * variant)
+{
+/* appending a further feature to a HeaderBlock features list */
+    char *str;
+    char **list = realloc (*features, sizeof (char *) * (*count + 1));
+    if (list == NULL)
+	return 0;
+    *features = list;
+    str = dup_pbf_string (variant);
+    if (str == NULL)
+	return 0;
+    *(list + *count) = str;
+    *count += 1;
+    return 1;
+}
+
+static int
+parse_header_bbox (readosm_export_header * header, unsigned char *start,
+		   unsigned char *stop, char little_endian_cpu)
+{
+/* 
+ / parsing the HeaderBBox
+ / coordinates are expressed in nanodegrees
+*/
+    unsigned char *base;
+    readosm_variant variant;
+
+/* initializing an empty variant field */
+    init_variant (&variant, little_endian_cpu, &header_bbox_fields);
+
+    while (1)
+      {
+	  /* resetting an empty variant field */
+	  reset_variant (&variant);
+
+	  base = parse_field (start, stop, &variant);
+	  if (base == NULL && variant.valid == 0)
+	      goto error;
+	  start = base;
+	  if (variant.type == READOSM_VAR_SINT64)
 	    {
-		/* assumed to be a termination marker (???) */
-		break;
+		double coord = (double) (variant.value.int64_value) / 1e9;
+		switch (variant.field_id)
+		  {
+		  case 1:
+		      header->min_longitude = coord;
+		      break;
+		  case 2:
+		      header->max_longitude = coord;
+		      break;
+		  case 3:
+		      header->max_latitude = coord;
+		      break;
+		  case 4:
+		      header->min_latitude = coord;
+		      break;
+		  };
 	    }
 	  if (base > stop)
 	      break;
       }
+    header->has_bbox = 1;
+    return 1;
 
-    if (buf != NULL)
-	free (buf);
-    if (raw_ptr != NULL)
-	free (raw_ptr);
-    finalize_variant (&variant);
-    finalize_string_table (&string_table);
+  error:
+    return 0;
+}
+
+static int
+parse_header_block (readosm_export_header * header, unsigned char *start,
+		    unsigned char *stop, char little_endian_cpu)
+{
+/* parsing the HeaderBlock */
+    int i;
+    unsigned char *base;
+    readosm_variant variant;
+
+/* initializing an empty variant field */
+    init_variant (&variant, little_endian_cpu, &header_block_fields);
+
+    while (1)
+      {
+	  /* resetting an empty variant field */
+	  reset_variant (&variant);
+
+	  base = parse_field (start, stop, &variant);
+	  if (base == NULL && variant.valid == 0)
+	      goto error;
+	  start = base;
+	  if (variant.field_id == 1 && variant.type == READOSM_LEN_BYTES
+	      && variant.length > 0)
+	    {
+		/* the HeaderBBox */
+		if (!parse_header_bbox
+		    (header, variant.pointer,
+		     variant.pointer + variant.length - 1,
+		     variant.little_endian_cpu))
+		    goto error;
+	    }
+	  if (variant.field_id == 4 && variant.type == READOSM_LEN_BYTES)
+	    {
+		/* a required feature */
+		if (!append_header_feature
+		    (&(header->required_features),
+		     &(header->required_feature_count), &variant))
+		    goto error;
+	    }
+	  if (variant.field_id == 5 && variant.type == READOSM_LEN_BYTES)
+	    {
+		/* an optional feature */
+		if (!append_header_feature
+		    (&(header->optional_features),
+		     &(header->optional_feature_count), &variant))
+		    goto error;
+	    }
+	  if (variant.field_id == 16 && variant.type == READOSM_LEN_BYTES
+	      && header->writing_program == NULL)
+	    {
+		header->writing_program = dup_pbf_string (&variant);
+		if (header->writing_program == NULL)
+		    goto error;
+	    }
+	  if (variant.field_id == 17 && variant.type == READOSM_LEN_BYTES
+	      && header->source == NULL)
+	    {
+		header->source = dup_pbf_string (&variant);
+		if (header->source == NULL)
+		    goto error;
+	    }
+	  if (variant.field_id == 32 && variant.type == READOSM_VAR_INT64)
+	      header->replication_timestamp = variant.value.int64_value;
+	  if (variant.field_id == 33 && variant.type == READOSM_VAR_INT64)
+	      header->replication_sequence = variant.value.int64_value;
+	  if (variant.field_id == 34 && variant.type == READOSM_LEN_BYTES
+	      && header->replication_base_url == NULL)
+	    {
+		header->replication_base_url = dup_pbf_string (&variant);
+		if (header->replication_base_url == NULL)
+		    goto error;
+	    }
+	  if (base > stop)
+	      break;
+      }
+
+/* checking for well known features */
+    for (i = 0; i < header->required_feature_count; i++)
+      {
+	  const char *feature = *(header->required_features + i);
+	  if (strcmp (feature, "LocationsOnWays") == 0)
+	      header->locations_on_ways = 1;
+      }
+    for (i = 0; i < header->optional_feature_count; i++)
+      {
+	  const char *feature = *(header->optional_features + i);
+	  if (strcmp (feature, "Sort.Type_then_ID") == 0)
+	      header->sorted = 1;
+	  if (strcmp (feature, "LocationsOnWays") == 0)
+	      header->locations_on_ways = 1;
+      }
     return 1;
 
   error:
-    if (buf != NULL)
-	free (buf);
-    if (raw_ptr != NULL)
-	free (raw_ptr);
-    finalize_variant (&variant);
-    finalize_string_table (&string_table);
     return 0;
 }
 
+READOSM_PRIVATE void
+destroy_osm_header (readosm_export_header * header)
+{
+/* destroying the PBF HeaderBlock */
+    int i;
+    if (header == NULL)
+	return;
+    for (i = 0; i < header->required_feature_count; i++)
+	free (*(header->required_features + i));
+    if (header->required_features != NULL)
+	free (header->required_features);
+    for (i = 0; i < header->optional_feature_count; i++)
+	free (*(header->optional_features + i));
+    if (header->optional_features != NULL)
+	free (header->optional_features);
+    if (header->writing_program != NULL)
+	free (header->writing_program);
+    if (header->source != NULL)
+	free (header->source);
+    if (header->replication_base_url != NULL)
+	free (header->replication_base_url);
+    free (header);
+}
+
 READOSM_PRIVATE int
-parse_osm_pbf (readosm_file * input, const void *user_data,
-	       readosm_node_callback node_fnct, readosm_way_callback way_fnct,
-	       readosm_relation_callback relation_fnct)
+load_osm_header (readosm_file * input)
 {
-/* parsing the input file [OSM PBF format] */
-    size_t rd;
-    unsigned char buf[8];
+/* 
+ / attempting to parse the leading OSMHeader block
+ / the read position will be restored on completion
+*/
+    int ret = READOSM_INVALID_PBF_HEADER;
+    unsigned int sz;
     unsigned int hdsz;
+    unsigned char *raw_ptr;
+    unsigned int raw_sz;
+    long long current = tell_osm_file (input);
+    readosm_pbf_blob blob;
+    readosm_pbf_decoder *decoder = get_pbf_decoder (input);
+    readosm_export_header *header;
+
+    if (decoder == NULL)
+	return READOSM_INSUFFICIENT_MEMORY;
+    header = malloc (sizeof (readosm_export_header));
+    if (header == NULL)
+	return READOSM_INSUFFICIENT_MEMORY;
+    header->has_bbox = 0;
+    header->min_longitude = 0.0;
+    header->max_longitude = 0.0;
+    header->min_latitude = 0.0;
+    header->max_latitude = 0.0;
+    header->required_feature_count = 0;
+    header->required_features = NULL;
+    header->optional_feature_count = 0;
+    header->optional_features = NULL;
+    header->writing_program = NULL;
+    header->source = NULL;
+    header->replication_timestamp = READOSM_UNDEFINED;
+    header->replication_sequence = READOSM_UNDEFINED;
+    header->replication_base_url = NULL;
+    header->sorted = 0;
+    header->locations_on_ways = 0;
+    blob.buf = NULL;
+
+    if (!seek_osm_file (input, 0))
+	goto error;
+    if (read_header_size (input, &sz) != 1)
+	goto error;
+    if (read_blob_header (input, sz, "OSMHeader", &hdsz) != 1)
+	goto error;
+    blob.ptr = read_pbf_block (input, hdsz, &(blob.buf));
+    if (blob.ptr == NULL)
+	goto error;
+    blob.size = hdsz;
+    ret =
+	decode_osm_blob (decoder, &blob, input->little_endian_cpu, &raw_ptr,
+			 &raw_sz);
+    if (ret != READOSM_OK)
+	goto error;
+    if (!parse_header_block
+	(header, raw_ptr, raw_ptr + raw_sz - 1, input->little_endian_cpu))
+      {
+	  ret = READOSM_INVALID_PBF_HEADER;
+	  goto error;
+      }
+    release_osm_blob (&blob);
+    seek_osm_file (input, current);
+    if (input->header != NULL)
+	destroy_osm_header (input->header);
+    input->header = header;
+    return READOSM_OK;
+
+  error:
+    release_osm_blob (&blob);
+    destroy_osm_header (header);
+    seek_osm_file (input, current);
+    return ret;
+}
+
+static int
+wanted_block_types (struct pbf_params *params)
+{
+/* returning the bitmask of object types having a callback */
+    int types = 0;
+    if (params->node_callback != NULL || params->node_batch_callback != NULL
+	|| params->node_columns_callback != NULL)
+	types |= READOSM_BLOCK_NODES;
+    if (params->way_callback != NULL || params->way_batch_callback != NULL)
+	types |= READOSM_BLOCK_WAYS;
+    if (params->relation_callback != NULL
+	|| params->relation_batch_callback != NULL)
+	types |= READOSM_BLOCK_RELATIONS;
+    return types;
+}
+
+static int
+lowest_block_type (int types)
+{
+/* returning the lowest READOSM_BLOCK_xx bit set (0 if none) */
+    return types & -types;
+}
+
+static int
+highest_block_type (int types)
+{
+/* returning the highest READOSM_BLOCK_xx bit set (0 if none) */
+    int type = 0;
+    while (types)
+      {
+	  type = lowest_block_type (types);
+	  types &= ~type;
+      }
+    return type;
+}
+
+static int
+probe_block_types (readosm_file * input, readosm_pbf_decoder * decoder,
+		   int block, int *types)
+{
+/* 
+ / identifying the object types stored into a block;
+ / the detailed index (if available) already knows them,
+ / otherwise the block has to be decoded (but not parsed)
+*/
+    int ret;
+    readosm_pbf_blob blob;
     struct pbf_params params;
+    readosm_export_block *blk = input->blocks + block;
 
-/* initializing the PBF helper structure */
-    params.user_data = user_data;
-    params.node_callback = node_fnct;
-    params.way_callback = way_fnct;
-    params.relation_callback = relation_fnct;
+    if (input->detailed_index)
+      {
+	  *types = blk->object_types;
+	  return READOSM_OK;
+      }
+    if (!seek_osm_file (input, blk->file_offset))
+	return READOSM_READ_ERROR;
+    ret = read_osm_blob (input, &blob);
+    if (ret <= 0)
+	return READOSM_INVALID_PBF_HEADER;
+    params.user_data = NULL;
+    params.node_callback = NULL;
+    params.way_callback = NULL;
+    params.relation_callback = NULL;
+    params.node_batch_callback = NULL;
+    params.way_batch_callback = NULL;
+    params.relation_batch_callback = NULL;
+    params.node_columns_callback = NULL;
     params.stop = 0;
+    params.skip_metadata = 1;
+    params.lazy_timestamps = 1;
+    ret = parse_osm_blob (decoder, &blob, input->little_endian_cpu, &params);
+    release_osm_blob (&blob);
+    *types = params.types;
+    return ret;
+}
 
-/* reading BlobHeader size: OSMHeader */
-    rd = fread (buf, 1, 4, input->in);
-    if (rd != 4)
-	return READOSM_INVALID_PBF_HEADER;
-    hdsz = get_header_size (buf, input->little_endian_cpu);
+static int
+seek_first_wanted_block (readosm_file * input,
+			 readosm_pbf_decoder * decoder, int wanted)
+{
+/* 
+ / positioning a Type_then_ID sorted file on the first block
+ / possibly containing some wanted object
+ /
+ / all blocks preceding it contain only unwanted object types
+ / (e.g. NODEs when just WAYs are requested), so a binary search
+ / over the block index allows to skip them by simply seeking
+ / past their BlobHeaders, decoding at most log2(N) blocks
+*/
+    int ret;
+    int types;
+    int low = 0;
+    int high;
+    int first = lowest_block_type (wanted);
+    long long current = tell_osm_file (input);
+
+    ret = build_block_index (input);
+    if (ret != READOSM_OK)
+	return ret;
+    high = input->block_count;
+    while (low < high)
+      {
+	  int mid = low + (high - low) / 2;
+	  ret = probe_block_types (input, decoder, mid, &types);
+	  if (ret != READOSM_OK)
+	      return ret;
+	  if (types == 0 || highest_block_type (types) >= first)
+	      high = mid;
+	  else
+	      low = mid + 1;
+      }
+    if (low < input->block_count)
+	current = input->blocks[low].file_offset;
+    else if (input->block_count > 0)
+      {
+	  /* no wanted object at all: positioning at the end of the file */
+	  readosm_export_block *blk = input->blocks + (input->block_count - 1);
+	  current =
+	      blk->file_offset + 4 + blk->header_size + blk->datasize;
+      }
+    if (!seek_osm_file (input, current))
+	return READOSM_READ_ERROR;
+    return READOSM_OK;
+}
+
+static int
+parse_pbf_blocks (readosm_file * input, struct pbf_params *params)
+{
+/* parsing all OSMData blocks of the input file [OSM PBF format] */
+    int ret;
+    int sorted = 0;
+    int wanted;
+    readosm_pbf_blob blob;
+    readosm_pbf_decoder *decoder = get_pbf_decoder (input);
+
+    if (decoder == NULL)
+	return READOSM_INSUFFICIENT_MEMORY;
+    params->stop = 0;
+    params->skip_metadata =
+	(input->options & READOSM_SKIP_METADATA) ? 1 : 0;
+    params->lazy_timestamps =
+	(input->options & READOSM_LAZY_TIMESTAMPS) ? 1 : 0;
+    wanted = wanted_block_types (params);
 
 /* testing OSMHeader */
-    if (!skip_osm_header (input, hdsz))
+    if (!read_osm_header (input))
 	return READOSM_INVALID_PBF_HEADER;
 
+    if (input->header != NULL && input->header->sorted)
+      {
+	  /* 
+	   / Type_then_ID sorted file: all NODEs come first, then all
+	   / WAYs and finally all RELATIONs; unwanted leading blocks
+	   / can be skipped, and parsing can stop as soon as some
+	   / block past the last wanted object type is found
+	   */
+	  sorted = 1;
+	  if (wanted != 0 && !(wanted & READOSM_BLOCK_NODES))
+	    {
+		ret = seek_first_wanted_block (input, decoder, wanted);
+		if (ret != READOSM_OK)
+		    return ret;
+	    }
+      }
+
 /* 
  / the PBF file is internally organized as a collection
  / of many subsequent OSMData blocks 
 */
     while (1)
       {
-	  /* reading BlobHeader size: OSMData */
-	  if (params.stop)
+	  /* reading the next OSMData Blob */
+	  if (params->stop)
 	      return READOSM_ABORT;
-	  rd = fread (buf, 1, 4, input->in);
-	  if (rd == 0 && feof (input->in))
+	  ret = read_osm_blob (input, &blob);
+	  if (ret == 0)
 	      break;
-	  if (rd != 4)
+	  if (ret < 0)
 	      return READOSM_INVALID_PBF_HEADER;
-	  hdsz = get_header_size (buf, input->little_endian_cpu);
 
 	  /* parsing OSMData */
-	  if (!parse_osm_data (input, hdsz, &params))
+	  ret =
+	      parse_osm_blob (decoder, &blob, input->little_endian_cpu,
+			      params);
+	  release_osm_blob (&blob);
+	  if (ret != READOSM_OK)
+	      return ret;
+	  if (sorted && !params->stop && params->types != 0
+	      && lowest_block_type (params->types) >
+	      highest_block_type (wanted))
+	      break;		/* all wanted objects have already been parsed */
+      }
+    return READOSM_OK;
+}
+
+READOSM_PRIVATE int
+parse_osm_pbf (readosm_file * input, const void *user_data,
+	       readosm_node_callback node_fnct, readosm_way_callback way_fnct,
+	       readosm_relation_callback relation_fnct)
+{
+/* parsing the input file [OSM PBF format] */
+    struct pbf_params params;
+
+/* initializing the PBF helper structure */
+    params.user_data = user_data;
+    params.node_callback = node_fnct;
+    params.way_callback = way_fnct;
+    params.relation_callback = relation_fnct;
+    params.node_batch_callback = NULL;
+    params.way_batch_callback = NULL;
+    params.relation_batch_callback = NULL;
+    params.node_columns_callback = NULL;
+    return parse_pbf_blocks (input, &params);
+}
+
+READOSM_PRIVATE int
+parse_osm_pbf_batches (readosm_file * input, const void *user_data,
+		       readosm_node_batch_callback node_fnct,
+		       readosm_way_batch_callback way_fnct,
+		       readosm_relation_batch_callback relation_fnct)
+{
+/* parsing the input file [OSM PBF format] - arrays of objects */
+    struct pbf_params params;
+
+/* initializing the PBF helper structure */
+    params.user_data = user_data;
+    params.node_callback = NULL;
+    params.way_callback = NULL;
+    params.relation_callback = NULL;
+    params.node_batch_callback = node_fnct;
+    params.way_batch_callback = way_fnct;
+    params.relation_batch_callback = relation_fnct;
+    params.node_columns_callback = NULL;
+    return parse_pbf_blocks (input, &params);
+}
+
+READOSM_PRIVATE int
+parse_osm_pbf_columns (readosm_file * input, const void *user_data,
+		       readosm_node_columns_callback node_fnct,
+		       readosm_way_batch_callback way_fnct,
+		       readosm_relation_batch_callback relation_fnct)
+{
+/* parsing the input file [OSM PBF format] - columns of Nodes */
+    struct pbf_params params;
+
+/* initializing the PBF helper structure */
+    params.user_data = user_data;
+    params.node_callback = NULL;
+    params.way_callback = NULL;
+    params.relation_callback = NULL;
+    params.node_batch_callback = NULL;
+    params.way_batch_callback = way_fnct;
+    params.relation_batch_callback = relation_fnct;
+    params.node_columns_callback = node_fnct;
+    return parse_pbf_blocks (input, &params);
+}
+
+READOSM_PRIVATE int
+parse_osm_pbf_range (readosm_file * input, long long start_offset,
+		     long long end_offset, const void *user_data,
+		     readosm_node_callback node_fnct,
+		     readosm_way_callback way_fnct,
+		     readosm_relation_callback relation_fnct)
+{
+/* 
+ / parsing a byte range of the input file [OSM PBF format]
+ /
+ / any OSMData block starting at or after START_OFFSET and
+ / before END_OFFSET will be parsed (a negative END_OFFSET
+ / stands for the end of the file); so adjacent ranges will
+ / never share the same block, and will never miss a block
+*/
+    int i;
+    int ret;
+    readosm_pbf_blob blob;
+    struct pbf_params params;
+    readosm_pbf_decoder *decoder = get_pbf_decoder (input);
+
+    if (decoder == NULL)
+	return READOSM_INSUFFICIENT_MEMORY;
+
+/* initializing the PBF helper structure */
+    params.user_data = user_data;
+    params.node_callback = node_fnct;
+    params.way_callback = way_fnct;
+    params.relation_callback = relation_fnct;
+    params.node_batch_callback = NULL;
+    params.way_batch_callback = NULL;
+    params.relation_batch_callback = NULL;
+    params.node_columns_callback = NULL;
+    params.stop = 0;
+    params.skip_metadata = (input->options & READOSM_SKIP_METADATA) ? 1 : 0;
+    params.lazy_timestamps =
+	(input->options & READOSM_LAZY_TIMESTAMPS) ? 1 : 0;
+
+/* locating the block boundaries */
+    ret = build_block_index (input);
+    if (ret != READOSM_OK)
+	return ret;
+
+    for (i = 0; i < input->block_count; i++)
+      {
+	  readosm_export_block *blk = input->blocks + i;
+	  if (blk->file_offset < start_offset)
+	      continue;
+	  if (end_offset >= 0 && blk->file_offset >= end_offset)
+	      break;
+
+	  /* reading the OSMData Blob */
+	  if (!seek_osm_file (input, blk->file_offset))
+	      return READOSM_READ_ERROR;
+	  ret = read_osm_blob (input, &blob);
+	  if (ret <= 0)
 	      return READOSM_INVALID_PBF_HEADER;
+
+	  /* parsing OSMData */
+	  ret =
+	      parse_osm_blob (decoder, &blob, input->little_endian_cpu,
+			      &params);
+	  release_osm_blob (&blob);
+	  if (ret != READOSM_OK)
+	      return ret;
+	  if (params.stop)
+	      return READOSM_ABORT;
       }
     return READOSM_OK;
 }
@@ -54,6 +54,12 @@
 #include "config.h"
 #endif
 
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+
 #include "readosm.h"
 #include "readosm_internals.h"
 
@@ -84,20 +90,74 @@ alloc_osm_file (int little_endian_cpu, int format)
 	return NULL;
     input->magic1 = READOSM_MAGIC_START;
     input->file_format = format;
+    input->options = 0;
     input->little_endian_cpu = little_endian_cpu;
     input->magic2 = READOSM_MAGIC_END;
     input->in = NULL;
+    input->path = NULL;
+    input->map = NULL;
+    input->map_size = 0;
+    input->map_pos = 0;
+    input->blocks = NULL;
+    input->block_count = 0;
+    input->detailed_index = 0;
+    input->decoder = NULL;
+    input->header = NULL;
     return input;
 }
 
+static void
+map_osm_file (readosm_file * input)
+{
+/* 
+ / attempting to memory-map the whole input file
+ / on failure the file will simply be read via stdio
+*/
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+    struct stat st;
+    void *map;
+    int fd = fileno (input->in);
+    if (fstat (fd, &st) != 0)
+	return;
+    if (st.st_size <= 0)
+	return;
+    if ((unsigned long long) st.st_size > (size_t) - 1)
+	return;			/* too big for the address space */
+    map = mmap (NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+	return;
+#ifdef MADV_SEQUENTIAL
+    madvise (map, (size_t) st.st_size, MADV_SEQUENTIAL);
+#endif
+    input->map = map;
+    input->map_size = (size_t) st.st_size;
+    input->map_pos = 0;
+#else
+    if (input == NULL)
+	return;			/* silencing stupid compiler warnings */
+#endif
+}
+
 static void
 destroy_osm_file (readosm_file * input)
 {
 /* destroying the OSM input file struct */
     if (input)
       {
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H)
+	  if (input->map)
+	      munmap (input->map, input->map_size);
+#endif
 	  if (input->in)
 	      fclose (input->in);
+	  if (input->blocks)
+	      free (input->blocks);
+	  if (input->path)
+	      free (input->path);
+	  if (input->decoder)
+	      destroy_pbf_decoder (input->decoder);
+	  if (input->header)
+	      destroy_osm_header (input->header);
 	  free (input);
       }
 }
@@ -106,6 +166,13 @@ READOSM_DECLARE int
 readosm_open (const char *path, const void **osm_handle)
 {
 /* opening and initializing the OSM input file */
+    return readosm_open_ex (path, osm_handle, 0);
+}
+
+READOSM_DECLARE int
+readosm_open_ex (const char *path, const void **osm_handle, int options)
+{
+/* opening and initializing the OSM input file [extended options] */
     readosm_file *input;
     int len;
     int format;
@@ -133,6 +200,21 @@ readosm_open (const char *path, const void **osm_handle)
     if (input->in == NULL)
 	return READOSM_FILE_NOT_FOUND;
 
+    input->path = malloc (len + 1);
+    if (input->path == NULL)
+	return READOSM_INSUFFICIENT_MEMORY;
+    strcpy (input->path, path);
+
+    input->options = options;
+    if (options & READOSM_MMAP)
+	map_osm_file (input);
+
+    if (format == READOSM_PBF_FORMAT)
+      {
+	  load_osm_header (input);
+	  load_block_index (input);
+      }
+
     return READOSM_OK;
 }
 
@@ -155,6 +237,63 @@ readosm_close (const void *osm_handle)
     return READOSM_OK;
 }
 
+struct xml_batch_adapter
+{
+/* adapting the per-object XML callbacks to the batch ones */
+    const void *user_data;
+    readosm_node_batch_callback node_fnct;
+    readosm_way_batch_callback way_fnct;
+    readosm_relation_batch_callback relation_fnct;
+    readosm_node_columns_callback node_columns_fnct;
+};
+
+static int
+xml_batch_node (const void *user_data, const readosm_node * node)
+{
+/* delivering a single NODE as a batch */
+    const struct xml_batch_adapter *adapter = user_data;
+    return (*adapter->node_fnct) (adapter->user_data, node, 1);
+}
+
+static int
+xml_columns_node (const void *user_data, const readosm_node * node)
+{
+/* delivering a single NODE as a batch of columns */
+    const struct xml_batch_adapter *adapter = user_data;
+    readosm_export_node_columns columns;
+    long long id = node->id;
+    int latitude = node->fixed_latitude;
+    int longitude = node->fixed_longitude;
+    int offsets[2];
+    offsets[0] = 0;
+    offsets[1] = node->tag_count;
+    columns.count = 1;
+    columns.ids = &id;
+    columns.fixed_latitudes = &latitude;
+    columns.fixed_longitudes = &longitude;
+    columns.tag_offsets = offsets;
+    columns.tags = (readosm_export_tag *) (node->tags);
+    return (*adapter->node_columns_fnct) (adapter->user_data,
+					  (const readosm_node_columns *)
+					  &columns);
+}
+
+static int
+xml_batch_way (const void *user_data, const readosm_way * way)
+{
+/* delivering a single WAY as a batch */
+    const struct xml_batch_adapter *adapter = user_data;
+    return (*adapter->way_fnct) (adapter->user_data, way, 1);
+}
+
+static int
+xml_batch_relation (const void *user_data, const readosm_relation * relation)
+{
+/* delivering a single RELATION as a batch */
+    const struct xml_batch_adapter *adapter = user_data;
+    return (*adapter->relation_fnct) (adapter->user_data, relation, 1);
+}
+
 READOSM_DECLARE int
 readosm_parse (const void *osm_handle, const void *user_data,
 	       readosm_node_callback node_fnct, readosm_way_callback way_fnct,
@@ -185,6 +324,263 @@ readosm_parse (const void *osm_handle, const void *user_data,
     return ret;
 }
 
+READOSM_DECLARE int
+readosm_parse_mt (const void *osm_handle, const void *user_data,
+		  readosm_node_callback node_fnct,
+		  readosm_way_callback way_fnct,
+		  readosm_relation_callback relation_fnct, int threads)
+{
+/* attempting to parse the OSM input file [multi-threaded] */
+    int ret;
+    readosm_file *input = (readosm_file *) osm_handle;
+    if (!input)
+	return READOSM_NULL_HANDLE;
+    if ((input->magic1 == READOSM_MAGIC_START)
+	&& input->magic2 == READOSM_MAGIC_END)
+	;
+    else
+	return READOSM_INVALID_HANDLE;
+
+    if (input->file_format == READOSM_OSM_FORMAT)
+	ret =
+	    parse_osm_xml (input, user_data, node_fnct, way_fnct,
+			   relation_fnct);
+    else if (input->file_format == READOSM_PBF_FORMAT)
+	ret =
+	    parse_osm_pbf_mt (input, user_data, node_fnct, way_fnct,
+			      relation_fnct, threads);
+    else
+	return READOSM_INVALID_HANDLE;
+
+    return ret;
+}
+
+READOSM_DECLARE int
+readosm_parse_parallel (const void *osm_handle,
+			readosm_user_data_factory factory,
+			const void *factory_data,
+			readosm_node_callback node_fnct,
+			readosm_way_callback way_fnct,
+			readosm_relation_callback relation_fnct, int threads)
+{
+/* attempting to parse the OSM input file [multi-threaded, unordered] */
+    int ret;
+    readosm_file *input = (readosm_file *) osm_handle;
+    if (!input)
+	return READOSM_NULL_HANDLE;
+    if ((input->magic1 == READOSM_MAGIC_START)
+	&& input->magic2 == READOSM_MAGIC_END)
+	;
+    else
+	return READOSM_INVALID_HANDLE;
+
+    if (input->file_format == READOSM_OSM_FORMAT)
+      {
+	  const void *user_data = factory_data;
+	  if (factory != NULL)
+	      user_data = (*factory) (factory_data, 0);
+	  ret =
+	      parse_osm_xml (input, user_data, node_fnct, way_fnct,
+			     relation_fnct);
+      }
+    else if (input->file_format == READOSM_PBF_FORMAT)
+	ret =
+	    parse_osm_pbf_parallel (input, factory, factory_data, node_fnct,
+				    way_fnct, relation_fnct, threads);
+    else
+	return READOSM_INVALID_HANDLE;
+
+    return ret;
+}
+
+READOSM_DECLARE int
+readosm_parse_batches (const void *osm_handle, const void *user_data,
+		       readosm_node_batch_callback node_fnct,
+		       readosm_way_batch_callback way_fnct,
+		       readosm_relation_batch_callback relation_fnct)
+{
+/* attempting to parse the OSM input file [arrays of objects] */
+    int ret;
+    readosm_file *input = (readosm_file *) osm_handle;
+    if (!input)
+	return READOSM_NULL_HANDLE;
+    if ((input->magic1 == READOSM_MAGIC_START)
+	&& input->magic2 == READOSM_MAGIC_END)
+	;
+    else
+	return READOSM_INVALID_HANDLE;
+
+    if (input->file_format == READOSM_OSM_FORMAT)
+      {
+	  struct xml_batch_adapter adapter;
+	  adapter.user_data = user_data;
+	  adapter.node_fnct = node_fnct;
+	  adapter.way_fnct = way_fnct;
+	  adapter.relation_fnct = relation_fnct;
+	  adapter.node_columns_fnct = NULL;
+	  ret =
+	      parse_osm_xml (input, &adapter,
+			     (node_fnct) ? xml_batch_node : NULL,
+			     (way_fnct) ? xml_batch_way : NULL,
+			     (relation_fnct) ? xml_batch_relation : NULL);
+      }
+    else if (input->file_format == READOSM_PBF_FORMAT)
+	ret =
+	    parse_osm_pbf_batches (input, user_data, node_fnct, way_fnct,
+				   relation_fnct);
+    else
+	return READOSM_INVALID_HANDLE;
+
+    return ret;
+}
+
+READOSM_DECLARE int
+readosm_parse_columns (const void *osm_handle, const void *user_data,
+		       readosm_node_columns_callback node_fnct,
+		       readosm_way_batch_callback way_fnct,
+		       readosm_relation_batch_callback relation_fnct)
+{
+/* attempting to parse the OSM input file [columns of NODEs] */
+    int ret;
+    readosm_file *input = (readosm_file *) osm_handle;
+    if (!input)
+	return READOSM_NULL_HANDLE;
+    if ((input->magic1 == READOSM_MAGIC_START)
+	&& input->magic2 == READOSM_MAGIC_END)
+	;
+    else
+	return READOSM_INVALID_HANDLE;
+
+    if (input->file_format == READOSM_OSM_FORMAT)
+      {
+	  struct xml_batch_adapter adapter;
+	  adapter.user_data = user_data;
+	  adapter.node_fnct = NULL;
+	  adapter.way_fnct = way_fnct;
+	  adapter.relation_fnct = relation_fnct;
+	  adapter.node_columns_fnct = node_fnct;
+	  ret =
+	      parse_osm_xml (input, &adapter,
+			     (node_fnct) ? xml_columns_node : NULL,
+			     (way_fnct) ? xml_batch_way : NULL,
+			     (relation_fnct) ? xml_batch_relation : NULL);
+      }
+    else if (input->file_format == READOSM_PBF_FORMAT)
+	ret =
+	    parse_osm_pbf_columns (input, user_data, node_fnct, way_fnct,
+				   relation_fnct);
+    else
+	return READOSM_INVALID_HANDLE;
+
+    return ret;
+}
+
+READOSM_DECLARE int
+readosm_get_header (const void *osm_handle, const readosm_header ** header)
+{
+/* attempting to retrieve the PBF HeaderBlock */
+    readosm_file *input = (readosm_file *) osm_handle;
+    if (header != NULL)
+	*header = NULL;
+    if (!input)
+	return READOSM_NULL_HANDLE;
+    if ((input->magic1 == READOSM_MAGIC_START)
+	&& input->magic2 == READOSM_MAGIC_END)
+	;
+    else
+	return READOSM_INVALID_HANDLE;
+    if (header == NULL)
+	return READOSM_NULL_HANDLE;
+    if (input->file_format != READOSM_PBF_FORMAT || input->header == NULL)
+	return READOSM_INVALID_PBF_HEADER;
+
+    *header = (const readosm_header *) (input->header);
+    return READOSM_OK;
+}
+
+READOSM_DECLARE int
+readosm_build_block_index (const void *osm_handle,
+			   const readosm_block ** blocks, int *count)
+{
+/* attempting to build the PBF block index */
+    int ret;
+    readosm_file *input = (readosm_file *) osm_handle;
+    if (blocks != NULL)
+	*blocks = NULL;
+    if (count != NULL)
+	*count = 0;
+    if (!input)
+	return READOSM_NULL_HANDLE;
+    if ((input->magic1 == READOSM_MAGIC_START)
+	&& input->magic2 == READOSM_MAGIC_END)
+	;
+    else
+	return READOSM_INVALID_HANDLE;
+    if (blocks == NULL || count == NULL)
+	return READOSM_NULL_HANDLE;
+    if (input->file_format != READOSM_PBF_FORMAT)
+	return READOSM_INVALID_PBF_HEADER;
+
+    ret = build_block_index (input);
+    if (ret != READOSM_OK)
+	return ret;
+    *blocks = (const readosm_block *) (input->blocks);
+    *count = input->block_count;
+    return READOSM_OK;
+}
+
+READOSM_DECLARE int
+readosm_write_block_index (const void *osm_handle)
+{
+/* attempting to write the PBF block index sidecar file */
+    readosm_file *input = (readosm_file *) osm_handle;
+    if (!input)
+	return READOSM_NULL_HANDLE;
+    if ((input->magic1 == READOSM_MAGIC_START)
+	&& input->magic2 == READOSM_MAGIC_END)
+	;
+    else
+	return READOSM_INVALID_HANDLE;
+    if (input->file_format != READOSM_PBF_FORMAT)
+	return READOSM_INVALID_PBF_HEADER;
+
+    return write_block_index (input);
+}
+
+READOSM_DECLARE int
+readosm_parse_range (const void *osm_handle, long long start_offset,
+		     long long end_offset, const void *user_data,
+		     readosm_node_callback node_fnct,
+		     readosm_way_callback way_fnct,
+		     readosm_relation_callback relation_fnct)
+{
+/* attempting to parse a byte range of the PBF input file */
+    readosm_file *input = (readosm_file *) osm_handle;
+    if (!input)
+	return READOSM_NULL_HANDLE;
+    if ((input->magic1 == READOSM_MAGIC_START)
+	&& input->magic2 == READOSM_MAGIC_END)
+	;
+    else
+	return READOSM_INVALID_HANDLE;
+    if (input->file_format != READOSM_PBF_FORMAT)
+	return READOSM_INVALID_PBF_HEADER;
+
+    return parse_osm_pbf_range (input, start_offset, end_offset, user_data,
+				node_fnct, way_fnct, relation_fnct);
+}
+
+READOSM_DECLARE int
+readosm_format_timestamp (long long timestamp_epoch, char *buffer)
+{
+/* formatting a timestamp as an ISO-8601 string */
+    if (buffer == NULL)
+	return READOSM_INVALID_TIMESTAMP;
+    if (!format_iso8601 (timestamp_epoch, buffer))
+	return READOSM_INVALID_TIMESTAMP;
+    return READOSM_OK;
+}
+
 READOSM_DECLARE const char *
 readosm_version (void)
 {
@@ -0,0 +1,875 @@
+/* 
+/ bench_varint.c
+/
+/ varint decoding microbenchmark
+/
+/ Author: the ReadOSM contributors, 2026
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the ReadOSM library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2012-2017
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/ 
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <zlib.h>
+
+#include "readosm.h"
+#include "readosm_internals.h"
+#include "readosm_protobuf.h"
+#include "readosm_varint.h"
+
+/*
+ * a microbenchmark comparing the legacy byte-at-a-time read_var()
+ * against the specialized varint decoders, and against the bulk
+ * decoders used for packed arrays (SIMD when available)
+ *
+ * all packed varint arrays found in the OSMData blocks (DenseNodes,
+ * DenseInfo, Ways and Relations) are first collected in memory, and
+ * then repeatedly decoded by both implementations
+ *
+ * usage: bench_varint [repetitions] [file.osm.pbf ...]
+ */
+
+#define MSG_PRIMITIVE_BLOCK	1
+#define MSG_PRIMITIVE_GROUP	2
+#define MSG_DENSE_NODES		3
+#define MSG_DENSE_INFO		4
+#define MSG_WAY			5
+#define MSG_RELATION		6
+
+struct packed_field
+{
+/* a packed varint array */
+    unsigned char *start;
+    unsigned char *stop;
+    unsigned char type;		/* READOSM_VAR_xx */
+};
+
+struct bench_data
+{
+/* all packed arrays to be decoded */
+    struct packed_field *fields;
+    int count;
+    int max;
+    unsigned char **blocks;	/* inflated PrimitiveBlocks */
+    int block_count;
+    int block_max;
+};
+
+static unsigned char *
+legacy_read_var (unsigned char *start, unsigned char *stop, readosm_variant * variant)
+{
+/* 
+ / attempting to read a variable length base128 int 
+ /
+ / PBF integers are encoded as base128, i.e. using 7 bits
+ / for each byte: if the most significant bit is 1, then
+ / a further byte is required to get the int value, and so
+ / on, until a byte having a 0 most significant bit is found.
+ /
+ / using this encoding little values simply require few bytes:
+ / as a worst case 5 bytes are required to encode int32, and
+ / 10 bytes to encode int64
+ /
+ / there is a further complication: negative value will always 
+ / require 5 or 10 bytes: thus SINT32 and SINT64 values are
+ / encoded using a "ZigZag" schema.
+ /
+ / for more details please see:
+ / https://developers.google.com/protocol-buffers/docs/encoding
+*/
+    unsigned char *ptr = start;
+    unsigned char c;
+    unsigned int v32;
+    unsigned long long v64;
+    unsigned int value32 = 0x00000000;
+    unsigned long long value64 = 0x0000000000000000;
+    readosm_endian4 endian4;
+    readosm_endian8 endian8;
+    int next;
+    int count = 0;
+    int neg;
+
+    while (1)
+      {
+	  if (ptr > stop)
+	      return NULL;
+	  c = *ptr++;
+	  if ((c & 0x80) == 0x80)
+	      next = 1;
+	  else
+	      next = 0;
+	  c &= 0x7f;
+	  switch (variant->type)
+	    {
+	    case READOSM_VAR_INT32:
+	    case READOSM_VAR_UINT32:
+	    case READOSM_VAR_SINT32:
+		switch (count)
+		  {
+		  case 0:
+		      memset (endian4.bytes, 0x00, 4);
+		      if (variant->little_endian_cpu)
+			  endian4.bytes[0] = c;
+		      else
+			  endian4.bytes[3] = c;
+		      v32 = endian4.uint32_value;
+		      v32 &= READOSM_MASK32_1;
+		      value32 |= v32;
+		      break;
+		  case 1:
+		      memset (endian4.bytes, 0x00, 4);
+		      if (variant->little_endian_cpu)
+			  endian4.bytes[0] = c;
+		      else
+			  endian4.bytes[3] = c;
+		      v32 = endian4.uint32_value << 7;
+		      v32 &= READOSM_MASK32_2;
+		      value32 |= v32;
+		      break;
+		  case 2:
+		      memset (endian4.bytes, 0x00, 4);
+		      if (variant->little_endian_cpu)
+			  endian4.bytes[0] = c;
+		      else
+			  endian4.bytes[3] = c;
+		      v32 = endian4.uint32_value << 14;
+		      v32 &= READOSM_MASK32_3;
+		      value32 |= v32;
+		      break;
+		  case 3:
+		      memset (endian4.bytes, 0x00, 4);
+		      if (variant->little_endian_cpu)
+			  endian4.bytes[0] = c;
+		      else
+			  endian4.bytes[3] = c;
+		      v32 = endian4.uint32_value << 21;
+		      v32 &= READOSM_MASK32_4;
+		      value32 |= v32;
+		      break;
+		  case 4:
+		      memset (endian4.bytes, 0x00, 4);
+		      if (variant->little_endian_cpu)
+			  endian4.bytes[0] = c;
+		      else
+			  endian4.bytes[3] = c;
+		      v32 = endian4.uint32_value << 28;
+		      v32 &= READOSM_MASK32_5;
+		      value32 |= v32;
+		      break;
+		  default:
+		      return NULL;
+		  };
+		break;
+	    case READOSM_VAR_INT64:
+	    case READOSM_VAR_UINT64:
+	    case READOSM_VAR_SINT64:
+		switch (count)
+		  {
+		  case 0:
+		      memset (endian8.bytes, 0x00, 8);
+		      if (variant->little_endian_cpu)
+			  endian8.bytes[0] = c;
+		      else
+			  endian8.bytes[7] = c;
+		      v64 = endian8.uint64_value;
+		      v64 &= READOSM_MASK64_1;
+		      value64 |= v64;
+		      break;
+		  case 1:
+		      memset (endian8.bytes, 0x00, 8);
+		      if (variant->little_endian_cpu)
+			  endian8.bytes[0] = c;
+		      else
+			  endian8.bytes[7] = c;
+		      v64 = endian8.uint64_value << 7;
+		      v64 &= READOSM_MASK64_2;
+		      value64 |= v64;
+		      break;
+		  case 2:
+		      memset (endian8.bytes, 0x00, 8);
+		      if (variant->little_endian_cpu)
+			  endian8.bytes[0] = c;
+		      else
+			  endian8.bytes[7] = c;
+		      v64 = endian8.uint64_value << 14;
+		      v64 &= READOSM_MASK64_3;
+		      value64 |= v64;
+		      break;
+		  case 3:
+		      memset (endian8.bytes, 0x00, 8);
+		      if (variant->little_endian_cpu)
+			  endian8.bytes[0] = c;
+		      else
+			  endian8.bytes[7] = c;
+		      v64 = endian8.uint64_value << 21;
+		      v64 &= READOSM_MASK64_4;
+		      value64 |= v64;
+		      break;
+		  case 4:
+		      memset (endian8.bytes, 0x00, 8);
+		      if (variant->little_endian_cpu)
+			  endian8.bytes[0] = c;
+		      else
+			  endian8.bytes[7] = c;
+		      v64 = endian8.uint64_value << 28;
+		      v64 &= READOSM_MASK64_5;
+		      value64 |= v64;
+		      break;
+		  case 5:
+		      memset (endian8.bytes, 0x00, 8);
+		      if (variant->little_endian_cpu)
+			  endian8.bytes[0] = c;
+		      else
+			  endian8.bytes[7] = c;
+		      v64 = endian8.uint64_value << 35;
+		      v64 &= READOSM_MASK64_6;
+		      value64 |= v64;
+		      break;
+		  case 6:
+		      memset (endian8.bytes, 0x00, 8);
+		      if (variant->little_endian_cpu)
+			  endian8.bytes[0] = c;
+		      else
+			  endian8.bytes[7] = c;
+		      v64 = endian8.uint64_value << 42;
+		      v64 &= READOSM_MASK64_7;
+		      value64 |= v64;
+		      break;
+		  case 7:
+		      memset (endian8.bytes, 0x00, 8);
+		      if (variant->little_endian_cpu)
+			  endian8.bytes[0] = c;
+		      else
+			  endian8.bytes[7] = c;
+		      v64 = endian8.uint64_value << 49;
+		      v64 &= READOSM_MASK64_8;
+		      value64 |= v64;
+		      break;
+		  case 8:
+		      memset (endian8.bytes, 0x00, 8);
+		      if (variant->little_endian_cpu)
+			  endian8.bytes[0] = c;
+		      else
+			  endian8.bytes[7] = c;
+		      v64 = endian8.uint64_value << 56;
+		      v64 &= READOSM_MASK64_9;
+		      value64 |= v64;
+		      break;
+		  case 9:
+		      memset (endian8.bytes, 0x00, 8);
+		      if (variant->little_endian_cpu)
+			  endian8.bytes[0] = c;
+		      else
+			  endian8.bytes[7] = c;
+		      v64 = endian8.uint64_value << 63;
+		      v64 &= READOSM_MASK64_A;
+		      value64 |= v64;
+		      break;
+		  default:
+		      return NULL;
+		  };
+		break;
+	    };
+	  count++;
+	  if (!next)
+	      break;
+      }
+
+    switch (variant->type)
+      {
+      case READOSM_VAR_INT32:
+	  variant->value.int32_value = (int) value32;
+	  variant->valid = 1;
+	  return ptr;
+      case READOSM_VAR_UINT32:
+	  variant->value.uint32_value = value32;
+	  variant->valid = 1;
+	  return ptr;
+      case READOSM_VAR_SINT32:
+	  if ((value32 & 0x00000001) == 0)
+	      neg = 1;
+	  else
+	      neg = -1;
+	  v32 = (value32 + 1) / 2;
+	  variant->value.int32_value = v32 * neg;
+	  variant->valid = 1;
+	  return ptr;
+      case READOSM_VAR_INT64:
+	  variant->value.int64_value = (long long) value64;
+	  variant->valid = 1;
+	  return ptr;
+      case READOSM_VAR_UINT64:
+	  variant->value.uint64_value = value64;
+	  variant->valid = 1;
+	  return ptr;
+      case READOSM_VAR_SINT64:
+	  if ((value64 & 0x0000000000000001) == 0)
+	      neg = 1;
+	  else
+	      neg = -1;
+	  v64 = (value64 + 1) / 2;
+	  variant->value.int64_value = v64 * neg;
+	  variant->valid = 1;
+	  return ptr;
+      };
+    return NULL;
+}
+
+
+static int
+add_field (struct bench_data *data, unsigned char *start, size_t len,
+	   unsigned char type)
+{
+/* collecting a packed varint array */
+    struct packed_field *fld;
+    if (len == 0)
+	return 1;
+    if (data->count == data->max)
+      {
+	  data->max = (data->max == 0) ? 1024 : data->max * 2;
+	  fld = realloc (data->fields, sizeof (struct packed_field) * data->max);
+	  if (fld == NULL)
+	      return 0;
+	  data->fields = fld;
+      }
+    fld = data->fields + data->count;
+    fld->start = start;
+    fld->stop = start + len - 1;
+    fld->type = type;
+    data->count += 1;
+    return 1;
+}
+
+static int
+field_type (int message, int field_id, int *sub_message)
+{
+/* identifying a packed varint array (or a nested message) */
+    *sub_message = 0;
+    switch (message)
+      {
+      case MSG_PRIMITIVE_BLOCK:
+	  if (field_id == 2)
+	      *sub_message = MSG_PRIMITIVE_GROUP;
+	  break;
+      case MSG_PRIMITIVE_GROUP:
+	  if (field_id == 2)
+	      *sub_message = MSG_DENSE_NODES;
+	  if (field_id == 3)
+	      *sub_message = MSG_WAY;
+	  if (field_id == 4)
+	      *sub_message = MSG_RELATION;
+	  break;
+      case MSG_DENSE_NODES:
+	  if (field_id == 1 || field_id == 8 || field_id == 9)
+	      return READOSM_VAR_SINT64;
+	  if (field_id == 10)
+	      return READOSM_VAR_INT32;
+	  if (field_id == 5)
+	      *sub_message = MSG_DENSE_INFO;
+	  break;
+      case MSG_DENSE_INFO:
+	  if (field_id == 1)
+	      return READOSM_VAR_INT32;
+	  if (field_id == 2 || field_id == 3)
+	      return READOSM_VAR_SINT64;
+	  if (field_id == 4 || field_id == 5)
+	      return READOSM_VAR_SINT32;
+	  break;
+      case MSG_WAY:
+	  if (field_id == 2 || field_id == 3)
+	      return READOSM_VAR_UINT32;
+	  if (field_id == 8 || field_id == 9 || field_id == 10)
+	      return READOSM_VAR_SINT64;
+	  break;
+      case MSG_RELATION:
+	  if (field_id == 2 || field_id == 3)
+	      return READOSM_VAR_UINT32;
+	  if (field_id == 8 || field_id == 10)
+	      return READOSM_VAR_INT32;
+	  if (field_id == 9)
+	      return READOSM_VAR_SINT64;
+	  break;
+      };
+    return 0;
+}
+
+static int
+collect_fields (struct bench_data *data, int message, unsigned char *start,
+		unsigned char *stop)
+{
+/* recursively collecting all packed varint arrays from a message */
+    unsigned char *ptr = start;
+    unsigned long long tag;
+    unsigned long long len;
+    int type;
+    int sub_message;
+
+    while (ptr <= stop)
+      {
+	  ptr = read_varint64 (ptr, stop, &tag);
+	  if (ptr == NULL)
+	      return 0;
+	  switch (tag & 0x07)
+	    {
+	    case 0:
+		ptr = read_varint64 (ptr, stop, &len);
+		if (ptr == NULL)
+		    return 0;
+		continue;
+	    case 1:
+		ptr += 8;
+		continue;
+	    case 5:
+		ptr += 4;
+		continue;
+	    case 2:
+		break;
+	    default:
+		return 0;
+	    };
+	  ptr = read_varint64 (ptr, stop, &len);
+	  if (ptr == NULL || len > (unsigned long long) (stop - ptr + 1))
+	      return 0;
+	  type = field_type (message, (int) (tag >> 3), &sub_message);
+	  if (type != 0)
+	    {
+		if (!add_field (data, ptr, (size_t) len, (unsigned char) type))
+		    return 0;
+	    }
+	  if (sub_message != 0 && len > 0)
+	    {
+		if (!collect_fields
+		    (data, sub_message, ptr, ptr + (size_t) len - 1))
+		    return 0;
+	    }
+	  ptr += len;
+      }
+    return 1;
+}
+
+static int
+find_field (unsigned char *start, unsigned char *stop, int field_id,
+	    unsigned char **value, unsigned long long *len)
+{
+/* searching a length-delimited (or varint) field within a message */
+    unsigned char *ptr = start;
+    unsigned long long tag;
+    unsigned long long v;
+
+    while (ptr <= stop)
+      {
+	  ptr = read_varint64 (ptr, stop, &tag);
+	  if (ptr == NULL)
+	      return 0;
+	  if ((tag & 0x07) == 0)
+	    {
+		ptr = read_varint64 (ptr, stop, &v);
+		if (ptr == NULL)
+		    return 0;
+		if ((int) (tag >> 3) == field_id)
+		  {
+		      *value = NULL;
+		      *len = v;
+		      return 1;
+		  }
+		continue;
+	    }
+	  if ((tag & 0x07) != 2)
+	      return 0;
+	  ptr = read_varint64 (ptr, stop, &v);
+	  if (ptr == NULL || v > (unsigned long long) (stop - ptr + 1))
+	      return 0;
+	  if ((int) (tag >> 3) == field_id)
+	    {
+		*value = ptr;
+		*len = v;
+		return 1;
+	    }
+	  ptr += v;
+      }
+    return 0;
+}
+
+static int
+load_blocks (struct bench_data *data, const char *path)
+{
+/* loading and inflating all OSMData blocks from a PBF file */
+    FILE *in;
+    long size;
+    unsigned char *buf;
+    unsigned char *ptr;
+    unsigned char *end;
+    int ret = 0;
+
+    in = fopen (path, "rb");
+    if (in == NULL)
+	return 0;
+    fseek (in, 0, SEEK_END);
+    size = ftell (in);
+    fseek (in, 0, SEEK_SET);
+    buf = malloc (size);
+    if (buf == NULL || fread (buf, 1, size, in) != (size_t) size)
+	goto stop;
+    ptr = buf;
+    end = buf + size;
+
+    while (ptr + 4 <= end)
+      {
+	  unsigned long hdr_sz =
+	      ((unsigned long) ptr[0] << 24) | ((unsigned long) ptr[1] << 16)
+	      | ((unsigned long) ptr[2] << 8) | ptr[3];
+	  unsigned char *type;
+	  unsigned long long type_len;
+	  unsigned char *dummy;
+	  unsigned long long blob_len;
+	  unsigned char *blob;
+	  unsigned char *zdata;
+	  unsigned long long zlen;
+	  unsigned long long raw_len;
+	  unsigned char *raw;
+	  uLongf raw_sz;
+
+	  ptr += 4;
+	  if (ptr + hdr_sz > end)
+	      goto stop;
+	  if (!find_field (ptr, ptr + hdr_sz - 1, 1, &type, &type_len))
+	      goto stop;
+	  if (!find_field (ptr, ptr + hdr_sz - 1, 3, &dummy, &blob_len))
+	      goto stop;
+	  blob = ptr + hdr_sz;
+	  ptr = blob + blob_len;
+	  if (ptr > end)
+	      goto stop;
+	  if (type_len != 7 || memcmp (type, "OSMData", 7) != 0)
+	      continue;
+	  if (!find_field (blob, blob + blob_len - 1, 2, &dummy, &raw_len))
+	      continue;
+	  if (!find_field (blob, blob + blob_len - 1, 3, &zdata, &zlen))
+	      continue;		/* not a zlib compressed block */
+	  raw = malloc ((size_t) raw_len);
+	  if (raw == NULL)
+	      goto stop;
+	  raw_sz = (uLongf) raw_len;
+	  if (uncompress (raw, &raw_sz, zdata, (uLong) zlen) != Z_OK
+	      || raw_sz != raw_len)
+	    {
+		free (raw);
+		goto stop;
+	    }
+	  if (data->block_count == data->block_max)
+	    {
+		unsigned char **blocks;
+		data->block_max =
+		    (data->block_max == 0) ? 64 : data->block_max * 2;
+		blocks =
+		    realloc (data->blocks,
+			     sizeof (unsigned char *) * data->block_max);
+		if (blocks == NULL)
+		  {
+		      free (raw);
+		      goto stop;
+		  }
+		data->blocks = blocks;
+	    }
+	  data->blocks[data->block_count++] = raw;
+	  if (!collect_fields
+	      (data, MSG_PRIMITIVE_BLOCK, raw, raw + raw_sz - 1))
+	      goto stop;
+      }
+    ret = 1;
+
+  stop:
+    if (buf != NULL)
+	free (buf);
+    fclose (in);
+    return ret;
+}
+
+static void
+free_bench_data (struct bench_data *data)
+{
+/* memory cleanup */
+    int i;
+    for (i = 0; i < data->block_count; i++)
+	free (data->blocks[i]);
+    if (data->blocks != NULL)
+	free (data->blocks);
+    if (data->fields != NULL)
+	free (data->fields);
+}
+
+static int
+run_legacy (struct bench_data *data, char little_endian_cpu,
+	    unsigned long long *sum)
+{
+/* decoding all packed arrays by using the legacy read_var() */
+    int i;
+    int count = 0;
+    readosm_variant variant;
+
+    memset (&variant, 0, sizeof (readosm_variant));
+    variant.little_endian_cpu = little_endian_cpu;
+    for (i = 0; i < data->count; i++)
+      {
+	  struct packed_field *fld = data->fields + i;
+	  unsigned char *ptr = fld->start;
+	  variant.type = fld->type;
+	  while (ptr <= fld->stop)
+	    {
+		ptr = legacy_read_var (ptr, fld->stop, &variant);
+		if (ptr == NULL)
+		    return -1;
+		if (fld->type == READOSM_VAR_INT64
+		    || fld->type == READOSM_VAR_UINT64
+		    || fld->type == READOSM_VAR_SINT64)
+		    *sum += variant.value.uint64_value;
+		else
+		    *sum += variant.value.uint32_value;
+		count++;
+	    }
+      }
+    return count;
+}
+
+static int
+run_fast (struct bench_data *data, unsigned long long *sum)
+{
+/* decoding all packed arrays by using the specialized decoders */
+    int i;
+    int count = 0;
+    unsigned int v32 = 0;
+    int s32 = 0;
+    unsigned long long v64 = 0;
+    long long s64 = 0;
+
+    for (i = 0; i < data->count; i++)
+      {
+	  struct packed_field *fld = data->fields + i;
+	  unsigned char *ptr = fld->start;
+	  while (ptr <= fld->stop)
+	    {
+		switch (fld->type)
+		  {
+		  case READOSM_VAR_SINT64:
+		      ptr = read_svarint64 (ptr, fld->stop, &s64);
+		      if (ptr == NULL)
+			  break;
+		      *sum += (unsigned long long) s64;
+		      break;
+		  case READOSM_VAR_INT64:
+		  case READOSM_VAR_UINT64:
+		      ptr = read_varint64 (ptr, fld->stop, &v64);
+		      if (ptr == NULL)
+			  break;
+		      *sum += v64;
+		      break;
+		  case READOSM_VAR_SINT32:
+		      ptr = read_svarint32 (ptr, fld->stop, &s32);
+		      if (ptr == NULL)
+			  break;
+		      *sum += (unsigned int) s32;
+		      break;
+		  default:
+		      ptr = read_varint32 (ptr, fld->stop, &v32);
+		      if (ptr == NULL)
+			  break;
+		      *sum += v32;
+		      break;
+		  };
+		if (ptr == NULL)
+		    return -1;
+		count++;
+	    }
+      }
+    return count;
+}
+
+static int
+run_bulk (struct bench_data *data, long long *buffer,
+	  unsigned long long *sum)
+{
+/* decoding all packed arrays by using the bulk decoders */
+    int i;
+    int j;
+    int n;
+    int count = 0;
+
+    for (i = 0; i < data->count; i++)
+      {
+	  struct packed_field *fld = data->fields + i;
+	  switch (fld->type)
+	    {
+	    case READOSM_VAR_SINT64:
+		n = decode_packed_sint64 (fld->start, fld->stop, buffer);
+		for (j = 0; j < n; j++)
+		    *sum += (unsigned long long) buffer[j];
+		break;
+	    case READOSM_VAR_SINT32:
+		n = decode_packed_sint32 (fld->start, fld->stop,
+					  (int *) buffer);
+		for (j = 0; j < n; j++)
+		    *sum += (unsigned int) ((int *) buffer)[j];
+		break;
+	    default:
+		n = decode_packed_uint32 (fld->start, fld->stop,
+					  (unsigned int *) buffer);
+		for (j = 0; j < n; j++)
+		    *sum += ((unsigned int *) buffer)[j];
+		break;
+	    };
+	  if (n < 0)
+	      return -1;
+	  count += n;
+      }
+    return count;
+}
+
+static int
+bench_file (const char *path, int reps, char little_endian_cpu)
+{
+/* running the benchmark on a single PBF file */
+    struct bench_data data;
+    unsigned long long sum_legacy = 0;
+    unsigned long long sum_fast = 0;
+    unsigned long long sum_bulk = 0;
+    long long *buffer;
+    int max_len = 0;
+    int count = 0;
+    int bulk_count = 0;
+    int i;
+    clock_t t0;
+    double legacy;
+    double fast;
+    double bulk;
+
+    memset (&data, 0, sizeof (struct bench_data));
+    if (!load_blocks (&data, path))
+      {
+	  fprintf (stderr, "%s: unable to load the OSMData blocks\n", path);
+	  free_bench_data (&data);
+	  return 0;
+      }
+
+    t0 = clock ();
+    for (i = 0; i < reps; i++)
+	count = run_legacy (&data, little_endian_cpu, &sum_legacy);
+    legacy = (double) (clock () - t0) / CLOCKS_PER_SEC;
+    t0 = clock ();
+    for (i = 0; i < reps; i++)
+	count = run_fast (&data, &sum_fast);
+    fast = (double) (clock () - t0) / CLOCKS_PER_SEC;
+
+    for (i = 0; i < data.count; i++)
+      {
+	  int len = (int) (data.fields[i].stop - data.fields[i].start + 1);
+	  if (len > max_len)
+	      max_len = len;
+      }
+    buffer = malloc (sizeof (long long) * (max_len + READOSM_PACKED_SLACK));
+    if (buffer == NULL)
+      {
+	  free_bench_data (&data);
+	  return 0;
+      }
+    t0 = clock ();
+    for (i = 0; i < reps; i++)
+	bulk_count = run_bulk (&data, buffer, &sum_bulk);
+    bulk = (double) (clock () - t0) / CLOCKS_PER_SEC;
+    free (buffer);
+
+    if (count <= 0 || sum_legacy != sum_fast || bulk_count != count
+	|| sum_legacy != sum_bulk)
+      {
+	  fprintf (stderr, "%s: mismatching results\n", path);
+	  free_bench_data (&data);
+	  return 0;
+      }
+    printf ("%s: %d varints x %d\n"
+	    "    legacy read_var():  %.2f ns/varint\n"
+	    "    read_varint():      %.2f ns/varint (%.2fx)\n"
+	    "    bulk decoder (%s): %.2f ns/varint (%.2fx)\n", path,
+	    count, reps, legacy * 1e9 / ((double) count * reps),
+	    fast * 1e9 / ((double) count * reps),
+	    (fast > 0.0) ? legacy / fast : 0.0,
+	    packed_varint_simd ()? "SSE4.1" : "scalar",
+	    bulk * 1e9 / ((double) count * reps),
+	    (bulk > 0.0) ? legacy / bulk : 0.0);
+    free_bench_data (&data);
+    return 1;
+}
+
+int
+main (int argc, char *argv[])
+{
+    int reps = 100;
+    int i;
+    int ret = 0;
+    union
+    {
+	unsigned short value;
+	unsigned char bytes[2];
+    } endian;
+    char little_endian_cpu;
+
+    endian.value = 1;
+    little_endian_cpu = endian.bytes[0];
+
+    if (argc > 1)
+	reps = atoi (argv[1]);
+    if (reps <= 0)
+	reps = 100;
+    if (argc > 2)
+      {
+	  for (i = 2; i < argc; i++)
+	    {
+		if (!bench_file (argv[i], reps, little_endian_cpu))
+		    ret = 1;
+	    }
+      }
+    else
+      {
+	  if (!bench_file ("testdata/test.osm.pbf", reps, little_endian_cpu))
+	      ret = 1;
+	  if (!bench_file
+	      ("testdata/noNodesPackedInfos.osm.pbf", reps, little_endian_cpu))
+	      ret = 1;
+      }
+    return ret;
+}
@@ -45,6 +45,8 @@
 #include <stdio.h>
 #include <memory.h>
 
+#include "config.h"
+
 #include "readosm.h"
 
 struct osm_count
@@ -105,12 +107,62 @@ parse_relation (const void *user_data, const readosm_relation * relation)
     return READOSM_OK;
 }
 
+static int
+check_fixed_node (const void *user_data, const readosm_node * node)
+{
+/* Node callback function: checking the fixed-point coordinates */
+    int *failed = (int *) user_data;
+    if (node->id == 1)
+      {
+	  /* no coordinates at all */
+	  if (node->fixed_latitude != READOSM_UNDEFINED_FIXED
+	      || node->fixed_longitude != READOSM_UNDEFINED_FIXED)
+	      *failed = 1;
+      }
+    else
+      {
+	  /* -123.4567890 degrees is a perfectly valid longitude */
+	  if (node->fixed_latitude != 455000000
+	      || node->fixed_longitude != -1234567890)
+	      *failed = 1;
+      }
+    return READOSM_OK;
+}
+
+static int
+parse_count (const char *path, struct osm_count *cnt)
+{
+/* parsing the whole file, counting any object */
+    const void *handle;
+    int ret = readosm_open (path, &handle);
+    zero_count (cnt);
+    if (ret == READOSM_OK)
+	ret = readosm_parse (handle, cnt, parse_node, parse_way,
+			     parse_relation);
+    readosm_close (handle);
+    return ret;
+}
+
+static int
+same_count (const struct osm_count *a, const struct osm_count *b)
+{
+/* comparing two osm_count structs */
+    return (a->nodes == b->nodes && a->nd_tags == b->nd_tags
+	    && a->ways == b->ways && a->way_nds == b->way_nds
+	    && a->way_tags == b->way_tags && a->relations == b->relations
+	    && a->rel_members == b->rel_members
+	    && a->rel_tags == b->rel_tags);
+}
+
 int
 main (int argc, char *argv[])
 {
     const void *handle;
     int ret;
     struct osm_count count;
+    struct osm_count ref_count;
+    FILE *out;
+    int failed;
     char buffer[128];
     memset (buffer, '\0', 128);
 
@@ -513,5 +565,166 @@ main (int argc, char *argv[])
 	  return -46;
       }
 
+    ret = readosm_open_ex ("testdata/test.osm", &handle, READOSM_MMAP);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR: %d\n", ret);
+	  return -47;
+      }
+
+    zero_count (&count);
+    ret = readosm_parse (handle, &count, parse_node, parse_way, parse_relation);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "Unexpected result: expected %d, found %d\n",
+		   READOSM_OK, ret);
+	  return -48;
+      }
+    if (count.nodes != 1060 || count.nd_tags != 1052 || count.ways != 112
+	|| count.way_nds != 785 || count.way_tags != 241
+	|| count.relations != 13 || count.rel_members != 66
+	|| count.rel_tags != 199)
+      {
+	  fprintf (stderr,
+		   "XML-MMAP: unexpected results: expected 1060/1052/112/785/241/13/66/19, found %d/%d/%d/%d/%d/%d/%d/%d\n",
+		   count.nodes, count.nd_tags, count.ways, count.way_nds,
+		   count.way_tags, count.relations, count.rel_members,
+		   count.rel_tags);
+	  return -49;
+      }
+
+    ret = readosm_close (handle);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "CLOSE ERROR: %d\n", ret);
+	  return -50;
+      }
+
+    ret = readosm_open_ex ("testdata/test.osm.pbf", &handle, READOSM_MMAP);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR: %d\n", ret);
+	  return -51;
+      }
+
+    zero_count (&count);
+    ret = readosm_parse (handle, &count, parse_node, parse_way, parse_relation);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "Unexpected result: expected %d, found %d\n",
+		   READOSM_OK, ret);
+	  return -52;
+      }
+    if (count.nodes != 8000 || count.nd_tags != 3162 || count.ways != 12336
+	|| count.way_nds != 221627 || count.way_tags != 24904
+	|| count.relations != 1520 || count.rel_members != 5723
+	|| count.rel_tags != 10081)
+      {
+	  fprintf (stderr,
+		   "PBF-MMAP: unexpected results: expected 8000/3162/12336/221627/24904/1520/5723/10081, found %d/%d/%d/%d/%d/%d/%d/%d\n",
+		   count.nodes, count.nd_tags, count.ways, count.way_nds,
+		   count.way_tags, count.relations, count.rel_members,
+		   count.rel_tags);
+	  return -53;
+      }
+
+    ret = readosm_close (handle);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "CLOSE ERROR: %d\n", ret);
+	  return -54;
+      }
+
+/* the zlib reference, inflated by libdeflate when available, then
+   zstd and lz4 compressed blocks (same contents as noNodesPackedInfos) */
+    ret = parse_count ("testdata/noNodesPackedInfos.osm.pbf", &ref_count);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, ".pbf PARSE error (zlib): %d\n", ret);
+	  return -55;
+      }
+    if (ref_count.nodes != 7947 || ref_count.nd_tags != 179
+	|| ref_count.ways != 923 || ref_count.way_nds != 9535
+	|| ref_count.way_tags != 1734 || ref_count.relations != 6
+	|| ref_count.rel_members != 22 || ref_count.rel_tags != 47)
+      {
+	  fprintf (stderr,
+		   "PBF-ZLIB: unexpected results: expected 7947/179/923/9535/1734/6/22/47, found %d/%d/%d/%d/%d/%d/%d/%d\n",
+		   ref_count.nodes, ref_count.nd_tags, ref_count.ways,
+		   ref_count.way_nds, ref_count.way_tags, ref_count.relations,
+		   ref_count.rel_members, ref_count.rel_tags);
+	  return -60;
+      }
+    ret = parse_count ("testdata/test-zstd.osm.pbf", &count);
+#ifdef HAVE_LIBZSTD
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, ".pbf PARSE error (zstd): %d\n", ret);
+	  return -56;
+      }
+    if (!same_count (&count, &ref_count))
+      {
+	  fprintf (stderr, "PBF-ZSTD: unexpected results\n");
+	  return -57;
+      }
+#else
+    if (ret != READOSM_UNSUPPORTED_BLOB)
+      {
+	  fprintf (stderr,
+		   "PBF-ZSTD: unexpected result: expected %d, found %d\n",
+		   READOSM_UNSUPPORTED_BLOB, ret);
+	  return -56;
+      }
+#endif
+    ret = parse_count ("testdata/test-lz4.osm.pbf", &count);
+#ifdef HAVE_LIBLZ4
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, ".pbf PARSE error (lz4): %d\n", ret);
+	  return -58;
+      }
+    if (!same_count (&count, &ref_count))
+      {
+	  fprintf (stderr, "PBF-LZ4: unexpected results\n");
+	  return -59;
+      }
+#else
+    if (ret != READOSM_UNSUPPORTED_BLOB)
+      {
+	  fprintf (stderr,
+		   "PBF-LZ4: unexpected result: expected %d, found %d\n",
+		   READOSM_UNSUPPORTED_BLOB, ret);
+	  return -58;
+      }
+#endif
+
+/* fixed-point coordinates: missing vs valid */
+    out = fopen ("check_err_fixed.osm", "wb");
+    if (out == NULL)
+      {
+	  fprintf (stderr, "unable to create check_err_fixed.osm\n");
+	  return -61;
+      }
+    fprintf (out, "<osm version=\"0.6\">\n<node id=\"1\"/>\n");
+    fprintf (out, "<node id=\"2\" lat=\"45.5\" lon=\"-123.456789\"/>\n");
+    fprintf (out, "</osm>\n");
+    fclose (out);
+    failed = 0;
+    ret = readosm_open ("check_err_fixed.osm", &handle);
+    if (ret == READOSM_OK)
+	ret = readosm_parse (handle, &failed, check_fixed_node, NULL, NULL);
+    readosm_close (handle);
+    remove ("check_err_fixed.osm");
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, ".osm PARSE error (fixed): %d\n", ret);
+	  return -62;
+      }
+    if (failed)
+      {
+	  fprintf (stderr, "XML-FIXED: unexpected fixed-point coordinates\n");
+	  return -63;
+      }
+
     return 0;
 }
@@ -0,0 +1,660 @@
+/* 
+/ check_index.c
+/
+/ Test cases for PBF block index
+/
+/ Author: the ReadOSM contributors, 2026
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the ReadOSM library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2012-2017
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/ 
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "readosm.h"
+
+struct osm_count
+{
+    int nodes;
+    int ways;
+    int relations;
+};
+
+static void
+zero_count (struct osm_count *cnt)
+{
+/* resetting the osm_count struct */
+    cnt->nodes = 0;
+    cnt->ways = 0;
+    cnt->relations = 0;
+}
+
+static int
+parse_node (const void *user_data, const readosm_node * node)
+{
+/* Node callback function */
+    struct osm_count *cnt = (struct osm_count *) user_data;
+    if (node->id == READOSM_UNDEFINED)
+	return READOSM_ABORT;
+    cnt->nodes++;
+    return READOSM_OK;
+}
+
+static int
+parse_way (const void *user_data, const readosm_way * way)
+{
+/* Way callback function */
+    struct osm_count *cnt = (struct osm_count *) user_data;
+    if (way->id == READOSM_UNDEFINED)
+	return READOSM_ABORT;
+    cnt->ways++;
+    return READOSM_OK;
+}
+
+static int
+parse_relation (const void *user_data, const readosm_relation * relation)
+{
+/* Relation callback function */
+    struct osm_count *cnt = (struct osm_count *) user_data;
+    if (relation->id == READOSM_UNDEFINED)
+	return READOSM_ABORT;
+    cnt->relations++;
+    return READOSM_OK;
+}
+
+static int
+check_index (const readosm_block * blocks, int count, long long file_size)
+{
+/* checking the block index for consistency */
+    int i;
+    if (count <= 0 || blocks == NULL)
+	return 0;
+    if (blocks->file_offset <= 0)
+	return 0;		/* the OSMHeader block isn't indexed */
+    for (i = 0; i < count; i++)
+      {
+	  const readosm_block *blk = blocks + i;
+	  long long end =
+	      blk->file_offset + 4 + blk->header_size + blk->datasize;
+	  if (blk->header_size == 0 || blk->datasize == 0)
+	      return 0;
+	  if (i < count - 1 && end != (blk + 1)->file_offset)
+	      return 0;
+	  if (i == count - 1 && end != file_size)
+	      return 0;
+      }
+    return 1;
+}
+
+static int
+test_index (int options, int base)
+{
+/* building the block index, then parsing the whole file */
+    const void *handle;
+    const readosm_block *blocks;
+    int count;
+    int ret;
+    struct osm_count cnt;
+
+    ret = readosm_open_ex ("testdata/test.osm.pbf", &handle, options);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR #%d: %d\n", base, ret);
+	  return base - 1;
+      }
+
+    ret = readosm_build_block_index (handle, &blocks, &count);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "INDEX ERROR #%d: %d\n", base, ret);
+	  return base - 2;
+      }
+    if (!check_index (blocks, count, 575483))
+      {
+	  fprintf (stderr, "INDEX #%d: inconsistent block index\n", base);
+	  return base - 3;
+      }
+
+/* the read position is expected to be unchanged */
+    zero_count (&cnt);
+    ret = readosm_parse (handle, &cnt, parse_node, parse_way, parse_relation);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "PARSE ERROR #%d: %d\n", base, ret);
+	  return base - 4;
+      }
+    if (cnt.nodes != 8000 || cnt.ways != 12336 || cnt.relations != 1520)
+      {
+	  fprintf (stderr,
+		   "INDEX #%d: unexpected results: expected 8000/12336/1520, found %d/%d/%d\n",
+		   base, cnt.nodes, cnt.ways, cnt.relations);
+	  return base - 5;
+      }
+
+    ret = readosm_close (handle);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "CLOSE ERROR #%d: %d\n", base, ret);
+	  return base - 6;
+      }
+    return 0;
+}
+
+static int
+test_ranges (int options, int base)
+{
+/* parsing the whole file by three adjacent byte ranges */
+    const void *handle;
+    int ret;
+    struct osm_count cnt;
+    long long split1 = 575483 / 3;
+    long long split2 = split1 * 2;
+
+    ret = readosm_open_ex ("testdata/test.osm.pbf", &handle, options);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR #%d: %d\n", base, ret);
+	  return base - 1;
+      }
+
+    zero_count (&cnt);
+    ret =
+	readosm_parse_range (handle, split1, split2, &cnt, parse_node,
+			     parse_way, parse_relation);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "RANGE ERROR #%d: %d\n", base, ret);
+	  return base - 2;
+      }
+    if (cnt.nodes + cnt.ways + cnt.relations == 0)
+      {
+	  fprintf (stderr, "RANGE #%d: unexpected empty range\n", base);
+	  return base - 3;
+      }
+    ret =
+	readosm_parse_range (handle, 0, split1, &cnt, parse_node, parse_way,
+			     parse_relation);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "RANGE ERROR #%d: %d\n", base, ret);
+	  return base - 4;
+      }
+    ret =
+	readosm_parse_range (handle, split2, -1, &cnt, parse_node, parse_way,
+			     parse_relation);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "RANGE ERROR #%d: %d\n", base, ret);
+	  return base - 5;
+      }
+    if (cnt.nodes != 8000 || cnt.ways != 12336 || cnt.relations != 1520)
+      {
+	  fprintf (stderr,
+		   "RANGE #%d: unexpected results: expected 8000/12336/1520, found %d/%d/%d\n",
+		   base, cnt.nodes, cnt.ways, cnt.relations);
+	  return base - 6;
+      }
+
+    ret = readosm_close (handle);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "CLOSE ERROR #%d: %d\n", base, ret);
+	  return base - 7;
+      }
+    return 0;
+}
+
+static int
+copy_file (const char *src, const char *dst)
+{
+/* copying a file */
+    char buf[8192];
+    size_t rd;
+    FILE *in;
+    FILE *out;
+    in = fopen (src, "rb");
+    if (in == NULL)
+	return 0;
+    out = fopen (dst, "wb");
+    if (out == NULL)
+      {
+	  fclose (in);
+	  return 0;
+      }
+    while ((rd = fread (buf, 1, sizeof (buf), in)) > 0)
+	fwrite (buf, 1, rd, out);
+    fclose (in);
+    fclose (out);
+    return 1;
+}
+
+static int
+test_sidecar (void)
+{
+/* writing and then reloading the .pbf.idx sidecar file */
+    const void *handle;
+    const readosm_block *blocks;
+    const readosm_block *blk;
+    int count;
+    int i;
+    int ret;
+    int types = 0;
+    struct osm_count cnt;
+
+    if (!copy_file ("testdata/test.osm.pbf", "check_index.osm.pbf"))
+      {
+	  fprintf (stderr, "unable to copy the test file\n");
+	  return -51;
+      }
+    remove ("check_index.osm.pbf.idx");
+
+    ret = readosm_open ("check_index.osm.pbf", &handle);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR #5: %d\n", ret);
+	  return -52;
+      }
+    ret = readosm_write_block_index (handle);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "WRITE INDEX ERROR: %d\n", ret);
+	  return -53;
+      }
+    readosm_close (handle);
+
+    ret = readosm_open ("check_index.osm.pbf", &handle);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR #6: %d\n", ret);
+	  return -54;
+      }
+    ret = readosm_build_block_index (handle, &blocks, &count);
+    if (ret != READOSM_OK || !check_index (blocks, count, 575483))
+      {
+	  fprintf (stderr, "INDEX ERROR #6: %d\n", ret);
+	  return -55;
+      }
+    for (i = 0; i < count; i++)
+      {
+	  blk = blocks + i;
+	  if (blk->object_types == 0 || blk->min_id > blk->max_id)
+	    {
+		fprintf (stderr, "INDEX #6: block %d lacks object details\n",
+			 i);
+		return -56;
+	    }
+	  types |= blk->object_types;
+      }
+    if (types !=
+	(READOSM_BLOCK_NODES | READOSM_BLOCK_WAYS | READOSM_BLOCK_RELATIONS))
+      {
+	  fprintf (stderr, "INDEX #6: unexpected object types %d\n", types);
+	  return -57;
+      }
+
+/* parsing all Ways by using the sidecar index */
+    zero_count (&cnt);
+    for (i = 0; i < count; i++)
+      {
+	  blk = blocks + i;
+	  if (!(blk->object_types & READOSM_BLOCK_WAYS))
+	      continue;
+	  ret =
+	      readosm_parse_range (handle, blk->file_offset,
+				   blk->file_offset + 1, &cnt, parse_node,
+				   parse_way, parse_relation);
+	  if (ret != READOSM_OK)
+	    {
+		fprintf (stderr, "RANGE ERROR #6: %d\n", ret);
+		return -58;
+	    }
+      }
+    if (cnt.ways != 12336)
+      {
+	  fprintf (stderr,
+		   "INDEX #6: unexpected results: expected 12336 ways, found %d\n",
+		   cnt.ways);
+	  return -59;
+      }
+    readosm_close (handle);
+
+/* a stale sidecar file is expected to be ignored */
+    copy_file ("testdata/noNodesPackedInfos.osm.pbf", "check_index.osm.pbf");
+    ret = readosm_open ("check_index.osm.pbf", &handle);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR #7: %d\n", ret);
+	  return -60;
+      }
+    ret = readosm_build_block_index (handle, &blocks, &count);
+    if (ret != READOSM_OK || count <= 0 || blocks->object_types != 0)
+      {
+	  fprintf (stderr, "INDEX ERROR #7: stale sidecar file loaded\n");
+	  return -61;
+      }
+    readosm_close (handle);
+
+    remove ("check_index.osm.pbf");
+    remove ("check_index.osm.pbf.idx");
+    return 0;
+}
+
+static int
+test_sorted (int options, int base)
+{
+/* 
+ / parsing a Type_then_ID sorted file by requesting only
+ / some object types: unwanted blocks can be skipped
+*/
+    const void *handle;
+    int ret;
+    int i;
+    struct osm_count cnt;
+    const readosm_header *header;
+
+    for (i = 0; i < 8; i++)
+      {
+	  int nodes = (i & 1) ? 7947 : 0;
+	  int ways = (i & 2) ? 923 : 0;
+	  int relations = (i & 4) ? 6 : 0;
+
+	  ret =
+	      readosm_open_ex ("testdata/test-sorted.osm.pbf", &handle,
+			       options);
+	  if (ret != READOSM_OK)
+	    {
+		fprintf (stderr, "OPEN ERROR #%d: %d\n", base, ret);
+		return base - 1;
+	    }
+	  ret = readosm_get_header (handle, &header);
+	  if (ret != READOSM_OK || !header->sorted)
+	    {
+		fprintf (stderr, "SORTED #%d: unexpected header\n", base);
+		return base - 2;
+	    }
+
+	  zero_count (&cnt);
+	  ret = readosm_parse (handle, &cnt, (i & 1) ? parse_node : NULL,
+			       (i & 2) ? parse_way : NULL,
+			       (i & 4) ? parse_relation : NULL);
+	  if (ret != READOSM_OK)
+	    {
+		fprintf (stderr, "PARSE ERROR #%d: %d\n", base, ret);
+		return base - 3;
+	    }
+	  if (cnt.nodes != nodes || cnt.ways != ways
+	      || cnt.relations != relations)
+	    {
+		fprintf (stderr,
+			 "SORTED #%d: unexpected results: expected %d/%d/%d, found %d/%d/%d\n",
+			 base, nodes, ways, relations, cnt.nodes, cnt.ways,
+			 cnt.relations);
+		return base - 4;
+	    }
+
+	  ret = readosm_close (handle);
+	  if (ret != READOSM_OK)
+	    {
+		fprintf (stderr, "CLOSE ERROR #%d: %d\n", base, ret);
+		return base - 5;
+	    }
+      }
+    return 0;
+}
+
+struct sorted_block
+{
+    long long file_offset;
+    unsigned int header_size;
+    unsigned int datasize;
+};
+
+static int
+corrupt_blocks (const char *path, const struct sorted_block *blocks,
+		int first, int last)
+{
+/* overwriting the Blobs of blocks [first, last) with garbage */
+    int i;
+    unsigned int j;
+    FILE *out = fopen (path, "r+b");
+    if (out == NULL)
+	return 0;
+    for (i = first; i < last; i++)
+      {
+	  const struct sorted_block *blk = blocks + i;
+	  if (fseek
+	      (out, (long) (blk->file_offset + 4 + blk->header_size),
+	       SEEK_SET) != 0)
+	    {
+		fclose (out);
+		return 0;
+	    }
+	  for (j = 0; j < blk->datasize; j++)
+	      fputc (0xff, out);
+      }
+    fclose (out);
+    return 1;
+}
+
+static int
+parse_corrupted (const char *path, int options, struct osm_count *cnt,
+		 int nodes, int ways, int relations)
+{
+/* parsing a partially corrupted copy of the sorted file */
+    const void *handle;
+    int ret = readosm_open_ex (path, &handle, options);
+    zero_count (cnt);
+    if (ret == READOSM_OK)
+	ret =
+	    readosm_parse (handle, cnt, nodes ? parse_node : NULL,
+			   ways ? parse_way : NULL,
+			   relations ? parse_relation : NULL);
+    readosm_close (handle);
+    return ret;
+}
+
+static int
+test_sorted_skip (int options, int base)
+{
+/* 
+ / a Type_then_ID sorted file whose unneeded blocks are corrupted:
+ / the parse is expected to succeed only if those blocks are really
+ / skipped (leading NODE blocks) or never read (trailing blocks)
+ /
+ / the binary search locating the first WAY block never probes
+ / the first half of the NODE blocks, and parsing stops after
+ / decoding the first block past the last wanted object type
+*/
+    const void *handle;
+    const readosm_block *blocks;
+    struct sorted_block sorted[64];
+    struct osm_count cnt;
+    int count;
+    int i;
+    int ret;
+    int nodes_end = -1;
+    int ways_end = -1;
+    const char *path = "check_sorted.osm.pbf";
+
+/* locating the NODE, WAY and RELATION blocks */
+    if (!copy_file ("testdata/test-sorted.osm.pbf", path))
+      {
+	  fprintf (stderr, "SKIP #%d: unable to copy the file\n", base);
+	  return base - 1;
+      }
+    ret = readosm_open_ex (path, &handle, options);
+    if (ret == READOSM_OK)
+	ret = readosm_write_block_index (handle);
+    if (ret == READOSM_OK)
+	ret = readosm_build_block_index (handle, &blocks, &count);
+    if (ret != READOSM_OK || count > 64)
+      {
+	  fprintf (stderr, "INDEX ERROR #%d: %d\n", base, ret);
+	  return base - 2;
+      }
+    for (i = 0; i < count; i++)
+      {
+	  sorted[i].file_offset = blocks[i].file_offset;
+	  sorted[i].header_size = blocks[i].header_size;
+	  sorted[i].datasize = blocks[i].datasize;
+	  if (nodes_end < 0 && !(blocks[i].object_types & READOSM_BLOCK_NODES))
+	      nodes_end = i;
+	  if (ways_end < 0 && (blocks[i].object_types & READOSM_BLOCK_RELATIONS))
+	      ways_end = i;
+      }
+    readosm_close (handle);
+    remove ("check_sorted.osm.pbf.idx");
+    if (nodes_end < 4 || ways_end < nodes_end + 2 || count < ways_end + 2)
+      {
+	  fprintf (stderr, "SKIP #%d: unexpected block layout\n", base);
+	  return base - 3;
+      }
+
+/* NODEs only: every block past the first WAY block is corrupted */
+    if (!copy_file ("testdata/test-sorted.osm.pbf", path)
+	|| !corrupt_blocks (path, sorted, nodes_end + 1, count))
+      {
+	  fprintf (stderr, "SKIP #%d: unable to corrupt the file\n", base);
+	  return base - 4;
+      }
+    ret = parse_corrupted (path, options, &cnt, 1, 1, 1);
+    if (ret == READOSM_OK)
+      {
+	  fprintf (stderr, "SKIP #%d: corrupted blocks not detected\n", base);
+	  return base - 5;
+      }
+    ret = parse_corrupted (path, options, &cnt, 1, 0, 0);
+    if (ret != READOSM_OK || cnt.nodes != 7947)
+      {
+	  fprintf (stderr, "SKIP #%d: NODEs only: %d (%d nodes)\n", base,
+		   ret, cnt.nodes);
+	  return base - 6;
+      }
+
+/* WAYs only: leading NODE and trailing RELATION blocks are corrupted */
+    if (!copy_file ("testdata/test-sorted.osm.pbf", path)
+	|| !corrupt_blocks (path, sorted, 0, nodes_end / 2)
+	|| !corrupt_blocks (path, sorted, ways_end + 1, count))
+      {
+	  fprintf (stderr, "SKIP #%d: unable to corrupt the file\n", base);
+	  return base - 7;
+      }
+    ret = parse_corrupted (path, options, &cnt, 0, 1, 1);
+    if (ret == READOSM_OK)
+      {
+	  fprintf (stderr, "SKIP #%d: corrupted blocks not detected\n", base);
+	  return base - 8;
+      }
+    ret = parse_corrupted (path, options, &cnt, 0, 1, 0);
+    if (ret != READOSM_OK || cnt.ways != 923)
+      {
+	  fprintf (stderr, "SKIP #%d: WAYs only: %d (%d ways)\n", base, ret,
+		   cnt.ways);
+	  return base - 9;
+      }
+
+    remove (path);
+    return 0;
+}
+
+int
+main (int argc, char *argv[])
+{
+    const void *handle;
+    const readosm_block *blocks;
+    int count;
+    int ret;
+
+    if (argc < 0 || argv == NULL)
+	argc = 0;		/* silencing stupid compiler warnings */
+
+    ret = test_index (0, 0);
+    if (ret != 0)
+	return ret;
+    ret = test_index (READOSM_MMAP, -10);
+    if (ret != 0)
+	return ret;
+
+    ret = test_ranges (0, -30);
+    if (ret != 0)
+	return ret;
+    ret = test_ranges (READOSM_MMAP, -40);
+    if (ret != 0)
+	return ret;
+
+    ret = test_sidecar ();
+    if (ret != 0)
+	return ret;
+
+    ret = test_sorted (0, -70);
+    if (ret != 0)
+	return ret;
+    ret = test_sorted (READOSM_MMAP, -80);
+    if (ret != 0)
+	return ret;
+    ret = test_sorted_skip (0, -90);
+    if (ret != 0)
+	return ret;
+    ret = test_sorted_skip (READOSM_MMAP, -100);
+    if (ret != 0)
+	return ret;
+
+    ret = readosm_build_block_index (NULL, &blocks, &count);
+    if (ret != READOSM_NULL_HANDLE)
+      {
+	  fprintf (stderr, "Unexpected result: expected %d, found %d\n",
+		   READOSM_NULL_HANDLE, ret);
+	  return -21;
+      }
+
+    ret = readosm_open ("testdata/test.osm", &handle);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR #3: %d\n", ret);
+	  return -22;
+      }
+    ret = readosm_build_block_index (handle, &blocks, &count);
+    if (ret != READOSM_INVALID_PBF_HEADER || blocks != NULL || count != 0)
+      {
+	  fprintf (stderr, "Unexpected result: expected %d, found %d\n",
+		   READOSM_INVALID_PBF_HEADER, ret);
+	  return -23;
+      }
+    readosm_close (handle);
+
+    return 0;
+}
@@ -0,0 +1,296 @@
+/* 
+/ check_mt.c
+/
+/ Test cases for multi-threaded parsing
+/
+/ Author: the ReadOSM contributors, 2026
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the ReadOSM library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2012-2017
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/ 
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+#include <stdio.h>
+#include <string.h>
+
+#include "readosm.h"
+
+struct osm_digest
+{
+    int nodes;
+    int ways;
+    int way_nds;
+    int relations;
+    int rel_tags;
+    unsigned long long hash;	/* order-dependent checksum */
+    int limit;			/* aborting after so many objects (if > 0) */
+};
+
+static void
+zero_digest (struct osm_digest *dgst, int limit)
+{
+/* resetting the osm_digest struct */
+    dgst->nodes = 0;
+    dgst->ways = 0;
+    dgst->way_nds = 0;
+    dgst->relations = 0;
+    dgst->rel_tags = 0;
+    dgst->hash = 0;
+    dgst->limit = limit;
+}
+
+static int
+update_digest (struct osm_digest *dgst, long long id)
+{
+/* updating the order-dependent checksum */
+    dgst->hash = (dgst->hash * 1099511628211ULL) ^ (unsigned long long) id;
+    if (dgst->limit > 0
+	&& dgst->nodes + dgst->ways + dgst->relations >= dgst->limit)
+	return READOSM_ABORT;
+    return READOSM_OK;
+}
+
+static int
+parse_node (const void *user_data, const readosm_node * node)
+{
+/* Node callback function */
+    struct osm_digest *dgst = (struct osm_digest *) user_data;
+    dgst->nodes++;
+    return update_digest (dgst, node->id);
+}
+
+static int
+parse_way (const void *user_data, const readosm_way * way)
+{
+/* Way callback function */
+    struct osm_digest *dgst = (struct osm_digest *) user_data;
+    dgst->ways++;
+    dgst->way_nds += way->node_ref_count;
+    if (way->node_ref_count > 0)
+	update_digest (dgst, *(way->node_refs + way->node_ref_count - 1));
+    return update_digest (dgst, way->id);
+}
+
+static int
+parse_relation (const void *user_data, const readosm_relation * relation)
+{
+/* Relation callback function */
+    struct osm_digest *dgst = (struct osm_digest *) user_data;
+    dgst->relations++;
+    dgst->rel_tags += relation->tag_count;
+    return update_digest (dgst, relation->id);
+}
+
+static int
+parse_serial (const char *path, struct osm_digest *dgst)
+{
+/* parsing the whole file by a single thread */
+    const void *handle;
+    int ret = readosm_open (path, &handle);
+    if (ret == READOSM_OK)
+	ret =
+	    readosm_parse (handle, dgst, parse_node, parse_way,
+			   parse_relation);
+    readosm_close (handle);
+    return ret;
+}
+
+static const void *
+digest_factory (const void *factory_data, int thread_index)
+{
+/* returning the per-thread osm_digest struct */
+    struct osm_digest *dgst = (struct osm_digest *) factory_data;
+    return dgst + thread_index;
+}
+
+int
+main (int argc, char *argv[])
+{
+    const void *handle;
+    int ret;
+    struct osm_digest serial;
+    struct osm_digest count;
+    struct osm_digest per_thread[4];
+    int i;
+
+    if (argc < 0 || argv == NULL)
+	argc = 0;		/* silencing stupid compiler warnings */
+
+    zero_digest (&serial, 0);
+    ret = parse_serial ("testdata/test.osm.pbf", &serial);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, ".pbf PARSE error #1: %d\n", ret);
+	  return -1;
+      }
+
+    ret = readosm_open ("testdata/test.osm.pbf", &handle);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR #2: %d\n", ret);
+	  return -2;
+      }
+
+    zero_digest (&count, 0);
+    ret =
+	readosm_parse_mt (handle, &count, parse_node, parse_way,
+			  parse_relation, 4);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, ".pbf PARSE-MT error #2: %d\n", ret);
+	  return -3;
+      }
+    if (count.nodes != 8000 || count.ways != 12336
+	|| count.way_nds != 221627 || count.relations != 1520
+	|| count.rel_tags != 10081 || count.hash != serial.hash)
+      {
+	  fprintf (stderr,
+		   "PBF-MT: unexpected results: expected 8000/12336/221627/1520/10081/%llx, found %d/%d/%d/%d/%d/%llx\n",
+		   serial.hash, count.nodes, count.ways, count.way_nds,
+		   count.relations, count.rel_tags, count.hash);
+	  return -4;
+      }
+
+    ret = readosm_close (handle);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "CLOSE ERROR #2: %d\n", ret);
+	  return -5;
+      }
+
+    ret = readosm_open_ex ("testdata/test.osm.pbf", &handle, READOSM_MMAP);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR #3: %d\n", ret);
+	  return -6;
+      }
+
+    zero_digest (&count, 10000);
+    ret =
+	readosm_parse_mt (handle, &count, parse_node, parse_way,
+			  parse_relation, 3);
+    if (ret != READOSM_ABORT)
+      {
+	  fprintf (stderr, "Unexpected result: expected %d, found %d\n",
+		   READOSM_ABORT, ret);
+	  return -7;
+      }
+    if (count.nodes != 8000 || count.ways != 2000 || count.relations != 0)
+      {
+	  fprintf (stderr,
+		   "PBF-MT-ABORT: unexpected results: expected 8000/2000/0, found %d/%d/%d\n",
+		   count.nodes, count.ways, count.relations);
+	  return -8;
+      }
+
+    ret = readosm_close (handle);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "CLOSE ERROR #3: %d\n", ret);
+	  return -9;
+      }
+
+    ret = readosm_open ("testdata/test.osm.pbf", &handle);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR #4: %d\n", ret);
+	  return -10;
+      }
+
+    for (i = 0; i < 4; i++)
+	zero_digest (per_thread + i, 0);
+    ret =
+	readosm_parse_parallel (handle, digest_factory, per_thread,
+				parse_node, parse_way, parse_relation, 4);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, ".pbf PARSE-PARALLEL error #4: %d\n", ret);
+	  return -11;
+      }
+    zero_digest (&count, 0);
+    for (i = 0; i < 4; i++)
+      {
+	  count.nodes += per_thread[i].nodes;
+	  count.ways += per_thread[i].ways;
+	  count.way_nds += per_thread[i].way_nds;
+	  count.relations += per_thread[i].relations;
+	  count.rel_tags += per_thread[i].rel_tags;
+      }
+    if (count.nodes != 8000 || count.ways != 12336
+	|| count.way_nds != 221627 || count.relations != 1520
+	|| count.rel_tags != 10081)
+      {
+	  fprintf (stderr,
+		   "PBF-PARALLEL: unexpected results: expected 8000/12336/221627/1520/10081, found %d/%d/%d/%d/%d\n",
+		   count.nodes, count.ways, count.way_nds, count.relations,
+		   count.rel_tags);
+	  return -12;
+      }
+
+    ret = readosm_close (handle);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "CLOSE ERROR #4: %d\n", ret);
+	  return -13;
+      }
+
+    ret = readosm_open ("testdata/test.osm.pbf", &handle);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR #5: %d\n", ret);
+	  return -14;
+      }
+
+    for (i = 0; i < 4; i++)
+	zero_digest (per_thread + i, 100);
+    ret =
+	readosm_parse_parallel (handle, digest_factory, per_thread,
+				parse_node, parse_way, parse_relation, 4);
+    if (ret != READOSM_ABORT)
+      {
+	  fprintf (stderr, "Unexpected result: expected %d, found %d\n",
+		   READOSM_ABORT, ret);
+	  return -15;
+      }
+
+    ret = readosm_close (handle);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "CLOSE ERROR #5: %d\n", ret);
+	  return -16;
+      }
+
+    return 0;
+}
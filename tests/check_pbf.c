@@ -43,6 +43,7 @@
 */
 
 #include <stdio.h>
+#include <string.h>
 
 #include "readosm.h"
 
@@ -73,11 +74,452 @@ check_relation (const void *user_data, const readosm_relation * relation)
     return READOSM_OK;
 }
 
+static int
+unset (long long value)
+{
+/* checking for an unset metadata value (PBF Ways/Relations default to 0) */
+    return (value == READOSM_UNDEFINED || value == 0);
+}
+
+static int
+check_bare_node (const void *user_data, const readosm_node * node)
+{
+/* Node callback function: no metadata is expected at all */
+    int *count = (int *) user_data;
+    if (node->version != READOSM_UNDEFINED
+	|| node->changeset != READOSM_UNDEFINED
+	|| node->uid != READOSM_UNDEFINED || node->user != NULL
+	|| node->timestamp != NULL)
+	return READOSM_ABORT;
+    *count += 1;
+    return READOSM_OK;
+}
+
+static int
+check_bare_way (const void *user_data, const readosm_way * way)
+{
+/* Way callback function: no metadata is expected at all */
+    int *count = (int *) user_data;
+    if (!unset (way->version) || !unset (way->changeset)
+	|| !unset (way->uid) || way->user != NULL || way->timestamp != NULL)
+	return READOSM_ABORT;
+    *count += 1;
+    return READOSM_OK;
+}
+
+static int
+check_bare_relation (const void *user_data,
+		     const readosm_relation * relation)
+{
+/* Relation callback function: no metadata is expected at all */
+    int *count = (int *) user_data;
+    if (!unset (relation->version) || !unset (relation->changeset)
+	|| !unset (relation->uid) || relation->user != NULL
+	|| relation->timestamp != NULL)
+	return READOSM_ABORT;
+    *count += 1;
+    return READOSM_OK;
+}
+
+struct timestamp_check
+{
+/* an helper struct supporting timestamp checks */
+    int lazy;
+    int count;
+};
+
+static int
+check_timestamp (const void *user_data, const char *timestamp,
+		 long long timestamp_epoch)
+{
+/* checking that the epoch value matches the timestamp string */
+    struct timestamp_check *check = (struct timestamp_check *) user_data;
+    char buf[READOSM_TIMESTAMP_SIZE];
+    if (timestamp_epoch == READOSM_UNDEFINED)
+	return READOSM_ABORT;
+    if (readosm_format_timestamp (timestamp_epoch, buf) != READOSM_OK)
+	return READOSM_ABORT;
+    if (check->lazy)
+      {
+	  if (timestamp != NULL)
+	      return READOSM_ABORT;
+      }
+    else if (timestamp == NULL || strcmp (timestamp, buf) != 0)
+	return READOSM_ABORT;
+    check->count += 1;
+    return READOSM_OK;
+}
+
+static int
+check_timestamp_node (const void *user_data, const readosm_node * node)
+{
+/* Node callback function: checking the timestamp */
+    return check_timestamp (user_data, node->timestamp, node->timestamp_epoch);
+}
+
+static int
+check_timestamp_way (const void *user_data, const readosm_way * way)
+{
+/* Way callback function: checking the timestamp */
+    return check_timestamp (user_data, way->timestamp, way->timestamp_epoch);
+}
+
+static int
+check_timestamp_relation (const void *user_data,
+			  const readosm_relation * relation)
+{
+/* Relation callback function: checking the timestamp */
+    return check_timestamp (user_data, relation->timestamp,
+			    relation->timestamp_epoch);
+}
+
+static int
+check_timestamps (const char *path, int options, int expected)
+{
+/* parsing a whole file, checking all timestamps */
+    const void *handle;
+    struct timestamp_check check;
+    int ret;
+
+    check.lazy = (options & READOSM_LAZY_TIMESTAMPS) ? 1 : 0;
+    check.count = 0;
+    ret = readosm_open_ex (path, &handle, options);
+    if (ret == READOSM_OK)
+	ret =
+	    readosm_parse (handle, &check, check_timestamp_node,
+			   check_timestamp_way, check_timestamp_relation);
+    readosm_close (handle);
+    if (ret != READOSM_OK || check.count != expected)
+      {
+	  fprintf (stderr, "%s timestamps (options=%d): %d (%d objects)\n",
+		   path, options, ret, check.count);
+	  return 0;
+      }
+    return 1;
+}
+
+static int
+differs (double value, double expected)
+{
+/* checking if two coordinates differ */
+    double diff = value - expected;
+    return (diff > 1e-9 || diff < -1e-9);
+}
+
+struct coords_check
+{
+/* an helper struct supporting granularity checks */
+    long long lat_sum;
+    long long lon_sum;
+    long long timestamp_sum;
+    int count;
+};
+
+static int
+check_coords_node (const void *user_data, const readosm_node * node)
+{
+/* Node callback function: summing up fixed-point coordinates */
+    struct coords_check *check = (struct coords_check *) user_data;
+    if (differs (node->latitude, node->fixed_latitude / 10000000.0)
+	|| differs (node->longitude, node->fixed_longitude / 10000000.0))
+	return READOSM_ABORT;
+    check->lat_sum += node->fixed_latitude;
+    check->lon_sum += node->fixed_longitude;
+    check->timestamp_sum += node->timestamp_epoch;
+    check->count += 1;
+    return READOSM_OK;
+}
+
+static int
+check_coords_way (const void *user_data, const readosm_way * way)
+{
+/* Way callback function: summing up timestamps */
+    struct coords_check *check = (struct coords_check *) user_data;
+    check->timestamp_sum += way->timestamp_epoch;
+    check->count += 1;
+    return READOSM_OK;
+}
+
+static int
+check_coords_relation (const void *user_data,
+		       const readosm_relation * relation)
+{
+/* Relation callback function: summing up timestamps */
+    struct coords_check *check = (struct coords_check *) user_data;
+    check->timestamp_sum += relation->timestamp_epoch;
+    check->count += 1;
+    return READOSM_OK;
+}
+
+static int
+check_coords (const char *path, struct coords_check *check)
+{
+/* parsing a whole file, summing up coordinates and timestamps */
+    const void *handle;
+    int ret;
+
+    check->lat_sum = 0;
+    check->lon_sum = 0;
+    check->timestamp_sum = 0;
+    check->count = 0;
+    ret = readosm_open_ex (path, &handle, READOSM_LAZY_TIMESTAMPS);
+    if (ret == READOSM_OK)
+	ret =
+	    readosm_parse (handle, check, check_coords_node,
+			   check_coords_way, check_coords_relation);
+    readosm_close (handle);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "%s coordinates: %d\n", path, ret);
+	  return 0;
+      }
+    return 1;
+}
+
+struct batch_check
+{
+/* an helper struct supporting batch checks */
+    long long id_sum;
+    long long ref_sum;
+    long long tag_sum;
+    int count;
+    int batches;
+};
+
+static void
+sum_tags (struct batch_check *check, int tag_count,
+	  const readosm_tag * tags)
+{
+/* summing up the length of all TAGs */
+    int i;
+    for (i = 0; i < tag_count; i++)
+	check->tag_sum +=
+	    strlen (tags[i].key) * 3 + strlen (tags[i].value);
+}
+
+static int
+sum_node (const void *user_data, const readosm_node * node)
+{
+/* Node callback function: summing up ids and tags */
+    struct batch_check *check = (struct batch_check *) user_data;
+    check->id_sum += node->id + node->fixed_latitude + node->version;
+    sum_tags (check, node->tag_count, node->tags);
+    check->count += 1;
+    return READOSM_OK;
+}
+
+static int
+sum_way (const void *user_data, const readosm_way * way)
+{
+/* Way callback function: summing up ids, node-refs and tags */
+    struct batch_check *check = (struct batch_check *) user_data;
+    int i;
+    check->id_sum += way->id + way->version;
+    for (i = 0; i < way->node_ref_count; i++)
+	check->ref_sum += way->node_refs[i] * (i + 1);
+    sum_tags (check, way->tag_count, way->tags);
+    check->count += 1;
+    return READOSM_OK;
+}
+
+static int
+sum_relation (const void *user_data, const readosm_relation * relation)
+{
+/* Relation callback function: summing up ids, members and tags */
+    struct batch_check *check = (struct batch_check *) user_data;
+    int i;
+    check->id_sum += relation->id + relation->version;
+    for (i = 0; i < relation->member_count; i++)
+      {
+	  const readosm_member *member = relation->members + i;
+	  check->ref_sum +=
+	      member->id * (i + 1) + member->member_type +
+	      strlen (member->role);
+      }
+    sum_tags (check, relation->tag_count, relation->tags);
+    check->count += 1;
+    return READOSM_OK;
+}
+
+static int
+sum_node_batch (const void *user_data, const readosm_node * nodes,
+		int count)
+{
+/* Node batch callback function */
+    int i;
+    ((struct batch_check *) user_data)->batches += 1;
+    for (i = 0; i < count; i++)
+	sum_node (user_data, nodes + i);
+    return READOSM_OK;
+}
+
+static int
+sum_way_batch (const void *user_data, const readosm_way * ways, int count)
+{
+/* Way batch callback function */
+    int i;
+    ((struct batch_check *) user_data)->batches += 1;
+    for (i = 0; i < count; i++)
+	sum_way (user_data, ways + i);
+    return READOSM_OK;
+}
+
+static int
+sum_relation_batch (const void *user_data,
+		    const readosm_relation * relations, int count)
+{
+/* Relation batch callback function */
+    int i;
+    ((struct batch_check *) user_data)->batches += 1;
+    for (i = 0; i < count; i++)
+	sum_relation (user_data, relations + i);
+    return READOSM_OK;
+}
+
+static int
+abort_way_batch (const void *user_data, const readosm_way * ways, int count)
+{
+/* Way batch callback function: always aborting */
+    if (user_data != NULL || ways == NULL || count == 0)
+	user_data = NULL;	/* silencing stupid compiler warnings */
+    return READOSM_ABORT;
+}
+
+static int
+check_batches (const char *path)
+{
+/* parsing a whole file twice, both per-object and as batches */
+    const void *handle;
+    struct batch_check check1;
+    struct batch_check check2;
+    int ret;
+
+    memset (&check1, 0, sizeof (struct batch_check));
+    memset (&check2, 0, sizeof (struct batch_check));
+    ret = readosm_open (path, &handle);
+    if (ret == READOSM_OK)
+	ret = readosm_parse (handle, &check1, sum_node, sum_way, sum_relation);
+    readosm_close (handle);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "%s objects: %d\n", path, ret);
+	  return 0;
+      }
+    ret = readosm_open (path, &handle);
+    if (ret == READOSM_OK)
+	ret =
+	    readosm_parse_batches (handle, &check2, sum_node_batch,
+				   sum_way_batch, sum_relation_batch);
+    readosm_close (handle);
+    if (ret != READOSM_OK || check1.count != check2.count
+	|| check1.id_sum != check2.id_sum || check1.ref_sum != check2.ref_sum
+	|| check1.tag_sum != check2.tag_sum || check2.batches == 0)
+      {
+	  fprintf (stderr, "%s batches: %d (%d objects, %d batches)\n", path,
+		   ret, check2.count, check2.batches);
+	  return 0;
+      }
+
+/* an aborting batch callback */
+    ret = readosm_open (path, &handle);
+    if (ret == READOSM_OK)
+	ret =
+	    readosm_parse_batches (handle, NULL, NULL, abort_way_batch, NULL);
+    readosm_close (handle);
+    if (ret != READOSM_ABORT)
+      {
+	  fprintf (stderr, "%s aborted batches: %d\n", path, ret);
+	  return 0;
+      }
+    return 1;
+}
+
+static int
+sum_node_location (const void *user_data, const readosm_node * node)
+{
+/* Node callback function: summing up ids, coordinates and tags */
+    struct batch_check *check = (struct batch_check *) user_data;
+    check->id_sum += node->id;
+    check->ref_sum += node->fixed_latitude - node->fixed_longitude;
+    sum_tags (check, node->tag_count, node->tags);
+    check->count += 1;
+    return READOSM_OK;
+}
+
+static int
+sum_node_columns (const void *user_data, const readosm_node_columns * columns)
+{
+/* Node columns callback function: the same of sum_node_location */
+    struct batch_check *check = (struct batch_check *) user_data;
+    int i;
+    if (columns->count <= 0 || columns->tag_offsets[0] != 0)
+	return READOSM_ABORT;
+    check->batches += 1;
+    for (i = 0; i < columns->count; i++)
+      {
+	  int first = columns->tag_offsets[i];
+	  int tag_count = columns->tag_offsets[i + 1] - first;
+	  check->id_sum += columns->ids[i];
+	  check->ref_sum +=
+	      columns->fixed_latitudes[i] - columns->fixed_longitudes[i];
+	  if (tag_count < 0)
+	      return READOSM_ABORT;
+	  if (tag_count > 0)
+	      sum_tags (check, tag_count, columns->tags + first);
+	  check->count += 1;
+      }
+    return READOSM_OK;
+}
+
+static int
+check_columns (const char *path)
+{
+/* parsing a whole file twice, both per-object and as columns */
+    const void *handle;
+    struct batch_check check1;
+    struct batch_check check2;
+    int ret;
+
+    memset (&check1, 0, sizeof (struct batch_check));
+    memset (&check2, 0, sizeof (struct batch_check));
+    ret = readosm_open (path, &handle);
+    if (ret == READOSM_OK)
+	ret =
+	    readosm_parse (handle, &check1, sum_node_location, sum_way,
+			   sum_relation);
+    readosm_close (handle);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "%s objects: %d\n", path, ret);
+	  return 0;
+      }
+    ret = readosm_open (path, &handle);
+    if (ret == READOSM_OK)
+	ret =
+	    readosm_parse_columns (handle, &check2, sum_node_columns,
+				   sum_way_batch, sum_relation_batch);
+    readosm_close (handle);
+    if (ret != READOSM_OK || check1.count != check2.count
+	|| check1.id_sum != check2.id_sum || check1.ref_sum != check2.ref_sum
+	|| check1.tag_sum != check2.tag_sum || check2.batches == 0)
+      {
+	  fprintf (stderr, "%s columns: %d (%d objects, %d batches)\n", path,
+		   ret, check2.count, check2.batches);
+	  return 0;
+      }
+    return 1;
+}
+
 int
 main (int argc, char *argv[])
 {
     const void *handle;
+    const readosm_header *header;
     int ret;
+    int count;
+    char buf[READOSM_TIMESTAMP_SIZE];
+    struct coords_check check1;
+    struct coords_check check2;
 
     if (argc < 0 || argv == NULL)
 	argc = 0;		/* silencing stupid compiler warnings */
@@ -128,5 +570,215 @@ main (int argc, char *argv[])
 	  return -6;
       }
 
+    ret = readosm_open ("testdata/test.osm.pbf", &handle);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR #3: %d\n", ret);
+	  return -7;
+      }
+
+    ret = readosm_get_header (handle, &header);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, ".pbf HEADER error #3: %d\n", ret);
+	  return -8;
+      }
+    if (!header->has_bbox || differs (header->min_longitude, 8.317882)
+	|| differs (header->max_longitude, 9.751243)
+	|| differs (header->min_latitude, 41.31103)
+	|| differs (header->max_latitude, 43.16589))
+      {
+	  fprintf (stderr, ".pbf HEADER: unexpected bbox\n");
+	  return -9;
+      }
+    if (header->required_feature_count != 2
+	|| strcmp (header->required_features[0], "OsmSchema-V0.6") != 0
+	|| strcmp (header->required_features[1], "DenseNodes") != 0
+	|| header->optional_feature_count != 0)
+      {
+	  fprintf (stderr, ".pbf HEADER: unexpected features\n");
+	  return -10;
+      }
+    if (header->writing_program == NULL
+	|| strcmp (header->writing_program,
+		   "Osmium (http://wiki.openstreetmap.org/wiki/Osmium)") != 0
+	|| header->source != NULL)
+      {
+	  fprintf (stderr, ".pbf HEADER: unexpected writing program\n");
+	  return -11;
+      }
+    if (header->replication_timestamp != READOSM_UNDEFINED
+	|| header->replication_sequence != READOSM_UNDEFINED
+	|| header->replication_base_url != NULL || header->sorted
+	|| header->locations_on_ways)
+      {
+	  fprintf (stderr, ".pbf HEADER: unexpected replication infos\n");
+	  return -12;
+      }
+
+/* the HeaderBlock is not expected to affect parsing */
+    ret =
+	readosm_parse (handle, (const void *) 0, check_node, check_way,
+		       check_relation);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, ".pbf PARSE error #3: %d\n", ret);
+	  return -13;
+      }
+
+    ret = readosm_close (handle);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "CLOSE ERROR #3: %d\n", ret);
+	  return -14;
+      }
+
+    ret = readosm_open_ex ("testdata/noNodesPackedInfos.osm.pbf", &handle,
+			   READOSM_MMAP);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR #4: %d\n", ret);
+	  return -15;
+      }
+
+    ret = readosm_get_header (handle, &header);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, ".pbf HEADER error #4: %d\n", ret);
+	  return -16;
+      }
+    if (header->writing_program == NULL
+	|| strcmp (header->writing_program, "0.43.1") != 0
+	|| header->source == NULL
+	|| strcmp (header->source, "http://www.openstreetmap.org/api/0.6") != 0)
+      {
+	  fprintf (stderr, ".pbf HEADER: unexpected source\n");
+	  return -17;
+      }
+
+    ret = readosm_close (handle);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "CLOSE ERROR #4: %d\n", ret);
+	  return -18;
+      }
+
+    ret = readosm_open ("testdata/test.osm", &handle);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR #5: %d\n", ret);
+	  return -19;
+      }
+
+    ret = readosm_get_header (handle, &header);
+    if (ret != READOSM_INVALID_PBF_HEADER || header != NULL)
+      {
+	  fprintf (stderr, "Unexpected result: expected %d, found %d\n",
+		   READOSM_INVALID_PBF_HEADER, ret);
+	  return -20;
+      }
+
+    readosm_close (handle);
+
+/* parsing without metadata */
+    ret = readosm_open_ex ("testdata/test.osm.pbf", &handle,
+			   READOSM_SKIP_METADATA);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR #6: %d\n", ret);
+	  return -21;
+      }
+
+    count = 0;
+    ret =
+	readosm_parse (handle, &count, check_bare_node, check_bare_way,
+		       check_bare_relation);
+    if (ret != READOSM_OK || count != 8000 + 12336 + 1520)
+      {
+	  fprintf (stderr, ".pbf PARSE error #6: %d (%d objects)\n", ret,
+		   count);
+	  return -22;
+      }
+
+    readosm_close (handle);
+
+    ret = readosm_open_ex ("testdata/test.osm", &handle,
+			   READOSM_SKIP_METADATA);
+    if (ret != READOSM_OK)
+      {
+	  fprintf (stderr, "OPEN ERROR #7: %d\n", ret);
+	  return -23;
+      }
+
+    count = 0;
+    ret =
+	readosm_parse (handle, &count, check_bare_node, check_bare_way,
+		       check_bare_relation);
+    if (ret != READOSM_OK || count == 0)
+      {
+	  fprintf (stderr, ".osm PARSE error #7: %d (%d objects)\n", ret,
+		   count);
+	  return -24;
+      }
+
+    readosm_close (handle);
+
+/* numeric timestamps */
+    if (readosm_format_timestamp (1109612715, buf) != READOSM_OK
+	|| strcmp (buf, "2005-02-28T17:45:15Z") != 0)
+      {
+	  fprintf (stderr, "unexpected formatted timestamp: %s\n", buf);
+	  return -25;
+      }
+    if (readosm_format_timestamp (READOSM_UNDEFINED, buf) !=
+	READOSM_INVALID_TIMESTAMP || *buf != '\0')
+      {
+	  fprintf (stderr, "unexpected undefined timestamp: %s\n", buf);
+	  return -26;
+      }
+    if (!check_timestamps ("testdata/test.osm.pbf", 0, 8000 + 12336 + 1520))
+	return -27;
+    if (!check_timestamps
+	("testdata/test.osm.pbf", READOSM_LAZY_TIMESTAMPS,
+	 8000 + 12336 + 1520))
+	return -28;
+    if (!check_timestamps ("testdata/test.osm", 0, count))
+	return -29;
+    if (!check_timestamps ("testdata/test.osm", READOSM_LAZY_TIMESTAMPS, count))
+	return -30;
+
+/* 
+ / the same data, encoded with granularity=50, lat/lon offsets
+ / and date_granularity=500 instead of the default values
+*/
+    if (!check_coords ("testdata/test.osm.pbf", &check1))
+	return -31;
+    if (!check_coords ("testdata/test-granularity.osm.pbf", &check2))
+	return -32;
+    if (check1.count != 8000 + 12336 + 1520 || check1.count != check2.count
+	|| check1.lat_sum != check2.lat_sum
+	|| check1.lon_sum != check2.lon_sum
+	|| check1.timestamp_sum != check2.timestamp_sum)
+      {
+	  fprintf (stderr, "unexpected granularity results\n");
+	  return -33;
+      }
+    if (!check_coords ("testdata/test.osm", &check1))
+	return -34;
+
+/* arrays of objects */
+    if (!check_batches ("testdata/test.osm.pbf"))
+	return -35;
+    if (!check_batches ("testdata/test.osm"))
+	return -36;
+
+/* columns of Nodes */
+    if (!check_columns ("testdata/test.osm.pbf"))
+	return -37;
+    if (!check_columns ("testdata/test-granularity.osm.pbf"))
+	return -38;
+    if (!check_columns ("testdata/test.osm"))
+	return -39;
+
     return 0;
 }
@@ -0,0 +1,452 @@
+/* 
+/ check_varint.c
+/
+/ Test cases for the bulk packed varint decoders
+/
+/ Author: the ReadOSM contributors, 2026
+/
+/ ------------------------------------------------------------------------------
+/ 
+/ Version: MPL 1.1/GPL 2.0/LGPL 2.1
+/ 
+/ The contents of this file are subject to the Mozilla Public License Version
+/ 1.1 (the "License"); you may not use this file except in compliance with
+/ the License. You may obtain a copy of the License at
+/ http://www.mozilla.org/MPL/
+/ 
+/ Software distributed under the License is distributed on an "AS IS" basis,
+/ WITHOUT WARRANTY OF ANY KIND, either express or implied. See the License
+/ for the specific language governing rights and limitations under the
+/ License.
+/
+/ The Original Code is the ReadOSM library
+/
+/ The Initial Developer of the Original Code is Alessandro Furieri
+/ 
+/ Portions created by the Initial Developer are Copyright (C) 2012-2017
+/ the Initial Developer. All Rights Reserved.
+/ 
+/ Contributor(s):
+/ 
+/ Alternatively, the contents of this file may be used under the terms of
+/ either the GNU General Public License Version 2 or later (the "GPL"), or
+/ the GNU Lesser General Public License Version 2.1 or later (the "LGPL"),
+/ in which case the provisions of the GPL or the LGPL are applicable instead
+/ of those above. If you wish to allow use of your version of this file only
+/ under the terms of either the GPL or the LGPL, and not to allow others to
+/ use your version of this file under the terms of the MPL, indicate your
+/ decision by deleting the provisions above and replace them with the notice
+/ and other provisions required by the GPL or the LGPL. If you do not delete
+/ the provisions above, a recipient may use your version of this file under
+/ the terms of any one of the MPL, the GPL or the LGPL.
+/ 
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+
+#include "readosm.h"
+#include "readosm_varint.h"
+
+/*
+ * the bulk decoders (SIMD when available) are compared against
+ * the scalar decoders and against the values originally encoded,
+ * by using crafted packed arrays:
+ * - varints of any length between 1 and 10 bytes
+ * - negative SINT32 / SINT64 values and negative INT32 values
+ *   (always encoded on 10 bytes)
+ * - runs of single byte varints straddling the 16 bytes window
+ * - input truncated at any byte
+ *
+ * when built with -DREADOSM_NO_SIMD (check_varint_scalar) the very
+ * same tests are run against the scalar bulk decoders
+ */
+
+#define KIND_UINT32	1
+#define KIND_SINT32	2
+#define KIND_SINT64	3
+
+#define MAX_VALUES	512
+
+struct packed_array
+{
+    int kind;
+    int count;
+    int size;
+    unsigned long long raw[MAX_VALUES];	/* encoded (unsigned) values */
+    int ends[MAX_VALUES];	/* byte offset following each varint */
+    unsigned char bytes[MAX_VALUES * 10];
+};
+
+static unsigned long long
+next_random (unsigned long long *seed)
+{
+/* a simple xorshift64 generator (always the same sequence) */
+    unsigned long long x = *seed;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *seed = x;
+    return x;
+}
+
+static int
+max_length (int kind)
+{
+/* the longest varint allowed for each kind of array */
+    return (kind == KIND_SINT64) ? 10 : 5;
+}
+
+static unsigned long long
+raw_value (int kind, int len, unsigned long long *seed)
+{
+/* a random value requiring exactly LEN bytes once encoded */
+    unsigned long long v = next_random (seed);
+    if (len >= 10)
+	return v | 0x8000000000000000ULL;
+    v &= (1ULL << (7 * len)) - 1;
+    if (kind != KIND_SINT64)
+	v &= 0xffffffffULL;
+    if (len > 1)
+	v |= 1ULL << (7 * (len - 1));
+    return v;
+}
+
+static void
+append_value (struct packed_array *arr, unsigned long long value)
+{
+/* encoding a varint at the end of the packed array */
+    unsigned long long v = value;
+    if (arr->count >= MAX_VALUES)
+	return;
+    while (v >= 0x80)
+      {
+	  arr->bytes[arr->size++] = (unsigned char) (v | 0x80);
+	  v >>= 7;
+      }
+    arr->bytes[arr->size++] = (unsigned char) v;
+    arr->raw[arr->count] = value;
+    arr->ends[arr->count] = arr->size;
+    arr->count++;
+}
+
+static void
+append_length (struct packed_array *arr, int len, unsigned long long *seed)
+{
+/* appending a random value of the given encoded length */
+    append_value (arr, raw_value (arr->kind, len, seed));
+}
+
+static void
+append_negative_int32 (struct packed_array *arr, unsigned long long *seed)
+{
+/* appending a negative INT32 (sign extended to 64 bits, i.e. 10 bytes) */
+    int v = (int) (next_random (seed) & 0x7fffffff);
+    append_value (arr, (unsigned long long) (long long) (-v - 1));
+}
+
+static void
+append_random (struct packed_array *arr, unsigned long long *seed)
+{
+/* appending a value of random length, mostly short ones */
+    int r = (int) (next_random (seed) % 8);
+    if (r < 4)
+	append_length (arr, 1, seed);
+    else if (r < 6)
+	append_length (arr, 2, seed);
+    else if (r == 6 && arr->kind == KIND_UINT32)
+	append_negative_int32 (arr, seed);
+    else
+	append_length (arr, 1 +
+		       (int) (next_random (seed) % max_length (arr->kind)),
+		       seed);
+}
+
+static unsigned int
+expected_uint32 (unsigned long long raw)
+{
+/* the expected UINT32 value */
+    return (unsigned int) raw;
+}
+
+static int
+expected_sint32 (unsigned long long raw)
+{
+/* the expected (ZigZag decoded) SINT32 value */
+    unsigned int u = (unsigned int) raw;
+    if (u & 1)
+	return -(int) (u >> 1) - 1;
+    return (int) (u >> 1);
+}
+
+static long long
+expected_sint64 (unsigned long long raw)
+{
+/* the expected (ZigZag decoded) SINT64 value */
+    if (raw & 1)
+	return -(long long) (raw >> 1) - 1;
+    return (long long) (raw >> 1);
+}
+
+static int
+scalar_decode (int kind, unsigned char *start, unsigned char *stop,
+	       long long *values)
+{
+/* decoding a packed array by using the scalar decoders */
+    unsigned char *ptr = start;
+    int count = 0;
+    while (ptr <= stop)
+      {
+	  if (kind == KIND_UINT32)
+	    {
+		unsigned int v = 0;
+		ptr = read_varint32 (ptr, stop, &v);
+		values[count] = v;
+	    }
+	  else if (kind == KIND_SINT32)
+	    {
+		int v = 0;
+		ptr = read_svarint32 (ptr, stop, &v);
+		values[count] = v;
+	    }
+	  else
+	      ptr = read_svarint64 (ptr, stop, values + count);
+	  if (ptr == NULL)
+	      return -1;
+	  count++;
+      }
+    return count;
+}
+
+static int
+bulk_decode (int kind, unsigned char *start, unsigned char *stop,
+	     long long *values)
+{
+/* decoding a packed array by using the bulk decoders */
+    int i;
+    int count;
+    int n = (int) (stop - start + 1) + READOSM_PACKED_SLACK;
+    if (kind == KIND_SINT64)
+	return decode_packed_sint64 (start, stop, values);
+    if (kind == KIND_UINT32)
+      {
+	  unsigned int *v = malloc (sizeof (unsigned int) * n);
+	  count = decode_packed_uint32 (start, stop, v);
+	  for (i = 0; i < count; i++)
+	      values[i] = v[i];
+	  free (v);
+      }
+    else
+      {
+	  int *v = malloc (sizeof (int) * n);
+	  count = decode_packed_sint32 (start, stop, v);
+	  for (i = 0; i < count; i++)
+	      values[i] = v[i];
+	  free (v);
+      }
+    return count;
+}
+
+static int
+check_prefix (const struct packed_array *arr, int size, const char *title)
+{
+/* 
+ / decoding the first SIZE bytes of a packed array: the decoded
+ / values are expected to match the encoded ones when SIZE falls
+ / on a varint boundary, otherwise an error is expected
+*/
+    unsigned char *buf;
+    long long *bulk;
+    long long *scalar;
+    int expected = -1;
+    int n_bulk;
+    int n_scalar;
+    int i;
+    int ok = 1;
+
+    for (i = 0; i < arr->count; i++)
+      {
+	  if (arr->ends[i] == size)
+	      expected = i + 1;
+      }
+    if (size == 0)
+	return 1;
+
+    /* an exact copy, so that any read past STOP can be detected */
+    buf = malloc (size);
+    memcpy (buf, arr->bytes, size);
+    bulk = malloc (sizeof (long long) * (size + READOSM_PACKED_SLACK));
+    scalar = malloc (sizeof (long long) * (size + READOSM_PACKED_SLACK));
+    n_bulk = bulk_decode (arr->kind, buf, buf + size - 1, bulk);
+    n_scalar = scalar_decode (arr->kind, buf, buf + size - 1, scalar);
+
+    if (n_bulk != expected || n_scalar != expected)
+      {
+	  fprintf (stderr,
+		   "%s (%d bytes): expected %d values, bulk %d, scalar %d\n",
+		   title, size, expected, n_bulk, n_scalar);
+	  ok = 0;
+      }
+    for (i = 0; ok && i < expected; i++)
+      {
+	  long long v;
+	  if (arr->kind == KIND_UINT32)
+	      v = expected_uint32 (arr->raw[i]);
+	  else if (arr->kind == KIND_SINT32)
+	      v = expected_sint32 (arr->raw[i]);
+	  else
+	      v = expected_sint64 (arr->raw[i]);
+	  if (bulk[i] != v || scalar[i] != v)
+	    {
+		fprintf (stderr,
+			 "%s (%d bytes): value #%d: expected %lld, bulk %lld, scalar %lld\n",
+			 title, size, i, v, bulk[i], scalar[i]);
+		ok = 0;
+	    }
+      }
+    free (buf);
+    free (bulk);
+    free (scalar);
+    return ok;
+}
+
+static int
+check_array (const struct packed_array *arr, const char *title)
+{
+/* checking a whole packed array, then all its truncated prefixes */
+    int size;
+    for (size = arr->size; size > 0; size--)
+      {
+	  if (!check_prefix (arr, size, title))
+	      return 0;
+      }
+    return 1;
+}
+
+static void
+reset_array (struct packed_array *arr, int kind)
+{
+/* resetting a packed array */
+    arr->kind = kind;
+    arr->count = 0;
+    arr->size = 0;
+}
+
+static int
+check_kind (int kind, const char *name)
+{
+/* running all tests for a given kind of packed array */
+    static struct packed_array arr;
+    unsigned long long seed = 0x9e3779b97f4a7c15ULL;
+    int len;
+    int k;
+    int i;
+    int n;
+
+/* each length alone, and long runs of the same length */
+    for (len = 1; len <= max_length (kind); len++)
+      {
+	  reset_array (&arr, kind);
+	  append_length (&arr, len, &seed);
+	  if (!check_array (&arr, name))
+	      return 0;
+	  reset_array (&arr, kind);
+	  for (i = 0; i < 40; i++)
+	      append_length (&arr, len, &seed);
+	  if (!check_array (&arr, name))
+	      return 0;
+      }
+
+/* boundary values */
+    reset_array (&arr, kind);
+    append_value (&arr, 0);
+    append_value (&arr, 1);
+    append_value (&arr, 0x7f);
+    append_value (&arr, 0x80);
+    append_value (&arr, 0x3fff);
+    append_value (&arr, 0x4000);
+    append_value (&arr, 0xfffffffeULL);
+    append_value (&arr, 0xffffffffULL);
+    if (kind == KIND_SINT64)
+      {
+	  append_value (&arr, 0xfffffffffffffffeULL);
+	  append_value (&arr, 0xffffffffffffffffULL);
+      }
+    if (kind == KIND_UINT32)
+	append_value (&arr, 0xffffffffffffffffULL);
+    for (i = 0; i < 20; i++)
+	append_value (&arr, 1);
+    if (!check_array (&arr, name))
+	return 0;
+
+/* a longer varint at any position within the 16 bytes window */
+    for (k = 0; k < 32; k++)
+      {
+	  for (len = 2; len <= max_length (kind) + 1; len++)
+	    {
+		reset_array (&arr, kind);
+		for (i = 0; i < k; i++)
+		    append_length (&arr, 1, &seed);
+		if (len > max_length (kind))
+		  {
+		      if (kind == KIND_UINT32)
+			  append_negative_int32 (&arr, &seed);
+		      else
+			  continue;
+		  }
+		else
+		    append_length (&arr, len, &seed);
+		for (i = 0; i < 24; i++)
+		    append_length (&arr, 1, &seed);
+		for (i = 0; i < 8; i++)
+		    append_length (&arr, 2, &seed);
+		for (i = 0; i < 16; i++)
+		    append_length (&arr, 1, &seed);
+		if (!check_array (&arr, name))
+		    return 0;
+	    }
+      }
+
+/* random mixes */
+    for (n = 0; n < 300; n++)
+      {
+	  int count = 1 + (int) (next_random (&seed) % 120);
+	  reset_array (&arr, kind);
+	  for (i = 0; i < count; i++)
+	      append_random (&arr, &seed);
+	  if (!check_array (&arr, name))
+	      return 0;
+      }
+
+/* a malformed varint (more than 10 bytes) */
+    reset_array (&arr, kind);
+    for (i = 0; i < 20; i++)
+	append_length (&arr, 1, &seed);
+    for (i = 0; i < 11; i++)
+	arr.bytes[arr.size++] = 0x80;
+    arr.bytes[arr.size++] = 0x01;
+    for (i = 0; i < 20; i++)
+	arr.bytes[arr.size++] = 0x01;
+    if (!check_prefix (&arr, arr.size, name))
+	return 0;
+    return 1;
+}
+
+int
+main (int argc, char *argv[])
+{
+    if (argc < 0 || argv == NULL)
+	argc = 0;		/* silencing stupid compiler warnings */
+
+    if (!check_kind (KIND_UINT32, "UINT32"))
+	return -1;
+    if (!check_kind (KIND_SINT32, "SINT32"))
+	return -2;
+    if (!check_kind (KIND_SINT64, "SINT64"))
+	return -3;
+    return 0;
+}
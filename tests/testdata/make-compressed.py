@@ -0,0 +1,158 @@
+#!/usr/bin/env python3
+#
+# make-compressed.py
+#
+# re-encodes every OSMData block of a zlib-compressed PBF file
+# by using a different Blob compression:
+#   raw  - no compression (Blob.raw)
+#   zstd - Blob.zstd_data, compression level 3
+#   lz4  - Blob.lz4_data, LZ4 block format (LZ4_compress_default)
+#
+# the OSMHeader block is copied unchanged; libzstd and liblz4 are
+# loaded via ctypes (their paths can be overridden by setting the
+# LIBZSTD and LIBLZ4 environment variables)
+#
+# test-zstd.osm.pbf and test-lz4.osm.pbf have been generated by
+# using libzstd 1.5.6 and liblz4 1.9.4:
+#
+#   python3 make-compressed.py noNodesPackedInfos.osm.pbf test-zstd.osm.pbf zstd
+#   python3 make-compressed.py noNodesPackedInfos.osm.pbf test-lz4.osm.pbf lz4
+#
+
+import ctypes
+import ctypes.util
+import os
+import struct
+import sys
+import zlib
+
+
+def load_library(name):
+    path = os.environ.get('LIB' + name.upper()) or \
+        ctypes.util.find_library(name)
+    if path is None:
+        sys.exit('unable to find lib%s' % name)
+    return ctypes.CDLL(path)
+
+
+def read_varint(buf, i):
+    value = 0
+    shift = 0
+    while True:
+        c = buf[i]
+        i += 1
+        value |= (c & 0x7f) << shift
+        shift += 7
+        if not c & 0x80:
+            return value, i
+
+
+def write_varint(value):
+    out = bytearray()
+    while True:
+        c = value & 0x7f
+        value >>= 7
+        if value:
+            out.append(c | 0x80)
+        else:
+            out.append(c)
+            return bytes(out)
+
+
+def read_fields(buf):
+    # only varint and length-delimited fields are used by OSM PBF
+    i = 0
+    res = []
+    while i < len(buf):
+        tag, i = read_varint(buf, i)
+        fid, wire_type = tag >> 3, tag & 7
+        if wire_type == 0:
+            value, i = read_varint(buf, i)
+        elif wire_type == 2:
+            length, i = read_varint(buf, i)
+            value = buf[i:i + length]
+            i += length
+        else:
+            raise ValueError('unexpected wire type %d' % wire_type)
+        res.append((fid, wire_type, value))
+    return res
+
+
+def write_field(fid, wire_type, value):
+    if wire_type == 0:
+        return write_varint(fid << 3) + write_varint(value)
+    return write_varint(fid << 3 | 2) + write_varint(len(value)) + value
+
+
+def compress_zstd(raw):
+    lib = load_library('zstd')
+    lib.ZSTD_compressBound.restype = ctypes.c_size_t
+    lib.ZSTD_compressBound.argtypes = [ctypes.c_size_t]
+    lib.ZSTD_compress.restype = ctypes.c_size_t
+    lib.ZSTD_compress.argtypes = [ctypes.c_char_p, ctypes.c_size_t,
+                                  ctypes.c_char_p, ctypes.c_size_t,
+                                  ctypes.c_int]
+    lib.ZSTD_isError.argtypes = [ctypes.c_size_t]
+    capacity = lib.ZSTD_compressBound(len(raw))
+    buf = ctypes.create_string_buffer(capacity)
+    size = lib.ZSTD_compress(buf, capacity, raw, len(raw), 3)
+    if lib.ZSTD_isError(size):
+        sys.exit('ZSTD_compress failed')
+    return 7, buf.raw[:size]
+
+
+def compress_lz4(raw):
+    lib = load_library('lz4')
+    lib.LZ4_compressBound.restype = ctypes.c_int
+    lib.LZ4_compressBound.argtypes = [ctypes.c_int]
+    lib.LZ4_compress_default.restype = ctypes.c_int
+    lib.LZ4_compress_default.argtypes = [ctypes.c_char_p, ctypes.c_char_p,
+                                         ctypes.c_int, ctypes.c_int]
+    capacity = lib.LZ4_compressBound(len(raw))
+    buf = ctypes.create_string_buffer(capacity)
+    size = lib.LZ4_compress_default(raw, buf, len(raw), capacity)
+    if size <= 0:
+        sys.exit('LZ4_compress_default failed')
+    return 6, buf.raw[:size]
+
+
+def compress(kind, raw):
+    # returning the Blob field ID and the compressed payload
+    if kind == 'raw':
+        return 1, raw
+    if kind == 'zstd':
+        return compress_zstd(raw)
+    return compress_lz4(raw)
+
+
+def main(src, dst, kind):
+    data = open(src, 'rb').read()
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        header_size = struct.unpack('>I', data[i:i + 4])[0]
+        i += 4
+        header = read_fields(data[i:i + header_size])
+        i += header_size
+        blob_type = [v for f, w, v in header if f == 1][0]
+        blob_size = [v for f, w, v in header if f == 3][0]
+        blob = data[i:i + blob_size]
+        i += blob_size
+        if blob_type == b'OSMData':
+            zipped = [v for f, w, v in read_fields(blob) if f == 3][0]
+            raw = zlib.decompress(zipped)
+            fid, payload = compress(kind, raw)
+            blob = write_field(fid, 2, payload)
+            if fid != 1:
+                blob = write_field(2, 0, len(raw)) + blob
+        header = b''.join(write_field(f, w, len(blob) if f == 3 else v)
+                          for f, w, v in header)
+        out += struct.pack('>I', len(header)) + header + blob
+    open(dst, 'wb').write(out)
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 4 or sys.argv[3] not in ('raw', 'zstd', 'lz4'):
+        sys.exit('usage: make-compressed.py input.osm.pbf output.osm.pbf '
+                 'raw|zstd|lz4')
+    main(sys.argv[1], sys.argv[2], sys.argv[3])
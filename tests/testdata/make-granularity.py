@@ -0,0 +1,207 @@
+#!/usr/bin/env python3
+#
+# make-granularity.py
+#
+# re-encodes a PBF file using non-default PrimitiveBlock parameters:
+#   granularity      = 50 (nanodegrees)
+#   lat_offset       = 1000000000 (nanodegrees)
+#   lon_offset       = -2000000000 (nanodegrees)
+#   date_granularity = 500 (milliseconds)
+#
+# the decoded coordinates and timestamps are exactly the same as
+# in the input file, which must use the default parameters and
+# DenseNodes only (no plain Nodes)
+#
+# test-granularity.osm.pbf has been generated by:
+#
+#   python3 make-granularity.py test.osm.pbf test-granularity.osm.pbf
+#
+
+import struct
+import sys
+import zlib
+
+GRANULARITY = 50
+DATE_GRANULARITY = 500
+LAT_OFFSET = 1000000000
+LON_OFFSET = -2000000000
+
+
+def read_varint(buf, i):
+    value = 0
+    shift = 0
+    while True:
+        c = buf[i]
+        i += 1
+        value |= (c & 0x7f) << shift
+        shift += 7
+        if not c & 0x80:
+            return value, i
+
+
+def write_varint(value):
+    if value < 0:
+        value += 1 << 64
+    out = bytearray()
+    while True:
+        c = value & 0x7f
+        value >>= 7
+        if value:
+            out.append(c | 0x80)
+        else:
+            out.append(c)
+            return bytes(out)
+
+
+def read_fields(buf):
+    # only varint and length-delimited fields are used by OSM PBF
+    i = 0
+    res = []
+    while i < len(buf):
+        tag, i = read_varint(buf, i)
+        fid, wire_type = tag >> 3, tag & 7
+        if wire_type == 0:
+            value, i = read_varint(buf, i)
+        elif wire_type == 2:
+            length, i = read_varint(buf, i)
+            value = buf[i:i + length]
+            i += length
+        else:
+            raise ValueError('unexpected wire type %d' % wire_type)
+        res.append((fid, wire_type, value))
+    return res
+
+
+def write_field(fid, wire_type, value):
+    if wire_type == 0:
+        return write_varint(fid << 3) + write_varint(value)
+    return write_varint(fid << 3 | 2) + write_varint(len(value)) + value
+
+
+def write_fields(fields):
+    return b''.join(write_field(*f) for f in fields)
+
+
+def read_packed_sint64(buf):
+    i = 0
+    res = []
+    while i < len(buf):
+        value, i = read_varint(buf, i)
+        res.append((value >> 1) ^ -(value & 1))
+    return res
+
+
+def write_packed_sint64(values):
+    return b''.join(write_varint((v << 1) ^ (v >> 63)) for v in values)
+
+
+def coordinates(buf, offset):
+    # delta-encoded 100 nanodegrees -> delta-encoded GRANULARITY units
+    res = []
+    prev_in = 0
+    prev_out = 0
+    for delta in read_packed_sint64(buf):
+        prev_in += delta
+        nano = prev_in * 100 - offset
+        assert nano % GRANULARITY == 0
+        value = nano // GRANULARITY
+        res.append(value - prev_out)
+        prev_out = value
+    return write_packed_sint64(res)
+
+
+def dense_info(buf):
+    # DenseInfo: timestamps (field 2) are delta-encoded
+    factor = 1000 // DATE_GRANULARITY
+    res = []
+    for fid, wire_type, value in read_fields(buf):
+        if fid == 2:
+            value = write_packed_sint64(
+                [d * factor for d in read_packed_sint64(value)])
+        res.append((fid, wire_type, value))
+    return write_fields(res)
+
+
+def info(buf):
+    # Info: timestamp is field 2
+    factor = 1000 // DATE_GRANULARITY
+    res = []
+    for fid, wire_type, value in read_fields(buf):
+        if fid == 2:
+            value = value * factor
+        res.append((fid, wire_type, value))
+    return write_fields(res)
+
+
+def dense_nodes(buf):
+    res = []
+    for fid, wire_type, value in read_fields(buf):
+        if fid == 5:
+            value = dense_info(value)
+        elif fid == 8:
+            value = coordinates(value, LAT_OFFSET)
+        elif fid == 9:
+            value = coordinates(value, LON_OFFSET)
+        res.append((fid, wire_type, value))
+    return write_fields(res)
+
+
+def way_or_relation(buf):
+    return write_fields([(fid, wire_type, info(value) if fid == 4 else value)
+                         for fid, wire_type, value in read_fields(buf)])
+
+
+def primitive_group(buf):
+    res = []
+    for fid, wire_type, value in read_fields(buf):
+        if fid == 1:
+            raise ValueError('plain Nodes are not supported')
+        if fid == 2:
+            value = dense_nodes(value)
+        elif fid in (3, 4):
+            value = way_or_relation(value)
+        res.append((fid, wire_type, value))
+    return write_fields(res)
+
+
+def primitive_block(buf):
+    res = []
+    for fid, wire_type, value in read_fields(buf):
+        if fid in (17, 18, 19, 20):
+            continue
+        if fid == 2:
+            value = primitive_group(value)
+        res.append((fid, wire_type, value))
+    res += [(17, 0, GRANULARITY), (18, 0, DATE_GRANULARITY),
+            (19, 0, LAT_OFFSET), (20, 0, LON_OFFSET)]
+    return write_fields(res)
+
+
+def main(src, dst):
+    data = open(src, 'rb').read()
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        header_size = struct.unpack('>I', data[i:i + 4])[0]
+        i += 4
+        header = read_fields(data[i:i + header_size])
+        i += header_size
+        blob_type = [v for f, w, v in header if f == 1][0]
+        blob_size = [v for f, w, v in header if f == 3][0]
+        blob = data[i:i + blob_size]
+        i += blob_size
+        if blob_type == b'OSMData':
+            zipped = [v for f, w, v in read_fields(blob) if f == 3][0]
+            raw = primitive_block(zlib.decompress(zipped))
+            blob = (write_field(2, 0, len(raw)) +
+                    write_field(3, 2, zlib.compress(raw, 9)))
+        header = write_fields([(f, w, len(blob) if f == 3 else v)
+                               for f, w, v in header])
+        out += struct.pack('>I', len(header)) + header + blob
+    open(dst, 'wb').write(out)
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        sys.exit('usage: make-granularity.py input.osm.pbf output.osm.pbf')
+    main(sys.argv[1], sys.argv[2])
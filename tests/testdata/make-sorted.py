@@ -0,0 +1,234 @@
+#!/usr/bin/env python3
+#
+# make-sorted.py
+#
+# re-encodes a PBF file as a Type_then_ID sorted one:
+# - the HeaderBlock declares the "Sort.Type_then_ID" optional feature
+# - every OSMData block holds a single object type, NODEs first,
+#   then WAYs and finally RELATIONs
+# - objects are split into many small blocks, so that tests can
+#   corrupt some leading or trailing blocks and still expect a
+#   successful parse when those blocks are never needed
+#
+# the input file must contain DenseNodes only (no plain Nodes) and
+# no DenseInfo; each new block keeps the StringTable of the block its
+# objects come from
+#
+# test-sorted.osm.pbf has been generated by:
+#
+#   python3 make-sorted.py noNodesPackedInfos.osm.pbf test-sorted.osm.pbf
+#
+
+import struct
+import sys
+import zlib
+
+NODES_PER_BLOCK = 1000
+WAYS_PER_BLOCK = 150
+RELATIONS_PER_BLOCK = 2
+
+
+def read_varint(buf, i):
+    value = 0
+    shift = 0
+    while True:
+        c = buf[i]
+        i += 1
+        value |= (c & 0x7f) << shift
+        shift += 7
+        if not c & 0x80:
+            return value, i
+
+
+def write_varint(value):
+    if value < 0:
+        value += 1 << 64
+    out = bytearray()
+    while True:
+        c = value & 0x7f
+        value >>= 7
+        if value:
+            out.append(c | 0x80)
+        else:
+            out.append(c)
+            return bytes(out)
+
+
+def read_fields(buf):
+    # only varint and length-delimited fields are used by OSM PBF
+    i = 0
+    res = []
+    while i < len(buf):
+        tag, i = read_varint(buf, i)
+        fid, wire_type = tag >> 3, tag & 7
+        if wire_type == 0:
+            value, i = read_varint(buf, i)
+        elif wire_type == 2:
+            length, i = read_varint(buf, i)
+            value = buf[i:i + length]
+            i += length
+        else:
+            raise ValueError('unexpected wire type %d' % wire_type)
+        res.append((fid, wire_type, value))
+    return res
+
+
+def write_field(fid, wire_type, value):
+    if wire_type == 0:
+        return write_varint(fid << 3) + write_varint(value)
+    return write_varint(fid << 3 | 2) + write_varint(len(value)) + value
+
+
+def write_fields(fields):
+    return b''.join(write_field(*f) for f in fields)
+
+
+def read_packed(buf):
+    i = 0
+    res = []
+    while i < len(buf):
+        value, i = read_varint(buf, i)
+        res.append(value)
+    return res
+
+
+def write_packed(values):
+    return b''.join(write_varint(v) for v in values)
+
+
+def read_packed_sint64_deltas(buf):
+    # delta-encoded sint64 -> absolute values
+    res = []
+    prev = 0
+    for value in read_packed(buf):
+        prev += (value >> 1) ^ -(value & 1)
+        res.append(prev)
+    return res
+
+
+def write_packed_sint64_deltas(values):
+    res = []
+    prev = 0
+    for value in values:
+        delta = value - prev
+        res.append((delta << 1) ^ (delta >> 63))
+        prev = value
+    return write_packed(res)
+
+
+def dense_nodes(buf):
+    # DenseNodes -> list of (id, lat, lon, keys_vals)
+    ids = lats = lons = []
+    keys_vals = []
+    for fid, wire_type, value in read_fields(buf):
+        if fid == 1:
+            ids = read_packed_sint64_deltas(value)
+        elif fid == 5:
+            raise ValueError('DenseInfo is not supported')
+        elif fid == 8:
+            lats = read_packed_sint64_deltas(value)
+        elif fid == 9:
+            lons = read_packed_sint64_deltas(value)
+        elif fid == 10:
+            keys_vals = read_packed(value)
+    tags = []
+    pos = 0
+    for _ in ids:
+        end = pos
+        while end < len(keys_vals) and keys_vals[end] != 0:
+            end += 2
+        tags.append(keys_vals[pos:end])
+        pos = end + 1
+    return list(zip(ids, lats, lons, tags))
+
+
+def write_dense_nodes(nodes):
+    keys_vals = []
+    for node in nodes:
+        keys_vals += node[3] + [0]
+    return write_fields([
+        (1, 2, write_packed_sint64_deltas([n[0] for n in nodes])),
+        (8, 2, write_packed_sint64_deltas([n[1] for n in nodes])),
+        (9, 2, write_packed_sint64_deltas([n[2] for n in nodes])),
+        (10, 2, write_packed(keys_vals))])
+
+
+def read_primitive_block(buf, objects):
+    # collecting the objects of a block, by type
+    block_fields = []
+    found = {1: [], 2: [], 3: []}
+    for fid, wire_type, value in read_fields(buf):
+        if fid != 2:
+            block_fields.append((fid, wire_type, value))
+            continue
+        for gid, gwt, gvalue in read_fields(value):
+            if gid == 1:
+                raise ValueError('plain Nodes are not supported')
+            if gid == 2:
+                found[1] += dense_nodes(gvalue)
+            elif gid == 3:
+                found[2].append(gvalue)
+            elif gid == 4:
+                found[3].append(gvalue)
+    for kind in found:
+        if found[kind]:
+            objects[kind].append((block_fields, found[kind]))
+
+
+def write_primitive_blocks(kind, sources, per_block):
+    # splitting the objects of the given type into many small blocks
+    res = []
+    for block_fields, items in sources:
+        for i in range(0, len(items), per_block):
+            chunk = items[i:i + per_block]
+            if kind == 1:
+                group = write_field(2, 2, write_dense_nodes(chunk))
+            else:
+                group = b''.join(write_field(kind + 1, 2, v) for v in chunk)
+            raw = write_fields([f for f in block_fields if f[0] == 1] +
+                               [(2, 2, group)] +
+                               [f for f in block_fields if f[0] != 1])
+            res.append(raw)
+    return res
+
+
+def write_blob(blob_type, raw):
+    blob = (write_field(2, 0, len(raw)) +
+            write_field(3, 2, zlib.compress(raw, 9)))
+    header = write_fields([(1, 2, blob_type), (3, 0, len(blob))])
+    return struct.pack('>I', len(header)) + header + blob
+
+
+def main(src, dst):
+    data = open(src, 'rb').read()
+    objects = {1: [], 2: [], 3: []}
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        header_size = struct.unpack('>I', data[i:i + 4])[0]
+        i += 4
+        header = read_fields(data[i:i + header_size])
+        i += header_size
+        blob_type = [v for f, w, v in header if f == 1][0]
+        blob_size = [v for f, w, v in header if f == 3][0]
+        blob = read_fields(data[i:i + blob_size])
+        i += blob_size
+        zipped = [v for f, w, v in blob if f == 3]
+        raw = zlib.decompress(zipped[0]) if zipped else \
+            [v for f, w, v in blob if f == 1][0]
+        if blob_type == b'OSMHeader':
+            raw += write_field(5, 2, b'Sort.Type_then_ID')
+            out += write_blob(blob_type, raw)
+        else:
+            read_primitive_block(raw, objects)
+    for kind, per_block in ((1, NODES_PER_BLOCK), (2, WAYS_PER_BLOCK),
+                            (3, RELATIONS_PER_BLOCK)):
+        for raw in write_primitive_blocks(kind, objects[kind], per_block):
+            out += write_blob(b'OSMData', raw)
+    open(dst, 'wb').write(out)
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 3:
+        sys.exit('usage: make-sorted.py input.osm.pbf output.osm.pbf')
+    main(sys.argv[1], sys.argv[2])